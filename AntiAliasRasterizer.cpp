@@ -0,0 +1,309 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "AntiAliasRasterizer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+AntiAliasRasterizer::AntiAliasRasterizer()
+{
+	this->m_run_x = 0;
+	this->m_run_count = 0;
+	this->m_run_full = false;
+	this->m_clip_left = 0;
+	this->m_clip_right = 0;
+}
+
+void AntiAliasRasterizer::fill_contours(const GContour contours[], int count, const GMatrix& ctm, const GIRect& clip, Blitter& blitter)
+{
+	// put all the contours into an edge list, every contour is treated as closed
+	this->m_edges.clear();
+	for (int i = 0; i < count; ++i)
+	{
+		if (contours[i].fCount < 3)
+		{
+			// need at least 3 points to cover anything
+			continue;
+		}
+		// map each point once, it is the end of one edge and the start of the next
+		int point_count = contours[i].fCount;
+		this->m_points.resize(point_count);
+		ctm.mapPoints(this->m_points.data(), contours[i].fPts, point_count);
+		for (int j = 0; j < point_count - 1; ++j)
+		{
+			this->add_edge(this->m_points[j], this->m_points[j + 1]);
+		}
+		// from last point to first point
+		this->add_edge(this->m_points[point_count - 1], this->m_points[0]);
+	}
+	if (this->m_edges.size() < 2)
+	{
+		// nothing to draw
+		return;
+	}
+
+	// sort them from top to bottom
+	std::sort(this->m_edges.begin(), this->m_edges.end(), [] (const Edge& a, const Edge& b)
+		{
+			return a.y_top < b.y_top;
+		}
+	);
+
+	// figure out which rows we could possibly touch
+	float y_bottom_max = this->m_edges[0].y_bottom;
+	for (const Edge& edge : this->m_edges)
+	{
+		y_bottom_max = std::max(y_bottom_max, edge.y_bottom);
+	}
+	// pinned to the clip while still floats, the edges are not clipped and may be far past any int
+	int y_start = GFloorToInt(std::max(this->m_edges[0].y_top, (float)clip.fTop));
+	int y_end = GCeilToInt(std::min(y_bottom_max, (float)clip.fBottom));
+	if (y_start >= y_end || clip.fLeft >= clip.fRight)
+	{
+		// entirely clipped out
+		return;
+	}
+
+	// make sure the row buffers cover the clip, with room for the right edge
+	this->m_clip_left = clip.fLeft;
+	this->m_clip_right = clip.fRight;
+	if ((int)this->m_delta.size() < clip.fRight + 1)
+	{
+		this->m_delta.resize(clip.fRight + 1, 0);
+		this->m_partial.resize(clip.fRight + 1, 0);
+		this->m_coverage.resize(clip.fRight + 1, 0);
+	}
+
+	// walk the rows
+	this->m_active.clear();
+	int next_edge_index = 0;
+	int edge_count = (int)this->m_edges.size();
+	for (int y = y_start; y < y_end; ++y)
+	{
+		// skip ahead over empty rows
+		if (this->m_active.size() == 0)
+		{
+			if (next_edge_index >= edge_count)
+			{
+				// out of edges
+				break;
+			}
+			// pinned first for the same reason, only a row past y and before y_end matters
+			float next_top = std::min(std::max(this->m_edges[next_edge_index].y_top, (float)y), (float)y_end);
+			int next_y = GFloorToInt(next_top);
+			if (next_y > y)
+			{
+				y = next_y;
+				if (y >= y_end)
+				{
+					break;
+				}
+			}
+		}
+
+		for (int sub = 0; sub < SUBSAMPLES; ++sub)
+		{
+			// sample in the middle of the sub-scanline
+			float sample_y = y + (sub + 0.5f) / SUBSAMPLES;
+
+			// bring in the edges that start above the sample
+			while (next_edge_index < edge_count && this->m_edges[next_edge_index].y_top <= sample_y)
+			{
+				this->m_active.push_back(&(this->m_edges[next_edge_index]));
+				++next_edge_index;
+			}
+
+			// drop the edges that are finished, and find where the rest cross the sample
+			this->m_crossings.clear();
+			int keep = 0;
+			for (int i = 0; i < (int)this->m_active.size(); ++i)
+			{
+				Edge* edge = this->m_active[i];
+				if (edge->y_bottom <= sample_y)
+				{
+					continue;
+				}
+				this->m_active[keep++] = edge;
+				Crossing crossing = { edge->x_top + (sample_y - edge->y_top) * edge->dxdy, edge->orientation };
+				this->m_crossings.push_back(crossing);
+			}
+			this->m_active.resize(keep);
+
+			// the crossings are nearly sorted from the last sample, so insertion sort them
+			for (int i = 1; i < (int)this->m_crossings.size(); ++i)
+			{
+				Crossing crossing = this->m_crossings[i];
+				int j = i - 1;
+				while (j >= 0 && this->m_crossings[j].x > crossing.x)
+				{
+					this->m_crossings[j + 1] = this->m_crossings[j];
+					--j;
+				}
+				this->m_crossings[j + 1] = crossing;
+			}
+
+			// turn the crossings into spans using the nonzero rule
+			int winding = 0;
+			float span_left = 0.0f;
+			for (const Crossing& crossing : this->m_crossings)
+			{
+				if (winding == 0)
+				{
+					span_left = crossing.x;
+				}
+				winding += crossing.orientation;
+				if (winding == 0)
+				{
+					this->accumulate_span(span_left, crossing.x);
+				}
+			}
+		}
+
+		// send the row off to be blended
+		if (this->m_touched.size() > 0)
+		{
+			this->flush_row(y, blitter);
+		}
+	}
+}
+
+void AntiAliasRasterizer::add_edge(const GPoint& p0, const GPoint& p1)
+{
+	if (p0.fY == p1.fY)
+	{
+		// horizontal edges never cross a sub-scanline
+		return;
+	}
+
+	Edge edge;
+	if (p0.fY < p1.fY)
+	{
+		edge.y_top = p0.fY;
+		edge.y_bottom = p1.fY;
+		edge.x_top = p0.fX;
+		edge.orientation = 1;
+	}
+	else
+	{
+		edge.y_top = p1.fY;
+		edge.y_bottom = p0.fY;
+		edge.x_top = p1.fX;
+		edge.orientation = -1;
+	}
+	edge.dxdy = (p1.fX - p0.fX) / (p1.fY - p0.fY);
+	this->m_edges.push_back(edge);
+}
+
+void AntiAliasRasterizer::accumulate_span(float x_left, float x_right)
+{
+	// only the part inside the clip counts
+	x_left = std::max(x_left, (float)this->m_clip_left);
+	x_right = std::min(x_right, (float)this->m_clip_right);
+	if (x_right <= x_left)
+	{
+		return;
+	}
+
+	int left = (int)x_left;
+	int right = (int)x_right;
+	if (left == right)
+	{
+		// the whole span is inside of one pixel
+		this->m_partial[left] += (int)((x_right - x_left) * SUBSAMPLE_COVERAGE + 0.5f);
+		this->m_touched.push_back(left);
+	}
+	else
+	{
+		// partial pixel on the left, a run of full pixels, and a partial pixel on the right
+		this->m_partial[left] += (int)((left + 1 - x_left) * SUBSAMPLE_COVERAGE + 0.5f);
+		this->m_delta[left + 1] += SUBSAMPLE_COVERAGE;
+		this->m_delta[right] -= SUBSAMPLE_COVERAGE;
+		this->m_partial[right] += (int)((x_right - right) * SUBSAMPLE_COVERAGE + 0.5f);
+		this->m_touched.push_back(left);
+		this->m_touched.push_back(left + 1);
+		this->m_touched.push_back(right);
+	}
+}
+
+void AntiAliasRasterizer::flush_row(int y, Blitter& blitter)
+{
+	// the touched pixels are the only places the coverage can change, so sort them
+	// and everything in between is one constant run
+	std::sort(this->m_touched.begin(), this->m_touched.end());
+
+	int run = 0;
+	int previous = -1;
+	for (int x : this->m_touched)
+	{
+		if (x == previous)
+		{
+			// already handled this one
+			continue;
+		}
+
+		// the constant run between the last touched pixel and this one
+		if (previous >= 0 && x > previous + 1)
+		{
+			this->emit(previous + 1, x - (previous + 1), std::min(255, run), y, blitter);
+		}
+
+		// this pixel has its own coverage
+		run += this->m_delta[x];
+		int coverage = std::min(255, run + this->m_partial[x]);
+		this->m_delta[x] = 0;
+		this->m_partial[x] = 0;
+		if (x < this->m_clip_right)
+		{
+			this->emit(x, 1, coverage, y, blitter);
+		}
+		previous = x;
+	}
+	this->m_touched.clear();
+
+	// send off whatever is left
+	this->flush_run(y, blitter);
+}
+
+void AntiAliasRasterizer::emit(int x, int count, int coverage, int y, Blitter& blitter)
+{
+	if (coverage == 0)
+	{
+		// nothing to draw here
+		this->flush_run(y, blitter);
+		return;
+	}
+
+	// full runs and partial runs each get batched up separately
+	bool full = (coverage == 255);
+	if (this->m_run_count > 0 && (this->m_run_full != full || this->m_run_x + this->m_run_count != x))
+	{
+		this->flush_run(y, blitter);
+	}
+	if (this->m_run_count == 0)
+	{
+		this->m_run_x = x;
+		this->m_run_full = full;
+	}
+	if (full == false)
+	{
+		std::memset(&(this->m_coverage[x]), coverage, count);
+	}
+	this->m_run_count += count;
+}
+
+void AntiAliasRasterizer::flush_run(int y, Blitter& blitter)
+{
+	if (this->m_run_count == 0)
+	{
+		return;
+	}
+	if (this->m_run_full == true)
+	{
+		blitter.blit_row(this->m_run_x, y, this->m_run_count);
+	}
+	else
+	{
+		blitter.blit_row_coverage(this->m_run_x, y, this->m_run_count, &(this->m_coverage[this->m_run_x]));
+	}
+	this->m_run_count = 0;
+}
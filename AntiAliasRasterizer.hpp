@@ -0,0 +1,84 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef AntiAliasRasterizer_hpp
+#define AntiAliasRasterizer_hpp
+
+#include "include/GContour.h"
+#include "include/GMatrix.h"
+#include "include/GPoint.h"
+#include "include/GRect.h"
+#include "Blitter.hpp"
+#include <vector>
+
+// fills contours (nonzero winding) with partial coverage along their edges
+// each pixel row is sampled on SUBSAMPLES sub-scanlines, and on each sub-scanline the
+// exact horizontal extent of the spans is accumulated, so the cost is close to the
+// aliased scan converter instead of rendering at a higher resolution
+class AntiAliasRasterizer
+{
+public:
+	AntiAliasRasterizer();
+
+	// scan convert the contours, mapped by the ctm, inside of clip and hand every
+	// touched row to the blitter
+	void fill_contours(const GContour contours[], int count, const GMatrix& ctm, const GIRect& clip, Blitter& blitter);
+
+private:
+	enum
+	{
+		SUBSAMPLE_SHIFT = 2,
+		SUBSAMPLES = 1 << SUBSAMPLE_SHIFT,
+
+		// the coverage one sub-scanline adds to a fully covered pixel
+		SUBSAMPLE_COVERAGE = 256 >> SUBSAMPLE_SHIFT,
+	};
+
+	// an edge kept in float device space, not snapped to scanlines
+	struct Edge
+	{
+		float y_top;
+		float y_bottom;
+		float x_top;
+		float dxdy;
+		int orientation;
+	};
+
+	// a crossing of the current sub-scanline
+	struct Crossing
+	{
+		float x;
+		int orientation;
+	};
+
+	void add_edge(const GPoint& p0, const GPoint& p1);
+	void accumulate_span(float x_left, float x_right);
+	void flush_row(int y, Blitter& blitter);
+	void emit(int x, int count, int coverage, int y, Blitter& blitter);
+	void flush_run(int y, Blitter& blitter);
+
+	// the points of the contour being added, mapped through the ctm
+	std::vector<GPoint> m_points;
+
+	// the edges of the current draw, sorted by y_top
+	std::vector<Edge> m_edges;
+	std::vector<Edge*> m_active;
+	std::vector<Crossing> m_crossings;
+
+	// per pixel coverage for the current row
+	// m_delta holds +/- steps for fully covered runs (summed across the row)
+	// and m_partial holds the fractional coverage at the ends of spans
+	// only the pixels in m_touched have anything in them, so only they get looked at
+	std::vector<int> m_delta;
+	std::vector<int> m_partial;
+	std::vector<int> m_touched;
+
+	// the run of pixels waiting to go to the blitter
+	std::vector<uint8_t> m_coverage;
+	int m_run_x;
+	int m_run_count;
+	bool m_run_full;
+	int m_clip_left;
+	int m_clip_right;
+};
+
+#endif
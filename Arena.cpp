@@ -0,0 +1,56 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "Arena.hpp"
+#include <cstdint>
+
+Arena::Arena(size_t block_size)
+{
+	this->m_block_size = block_size;
+	this->m_block = 0;
+	this->m_offset = 0;
+	this->m_bytes_used = 0;
+}
+
+Arena::~Arena()
+{
+	for (Block& block : this->m_blocks)
+	{
+		delete[] block.data;
+	}
+}
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+	while (this->m_block < this->m_blocks.size())
+	{
+		Block& block = this->m_blocks[this->m_block];
+		uintptr_t start = ((uintptr_t)(block.data + this->m_offset) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		size_t offset = start - (uintptr_t)block.data;
+		if (offset + size <= block.size)
+		{
+			this->m_offset = offset + size;
+			this->m_bytes_used += size;
+			return block.data + offset;
+		}
+
+		// does not fit, move on to the next block
+		++this->m_block;
+		this->m_offset = 0;
+	}
+
+	// out of blocks, make one big enough for this (with room to line it up)
+	Block block;
+	block.size = (size + alignment > this->m_block_size ? size + alignment : this->m_block_size);
+	block.data = new char[block.size];
+	this->m_blocks.push_back(block);
+	this->m_block = this->m_blocks.size() - 1;
+	this->m_offset = 0;
+	return this->allocate(size, alignment);
+}
+
+void Arena::reset()
+{
+	this->m_block = 0;
+	this->m_offset = 0;
+	this->m_bytes_used = 0;
+}
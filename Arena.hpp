@@ -0,0 +1,75 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef Arena_hpp
+#define Arena_hpp
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// hands out memory by bumping a pointer through big blocks, and frees it all at once
+// nothing allocated here has its destructor run, so it is only for plain old data
+class Arena
+{
+public:
+	Arena(size_t block_size = DEFAULT_BLOCK_SIZE);
+	~Arena();
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	// size bytes lined up to alignment (a power of two), good until reset()
+	void* allocate(size_t size, size_t alignment);
+
+	// a copy of value
+	template <typename T>
+	T* make(const T& value)
+	{
+		return new (this->allocate(sizeof(T), alignof(T))) T(value);
+	}
+
+	// room for count of T, left uninitialized
+	template <typename T>
+	T* make_array(int count)
+	{
+		return (T*)this->allocate(sizeof(T) * count, alignof(T));
+	}
+
+	// a copy of src[0, count)
+	template <typename T>
+	T* copy_array(const T src[], int count)
+	{
+		T* dst = (T*)this->allocate(sizeof(T) * count, alignof(T));
+		memcpy(dst, src, sizeof(T) * count);
+		return dst;
+	}
+
+	// forget everything allocated, the blocks are kept around to be used again
+	void reset();
+
+	// how much has been handed out since the last reset (not counting alignment padding)
+	size_t bytes_used() const { return this->m_bytes_used; }
+
+private:
+	enum
+	{
+		DEFAULT_BLOCK_SIZE = 64 * 1024,
+	};
+
+	struct Block
+	{
+		char* data;
+		size_t size;
+	};
+
+	size_t m_block_size;
+	std::vector<Block> m_blocks;
+
+	// the block being allocated from and how far into it we are
+	size_t m_block;
+	size_t m_offset;
+	size_t m_bytes_used;
+};
+
+#endif
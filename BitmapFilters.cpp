@@ -0,0 +1,354 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "BitmapFilters.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+	#define BITMAP_FILTERS_SSE2
+	#include <emmintrin.h>
+#endif
+
+// wrap or pin a pixel index into [0, size) the way the tile mode says to
+static inline int tile_index(int i, int size, GShader::TileMode tilemode)
+{
+	if (tilemode == GShader::kRepeat)
+	{
+		i %= size;
+		return (i < 0 ? i + size : i);
+	}
+	if (tilemode == GShader::kMirror)
+	{
+		int period = size * 2;
+		i %= period;
+		if (i < 0)
+		{
+			i += period;
+		}
+		return (i >= size ? period - 1 - i : i);
+	}
+	return std::max(0, std::min(i, size - 1));
+}
+
+static inline const GPixel* get_row(const GBitmap& bitmap, int y)
+{
+	return bitmap.pixels() + ((bitmap.rowBytes() >> 2) * y);
+}
+
+// pin a premultiplied pixel's colors to its alpha, the cubic can overshoot a little
+static inline GPixel pin_to_alpha(GPixel p)
+{
+	int a = GPixel_GetA(p);
+	return GPixel_PackARGB(a, std::min(GPixel_GetR(p), a), std::min(GPixel_GetG(p), a), std::min(GPixel_GetB(p), a));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// bilinear
+
+#ifdef BITMAP_FILTERS_SSE2
+
+static inline GPixel bilinear_pixel(GPixel p00, GPixel p01, GPixel p10, GPixel p11, int wx, int wy, int alpha_scale)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	// widen the 4 pixels to 16 bits a channel, the top row in one register and the bottom in the other
+	__m128i pixels = _mm_set_epi32(p11, p10, p01, p00);
+	__m128i top = _mm_unpacklo_epi8(pixels, zero);
+	__m128i bottom = _mm_unpackhi_epi8(pixels, zero);
+
+	// the weights add up to 256, so the sum of every channel fits in 16 bits
+	short w00 = (short)((16 - wx) * (16 - wy));
+	short w01 = (short)(wx * (16 - wy));
+	short w10 = (short)((16 - wx) * wy);
+	short w11 = (short)(wx * wy);
+	__m128i top_weights = _mm_set_epi16(w01, w01, w01, w01, w00, w00, w00, w00);
+	__m128i bottom_weights = _mm_set_epi16(w11, w11, w11, w11, w10, w10, w10, w10);
+
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(top, top_weights), _mm_mullo_epi16(bottom, bottom_weights));
+	sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+	sum = _mm_srli_epi16(sum, 8);
+	if (alpha_scale < 256)
+	{
+		sum = _mm_srli_epi16(_mm_mullo_epi16(sum, _mm_set1_epi16((short)alpha_scale)), 8);
+	}
+	return (GPixel)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+}
+
+#else
+
+static inline GPixel bilinear_pixel(GPixel p00, GPixel p01, GPixel p10, GPixel p11, int wx, int wy, int alpha_scale)
+{
+	uint32_t w00 = (16 - wx) * (16 - wy);
+	uint32_t w01 = wx * (16 - wy);
+	uint32_t w10 = (16 - wx) * wy;
+	uint32_t w11 = wx * wy;
+
+	// two channels at a time in 16 bit lanes, the weights add up to 256 so nothing carries
+	const uint32_t mask = 0x00FF00FF;
+	uint32_t even = (p00 & mask) * w00 + (p01 & mask) * w01 + (p10 & mask) * w10 + (p11 & mask) * w11;
+	uint32_t odd = ((p00 >> 8) & mask) * w00 + ((p01 >> 8) & mask) * w01 + ((p10 >> 8) & mask) * w10 + ((p11 >> 8) & mask) * w11;
+	even = (even >> 8) & mask;
+	odd = (odd >> 8) & mask;
+	if (alpha_scale < 256)
+	{
+		even = ((even * alpha_scale) >> 8) & mask;
+		odd = ((odd * alpha_scale) >> 8) & mask;
+	}
+	return even | (odd << 8);
+}
+
+#endif
+
+void bilinear_row(const GBitmap& bitmap, GShader::TileMode tilemode, int64_t x, int64_t y, int64_t dx, int64_t dy,
+	int alpha_scale, int count, GPixel row[])
+{
+	int width = bitmap.width();
+	int height = bitmap.height();
+	for (int i = 0; i < count; ++i)
+	{
+		// the top left of the 2x2 and how far past it the sample point is, in 16ths
+		int x0 = (int)(x >> 16);
+		int y0 = (int)(y >> 16);
+		int wx = (int)(x >> 12) & 15;
+		int wy = (int)(y >> 12) & 15;
+
+		int left = tile_index(x0, width, tilemode);
+		int right = tile_index(x0 + 1, width, tilemode);
+		const GPixel* top = get_row(bitmap, tile_index(y0, height, tilemode));
+		const GPixel* bottom = get_row(bitmap, tile_index(y0 + 1, height, tilemode));
+		row[i] = bilinear_pixel(top[left], top[right], bottom[left], bottom[right], wx, wy, alpha_scale);
+
+		x += dx;
+		y += dy;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// bicubic
+
+enum
+{
+	// sub-pixel phases, and what the 4 weights of each phase add up to
+	BICUBIC_PHASES = 64,
+	BICUBIC_ONE = 64,
+	BICUBIC_SHIFT = 6,
+};
+
+// the Mitchell-Netravali filter with B = C = 1/3 at distance d
+static float mitchell(float d)
+{
+	d = std::fabs(d);
+	if (d < 1.0f)
+	{
+		return (7.0f * d * d * d - 12.0f * d * d + 16.0f / 3.0f) / 6.0f;
+	}
+	if (d < 2.0f)
+	{
+		return (-7.0f / 3.0f * d * d * d + 12.0f * d * d - 20.0f * d + 32.0f / 3.0f) / 6.0f;
+	}
+	return 0.0f;
+}
+
+// the 4 weights for every phase, rounded so each set adds up to exactly BICUBIC_ONE
+struct BicubicWeights
+{
+	short w[BICUBIC_PHASES][4];
+
+	BicubicWeights()
+	{
+		for (int phase = 0; phase < BICUBIC_PHASES; ++phase)
+		{
+			float t = (float)phase / BICUBIC_PHASES;
+			float distances[4] = { 1.0f + t, t, 1.0f - t, 2.0f - t };
+			int sum = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				this->w[phase][i] = (short)std::floor(mitchell(distances[i]) * BICUBIC_ONE + 0.5f);
+				sum += this->w[phase][i];
+			}
+
+			// put any rounding error on the biggest of the middle two
+			int middle = (this->w[phase][1] >= this->w[phase][2] ? 1 : 2);
+			this->w[phase][middle] += (short)(BICUBIC_ONE - sum);
+		}
+	}
+};
+
+static const short* bicubic_weights(int phase)
+{
+	static const BicubicWeights weights;
+	return weights.w[phase];
+}
+
+#ifdef BITMAP_FILTERS_SSE2
+
+// one row of the 4x4 filtered horizontally, the 4 channels end up in the low 4 lanes
+// every partial sum stays well inside of 16 bits (the weights are at most 6 bits)
+static inline __m128i bicubic_filter_row(const GPixel* row, const int xs[4], __m128i weights01, __m128i weights23)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i pixels;
+	if (xs[3] == xs[0] + 3)
+	{
+		// all 4 are next to each other (the usual case away from the edges)
+		pixels = _mm_loadu_si128((const __m128i*)(row + xs[0]));
+	}
+	else
+	{
+		pixels = _mm_set_epi32(row[xs[3]], row[xs[2]], row[xs[1]], row[xs[0]]);
+	}
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), weights01),
+		_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), weights23));
+	sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+	return _mm_srai_epi16(_mm_add_epi16(sum, _mm_set1_epi16(BICUBIC_ONE / 2)), BICUBIC_SHIFT);
+}
+
+static inline GPixel bicubic_pixel(const GPixel* rows[4], const int xs[4], const short* wx, const short* wy, int alpha_scale)
+{
+	__m128i wx01 = _mm_set_epi16(wx[1], wx[1], wx[1], wx[1], wx[0], wx[0], wx[0], wx[0]);
+	__m128i wx23 = _mm_set_epi16(wx[3], wx[3], wx[3], wx[3], wx[2], wx[2], wx[2], wx[2]);
+	__m128i h0 = bicubic_filter_row(rows[0], xs, wx01, wx23);
+	__m128i h1 = bicubic_filter_row(rows[1], xs, wx01, wx23);
+	__m128i h2 = bicubic_filter_row(rows[2], xs, wx01, wx23);
+	__m128i h3 = bicubic_filter_row(rows[3], xs, wx01, wx23);
+
+	// then down the columns the same way
+	__m128i wy01 = _mm_set_epi16(wy[1], wy[1], wy[1], wy[1], wy[0], wy[0], wy[0], wy[0]);
+	__m128i wy23 = _mm_set_epi16(wy[3], wy[3], wy[3], wy[3], wy[2], wy[2], wy[2], wy[2]);
+	__m128i sum = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi64(h0, h1), wy01),
+		_mm_mullo_epi16(_mm_unpacklo_epi64(h2, h3), wy23));
+	sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+	sum = _mm_srai_epi16(_mm_add_epi16(sum, _mm_set1_epi16(BICUBIC_ONE / 2)), BICUBIC_SHIFT);
+
+	// pin to [0, 255] and scale by the alpha
+	sum = _mm_min_epi16(_mm_max_epi16(sum, _mm_setzero_si128()), _mm_set1_epi16(255));
+	if (alpha_scale < 256)
+	{
+		sum = _mm_srli_epi16(_mm_mullo_epi16(sum, _mm_set1_epi16((short)alpha_scale)), 8);
+	}
+	return pin_to_alpha((GPixel)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+}
+
+#else
+
+static inline GPixel bicubic_pixel(const GPixel* rows[4], const int xs[4], const short* wx, const short* wy, int alpha_scale)
+{
+	GPixel result = 0;
+	for (int shift = 0; shift < 32; shift += 8)
+	{
+		// across each row, then down the column, rounding after each the same as the sse2 version
+		int sum = 0;
+		for (int j = 0; j < 4; ++j)
+		{
+			int row_sum = 0;
+			for (int i = 0; i < 4; ++i)
+			{
+				row_sum += (int)((rows[j][xs[i]] >> shift) & 0xFF) * wx[i];
+			}
+			sum += ((row_sum + BICUBIC_ONE / 2) >> BICUBIC_SHIFT) * wy[j];
+		}
+		int value = std::max(0, std::min((sum + BICUBIC_ONE / 2) >> BICUBIC_SHIFT, 255));
+		if (alpha_scale < 256)
+		{
+			value = (value * alpha_scale) >> 8;
+		}
+		result |= (GPixel)value << shift;
+	}
+	return pin_to_alpha(result);
+}
+
+#endif
+
+void bicubic_row(const GBitmap& bitmap, GShader::TileMode tilemode, int64_t x, int64_t y, int64_t dx, int64_t dy,
+	int alpha_scale, int count, GPixel row[])
+{
+	int width = bitmap.width();
+	int height = bitmap.height();
+	for (int i = 0; i < count; ++i)
+	{
+		// the pixel left of and above the sample point, and the phase into it
+		int x0 = (int)(x >> 16);
+		int y0 = (int)(y >> 16);
+		const short* wx = bicubic_weights((int)(x >> (16 - BICUBIC_SHIFT)) & (BICUBIC_PHASES - 1));
+		const short* wy = bicubic_weights((int)(y >> (16 - BICUBIC_SHIFT)) & (BICUBIC_PHASES - 1));
+
+		int xs[4];
+		const GPixel* rows[4];
+		for (int k = 0; k < 4; ++k)
+		{
+			xs[k] = tile_index(x0 - 1 + k, width, tilemode);
+			rows[k] = get_row(bitmap, tile_index(y0 - 1 + k, height, tilemode));
+		}
+		row[i] = bicubic_pixel(rows, xs, wx, wy, alpha_scale);
+
+		x += dx;
+		y += dy;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// mip levels
+
+// the rounded average of 4 pixels, one channel at a time
+static inline GPixel average_4(GPixel a, GPixel b, GPixel c, GPixel d)
+{
+	const uint32_t mask = 0x00FF00FF;
+	uint32_t even = (a & mask) + (b & mask) + (c & mask) + (d & mask) + 0x00020002;
+	uint32_t odd = ((a >> 8) & mask) + ((b >> 8) & mask) + ((c >> 8) & mask) + ((d >> 8) & mask) + 0x00020002;
+	return ((even >> 2) & mask) | (((odd >> 2) & mask) << 8);
+}
+
+void downsample_2x2(const GBitmap& src, const GBitmap& dst)
+{
+	for (int y = 0; y < dst.height(); ++y)
+	{
+		const GPixel* top = get_row(src, y * 2);
+		const GPixel* bottom = get_row(src, std::min(y * 2 + 1, src.height() - 1));
+		GPixel* out = dst.pixels() + ((dst.rowBytes() >> 2) * y);
+
+		// the pairs that are all there, then the odd one at the end
+		int pairs = src.width() / 2;
+		int x = 0;
+		#ifdef BITMAP_FILTERS_SSE2
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i two = _mm_set1_epi16(2);
+			for (; x + 2 <= pairs; x += 2)
+			{
+				// 4 pixels from each row make 2 output pixels
+				__m128i t = _mm_loadu_si128((const __m128i*)(top + x * 2));
+				__m128i b = _mm_loadu_si128((const __m128i*)(bottom + x * 2));
+				__m128i left = _mm_add_epi16(_mm_unpacklo_epi8(t, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i right = _mm_add_epi16(_mm_unpackhi_epi8(t, zero), _mm_unpackhi_epi8(b, zero));
+
+				// add the neighbors within each half, then line the two sums up side by side
+				left = _mm_add_epi16(left, _mm_srli_si128(left, 8));
+				right = _mm_add_epi16(right, _mm_srli_si128(right, 8));
+				__m128i sum = _mm_unpacklo_epi64(left, right);
+				sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+				_mm_storel_epi64((__m128i*)(out + x), _mm_packus_epi16(sum, sum));
+			}
+		#endif
+		for (; x < pairs; ++x)
+		{
+			out[x] = average_4(top[x * 2], top[x * 2 + 1], bottom[x * 2], bottom[x * 2 + 1]);
+		}
+		if (x < dst.width())
+		{
+			int last = src.width() - 1;
+			out[x] = average_4(top[last], top[last], bottom[last], bottom[last]);
+		}
+	}
+}
+
+void lerp_row(GPixel dst[], const GPixel src[], int t, int count)
+{
+	// two channels at a time, (a * (256 - t) + b * t) fits in each 16 bit lane
+	const uint32_t mask = 0x00FF00FF;
+	uint32_t s = 256 - t;
+	for (int i = 0; i < count; ++i)
+	{
+		uint32_t even = (dst[i] & mask) * s + (src[i] & mask) * t;
+		uint32_t odd = ((dst[i] >> 8) & mask) * s + ((src[i] >> 8) & mask) * t;
+		dst[i] = ((even >> 8) & mask) | (((odd >> 8) & mask) << 8);
+	}
+}
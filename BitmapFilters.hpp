@@ -0,0 +1,33 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef BitmapFilters_hpp
+#define BitmapFilters_hpp
+
+#include "include/GBitmap.h"
+#include "include/GPixel.h"
+#include "include/GShader.h"
+#include <cstdint>
+
+// the filtered samplers for the bitmap shader, and the helpers for its mip levels
+// they walk a row of sample points in 16.16 fixed point, starting at (x, y) in the bitmap's
+// pixel space (pixel centers at whole numbers) and stepping by (dx, dy) for each pixel
+// alpha_scale is the paint's alpha out of 256, and the pixels they write stay premultiplied
+// both have an sse2 version and a plain one that come out exactly the same
+
+// blend the 2x2 pixels around each sample point, with 4 bits of weight in each direction
+void bilinear_row(const GBitmap& bitmap, GShader::TileMode tilemode, int64_t x, int64_t y, int64_t dx, int64_t dy,
+	int alpha_scale, int count, GPixel row[]);
+
+// filter the 4x4 pixels around each sample point with a Mitchell-Netravali cubic,
+// using 64 sub-pixel phases with 6 bit weights in each direction
+void bicubic_row(const GBitmap& bitmap, GShader::TileMode tilemode, int64_t x, int64_t y, int64_t dx, int64_t dy,
+	int alpha_scale, int count, GPixel row[]);
+
+// average every 2x2 block of src into one pixel of dst, which has to be ((w + 1) / 2, (h + 1) / 2)
+// in size (a last odd row or column just gets averaged with itself)
+void downsample_2x2(const GBitmap& src, const GBitmap& dst);
+
+// dst = dst + (src - dst) * t / 256, for t in [0, 256]
+void lerp_row(GPixel dst[], const GPixel src[], int t, int count);
+
+#endif
@@ -0,0 +1,453 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "BlendProcs.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#define BLEND_PROCS_X86
+	#include <immintrin.h>
+#endif
+
+// the scalar versions work everywhere and also finish off the tails of the simd versions
+static inline unsigned int divide_by_255(unsigned int p)
+{
+	// fast divide by 255 by approximating very very *very* close
+	// and getting to use a shift instead of divide
+	return (p * 65793 + (1 << 23)) >> 24;
+}
+
+static inline GPixel srcover_pixel(GPixel source, GPixel destination)
+{
+	// precalc once what we can
+	unsigned int source_pixel_a = GPixel_GetA(source);
+	int sa_compute = 255 - source_pixel_a;
+
+	if (sa_compute == 0)
+	{
+		// full alpha so only the source
+		return source;
+	}
+	else if (sa_compute == 255)
+	{
+		// no alpha so only the dest
+		return destination;
+	}
+
+	// calculate each result color component
+	unsigned int Ra = source_pixel_a + divide_by_255(sa_compute * GPixel_GetA(destination));
+	unsigned int Rr = GPixel_GetR(source) + divide_by_255(sa_compute * GPixel_GetR(destination));
+	unsigned int Rg = GPixel_GetG(source) + divide_by_255(sa_compute * GPixel_GetG(destination));
+	unsigned int Rb = GPixel_GetB(source) + divide_by_255(sa_compute * GPixel_GetB(destination));
+
+	// pack it into a pixel
+	return GPixel_PackARGB(Ra, Rr, Rg, Rb);
+}
+
+static void srcover_color_row_scalar(GPixel source, GPixel* dest, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		dest[i] = srcover_pixel(source, dest[i]);
+	}
+}
+
+static void srcover_row_scalar(const GPixel* source, GPixel* dest, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		dest[i] = srcover_pixel(source[i], dest[i]);
+	}
+}
+
+#ifdef BLEND_PROCS_X86
+
+// the simd versions work on 16 bit lanes, where (x + 128) * 257 >> 16 gives
+// exactly the same answer as divide_by_255(x) for every x in [0, 255 * 255]
+
+static inline __m128i srcover_4_sse2(__m128i source, __m128i dest)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	// 255 - source alpha, copied into both 16 bit halves of each pixel
+	__m128i inv_a = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(source, 24));
+	inv_a = _mm_or_si128(inv_a, _mm_slli_epi32(inv_a, 16));
+
+	// widen the dest to 16 bits per component, 2 pixels per register
+	__m128i dest_lo = _mm_unpacklo_epi8(dest, zero);
+	__m128i dest_hi = _mm_unpackhi_epi8(dest, zero);
+
+	// dest * (255 - source alpha), then divide by 255
+	dest_lo = _mm_mullo_epi16(dest_lo, _mm_unpacklo_epi32(inv_a, inv_a));
+	dest_hi = _mm_mullo_epi16(dest_hi, _mm_unpackhi_epi32(inv_a, inv_a));
+	dest_lo = _mm_mulhi_epu16(_mm_add_epi16(dest_lo, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+	dest_hi = _mm_mulhi_epu16(_mm_add_epi16(dest_hi, _mm_set1_epi16(128)), _mm_set1_epi16(257));
+
+	// premultiplied so the add can never carry out of a component
+	__m128i result = _mm_add_epi8(source, _mm_packus_epi16(dest_lo, dest_hi));
+
+	// a fully transparent source leaves the dest untouched
+	__m128i transparent = _mm_cmpeq_epi32(_mm_srli_epi32(source, 24), zero);
+	return _mm_or_si128(_mm_and_si128(transparent, dest), _mm_andnot_si128(transparent, result));
+}
+
+static void srcover_color_row_sse2(GPixel source, GPixel* dest, int count)
+{
+	__m128i src = _mm_set1_epi32(source);
+	while (count >= 4)
+	{
+		__m128i dst = _mm_loadu_si128((const __m128i*)dest);
+		_mm_storeu_si128((__m128i*)dest, srcover_4_sse2(src, dst));
+		dest += 4;
+		count -= 4;
+	}
+	srcover_color_row_scalar(source, dest, count);
+}
+
+static void srcover_row_sse2(const GPixel* source, GPixel* dest, int count)
+{
+	const __m128i alpha_mask = _mm_set1_epi32(0xFF000000);
+	while (count >= 4)
+	{
+		__m128i src = _mm_loadu_si128((const __m128i*)source);
+		__m128i src_alpha = _mm_and_si128(src, alpha_mask);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(src_alpha, alpha_mask)) == 0xFFFF)
+		{
+			// all 4 opaque so just copy them
+			_mm_storeu_si128((__m128i*)dest, src);
+		}
+		else if (_mm_movemask_epi8(_mm_cmpeq_epi32(src_alpha, _mm_setzero_si128())) != 0xFFFF)
+		{
+			// at least one has to actually be blended
+			__m128i dst = _mm_loadu_si128((const __m128i*)dest);
+			_mm_storeu_si128((__m128i*)dest, srcover_4_sse2(src, dst));
+		}
+		source += 4;
+		dest += 4;
+		count -= 4;
+	}
+	srcover_row_scalar(source, dest, count);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i srcover_8_avx2(__m256i source, __m256i dest)
+{
+	const __m256i zero = _mm256_setzero_si256();
+
+	// same as the sse2 version, the unpacks and the pack both work within 128 bit lanes
+	// so the pixels come back out in the same order they went in
+	__m256i inv_a = _mm256_sub_epi32(_mm256_set1_epi32(255), _mm256_srli_epi32(source, 24));
+	inv_a = _mm256_or_si256(inv_a, _mm256_slli_epi32(inv_a, 16));
+
+	__m256i dest_lo = _mm256_unpacklo_epi8(dest, zero);
+	__m256i dest_hi = _mm256_unpackhi_epi8(dest, zero);
+
+	dest_lo = _mm256_mullo_epi16(dest_lo, _mm256_unpacklo_epi32(inv_a, inv_a));
+	dest_hi = _mm256_mullo_epi16(dest_hi, _mm256_unpackhi_epi32(inv_a, inv_a));
+	dest_lo = _mm256_mulhi_epu16(_mm256_add_epi16(dest_lo, _mm256_set1_epi16(128)), _mm256_set1_epi16(257));
+	dest_hi = _mm256_mulhi_epu16(_mm256_add_epi16(dest_hi, _mm256_set1_epi16(128)), _mm256_set1_epi16(257));
+
+	__m256i result = _mm256_add_epi8(source, _mm256_packus_epi16(dest_lo, dest_hi));
+
+	__m256i transparent = _mm256_cmpeq_epi32(_mm256_srli_epi32(source, 24), zero);
+	return _mm256_blendv_epi8(result, dest, transparent);
+}
+
+__attribute__((target("avx2")))
+static void srcover_color_row_avx2(GPixel source, GPixel* dest, int count)
+{
+	__m256i src = _mm256_set1_epi32(source);
+	while (count >= 8)
+	{
+		__m256i dst = _mm256_loadu_si256((const __m256i*)dest);
+		_mm256_storeu_si256((__m256i*)dest, srcover_8_avx2(src, dst));
+		dest += 8;
+		count -= 8;
+	}
+	// leave the upper halves clean before dropping into the sse2 code for the tail
+	_mm256_zeroupper();
+	srcover_color_row_sse2(source, dest, count);
+}
+
+__attribute__((target("avx2")))
+static void srcover_row_avx2(const GPixel* source, GPixel* dest, int count)
+{
+	const __m256i alpha_mask = _mm256_set1_epi32(0xFF000000);
+	while (count >= 8)
+	{
+		__m256i src = _mm256_loadu_si256((const __m256i*)source);
+		__m256i src_alpha = _mm256_and_si256(src, alpha_mask);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(src_alpha, alpha_mask)) == -1)
+		{
+			// all 8 opaque so just copy them
+			_mm256_storeu_si256((__m256i*)dest, src);
+		}
+		else if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(src_alpha, _mm256_setzero_si256())) != -1)
+		{
+			// at least one has to actually be blended
+			__m256i dst = _mm256_loadu_si256((const __m256i*)dest);
+			_mm256_storeu_si256((__m256i*)dest, srcover_8_avx2(src, dst));
+		}
+		source += 8;
+		dest += 8;
+		count -= 8;
+	}
+	// leave the upper halves clean before dropping into the sse2 code for the tail
+	_mm256_zeroupper();
+	srcover_row_sse2(source, dest, count);
+}
+
+#endif
+
+// the generic per mode procs
+// every mode is written as a formula on one premultiplied component, with the
+// source and dest alphas alongside, and the same formula gives back the alpha
+static inline int div255(int p)
+{
+	// same rounding as divide_by_255 but in signed math for the intermediate sums
+	return ((p + 128) * 257) >> 16;
+}
+
+template <GBlendMode mode> static inline int blend_component(int s, int sa, int d, int da)
+{
+	switch (mode)
+	{
+		case GBlendMode::kClear: return 0;
+		case GBlendMode::kSrc: return s;
+		case GBlendMode::kDst: return d;
+		case GBlendMode::kSrcOver: return s + div255(d * (255 - sa));
+		case GBlendMode::kDstOver: return d + div255(s * (255 - da));
+		case GBlendMode::kSrcIn: return div255(s * da);
+		case GBlendMode::kDstIn: return div255(d * sa);
+		case GBlendMode::kSrcOut: return div255(s * (255 - da));
+		case GBlendMode::kDstOut: return div255(d * (255 - sa));
+		case GBlendMode::kSrcATop: return div255(s * da + d * (255 - sa));
+		case GBlendMode::kDstATop: return div255(d * sa + s * (255 - da));
+		case GBlendMode::kXor: return div255(s * (255 - da) + d * (255 - sa));
+		case GBlendMode::kPlus: return std::min(s + d, 255);
+		case GBlendMode::kMultiply: return div255(s * (255 - da) + d * (255 - sa) + s * d);
+		case GBlendMode::kScreen: return div255(255 * (s + d) - s * d);
+		case GBlendMode::kOverlay:
+		{
+			int both = (2 * d <= da) ? (2 * s * d) : (sa * da - 2 * (da - d) * (sa - s));
+			return div255(s * (255 - da) + d * (255 - sa) + both);
+		}
+		case GBlendMode::kDarken: return div255(255 * (s + d) - std::max(s * da, d * sa));
+		case GBlendMode::kLighten: return div255(255 * (s + d) - std::min(s * da, d * sa));
+		case GBlendMode::kHardLight:
+		{
+			int both = (2 * s <= sa) ? (2 * s * d) : (sa * da - 2 * (da - d) * (sa - s));
+			return div255(s * (255 - da) + d * (255 - sa) + both);
+		}
+		case GBlendMode::kDifference: return div255(255 * (s + d) - 2 * std::min(s * da, d * sa));
+		case GBlendMode::kExclusion: return div255(255 * (s + d) - 2 * s * d);
+	}
+	return d;
+}
+
+// true if a fully transparent source leaves the dest as it was
+template <GBlendMode mode> static inline bool transparent_keeps_dest()
+{
+	return mode != GBlendMode::kClear && mode != GBlendMode::kSrc && mode != GBlendMode::kSrcIn &&
+		mode != GBlendMode::kSrcOut && mode != GBlendMode::kDstIn && mode != GBlendMode::kDstATop;
+}
+
+template <GBlendMode mode> static inline GPixel blend_mode_pixel(GPixel source, GPixel destination)
+{
+	int sa = GPixel_GetA(source);
+	int da = GPixel_GetA(destination);
+
+	// the alpha first, then each color which can never come out bigger than it
+	int a = blend_component<mode>(sa, sa, da, da);
+	int r = std::min(a, blend_component<mode>(GPixel_GetR(source), sa, GPixel_GetR(destination), da));
+	int g = std::min(a, blend_component<mode>(GPixel_GetG(source), sa, GPixel_GetG(destination), da));
+	int b = std::min(a, blend_component<mode>(GPixel_GetB(source), sa, GPixel_GetB(destination), da));
+
+	return GPixel_PackARGB(a, r, g, b);
+}
+
+template <GBlendMode mode> static void blend_mode_color_row(GPixel source, GPixel* dest, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		dest[i] = blend_mode_pixel<mode>(source, dest[i]);
+	}
+}
+
+template <GBlendMode mode> static void blend_mode_row(const GPixel* source, GPixel* dest, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (transparent_keeps_dest<mode>() && GPixel_GetA(source[i]) == 0)
+		{
+			// nothing to do for this pixel
+			continue;
+		}
+		dest[i] = blend_mode_pixel<mode>(source[i], dest[i]);
+	}
+}
+
+// the modes where the answer does not depend on the dest at all just get filled
+static void fill_color_row(GPixel source, GPixel* dest, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		dest[i] = source;
+	}
+}
+
+static void clear_color_row(GPixel, GPixel* dest, int count)
+{
+	std::memset(dest, 0, count * sizeof(GPixel));
+}
+
+static void clear_row(const GPixel*, GPixel* dest, int count)
+{
+	std::memset(dest, 0, count * sizeof(GPixel));
+}
+
+static void src_row(const GPixel* source, GPixel* dest, int count)
+{
+	std::memcpy(dest, source, count * sizeof(GPixel));
+}
+
+static void dst_color_row(GPixel, GPixel*, int)
+{
+	// the dest stays the same
+}
+
+static void dst_row(const GPixel*, GPixel*, int)
+{
+	// the dest stays the same
+}
+
+#define BLEND_MODE_PROCS(mode, name) \
+	BlendProcs{ blend_mode_color_row<GBlendMode::mode>, blend_mode_row<GBlendMode::mode>, name }
+
+static const int kBlendModeCount = (int)GBlendMode::kLastMode + 1;
+
+static const BlendProcs* make_blend_mode_procs_table()
+{
+	// indexed by the blend mode
+	static BlendProcs table[kBlendModeCount] = {
+		BlendProcs{ clear_color_row, clear_row, "clear" },
+		BlendProcs{ fill_color_row, src_row, "src" },
+		BlendProcs{ dst_color_row, dst_row, "dst" },
+		BLEND_MODE_PROCS(kSrcOver, "srcover"),
+		BLEND_MODE_PROCS(kDstOver, "dstover"),
+		BLEND_MODE_PROCS(kSrcIn, "srcin"),
+		BLEND_MODE_PROCS(kDstIn, "dstin"),
+		BLEND_MODE_PROCS(kSrcOut, "srcout"),
+		BLEND_MODE_PROCS(kDstOut, "dstout"),
+		BLEND_MODE_PROCS(kSrcATop, "srcatop"),
+		BLEND_MODE_PROCS(kDstATop, "dstatop"),
+		BLEND_MODE_PROCS(kXor, "xor"),
+		BLEND_MODE_PROCS(kPlus, "plus"),
+		BLEND_MODE_PROCS(kMultiply, "multiply"),
+		BLEND_MODE_PROCS(kScreen, "screen"),
+		BLEND_MODE_PROCS(kOverlay, "overlay"),
+		BLEND_MODE_PROCS(kDarken, "darken"),
+		BLEND_MODE_PROCS(kLighten, "lighten"),
+		BLEND_MODE_PROCS(kHardLight, "hardlight"),
+		BLEND_MODE_PROCS(kDifference, "difference"),
+		BLEND_MODE_PROCS(kExclusion, "exclusion"),
+	};
+
+	// srcover is the common case so it gets the simd procs
+	table[(int)GBlendMode::kSrcOver] = get_srcover_blend_procs();
+	return table;
+}
+
+#undef BLEND_MODE_PROCS
+
+static BlendProcs choose_srcover_blend_procs()
+{
+	#ifdef BLEND_PROCS_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+		{
+			return BlendProcs{ srcover_color_row_avx2, srcover_row_avx2, "avx2" };
+		}
+		if (__builtin_cpu_supports("sse2"))
+		{
+			return BlendProcs{ srcover_color_row_sse2, srcover_row_sse2, "sse2" };
+		}
+	#endif
+	return BlendProcs{ srcover_color_row_scalar, srcover_row_scalar, "scalar" };
+}
+
+const BlendProcs& get_srcover_blend_procs()
+{
+	// only ask the cpu once
+	static const BlendProcs procs = choose_srcover_blend_procs();
+	return procs;
+}
+
+int get_all_srcover_blend_procs(BlendProcs procs[3])
+{
+	int count = 0;
+	procs[count++] = BlendProcs{ srcover_color_row_scalar, srcover_row_scalar, "scalar" };
+	#ifdef BLEND_PROCS_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse2"))
+		{
+			procs[count++] = BlendProcs{ srcover_color_row_sse2, srcover_row_sse2, "sse2" };
+		}
+		if (__builtin_cpu_supports("avx2"))
+		{
+			procs[count++] = BlendProcs{ srcover_color_row_avx2, srcover_row_avx2, "avx2" };
+		}
+	#endif
+	return count;
+}
+
+const BlendProcs& get_blend_mode_procs(GBlendMode mode)
+{
+	// built once, the first time it is called
+	static const BlendProcs* table = make_blend_mode_procs_table();
+	return table[(int)mode];
+}
+
+BlendColorRowProc choose_blend_color_row_proc(GBlendMode mode, GPixel source)
+{
+	// fold the mode down based on the source alpha, since that is the same for every pixel
+	int alpha = GPixel_GetA(source);
+	if (alpha == 0)
+	{
+		switch (mode)
+		{
+			case GBlendMode::kClear:
+			case GBlendMode::kSrc:
+			case GBlendMode::kSrcIn:
+			case GBlendMode::kSrcOut:
+			case GBlendMode::kDstIn:
+			case GBlendMode::kDstATop:
+				// all of these come out to 0
+				mode = GBlendMode::kClear;
+				break;
+			default:
+				// everything else leaves the dest alone
+				return nullptr;
+		}
+	}
+	else if (alpha == 255)
+	{
+		switch (mode)
+		{
+			case GBlendMode::kSrcOver: mode = GBlendMode::kSrc; break;
+			case GBlendMode::kDstIn: return nullptr;
+			case GBlendMode::kDstOut: mode = GBlendMode::kClear; break;
+			case GBlendMode::kSrcATop: mode = GBlendMode::kSrcIn; break;
+			case GBlendMode::kDstATop: mode = GBlendMode::kDstOver; break;
+			case GBlendMode::kXor: mode = GBlendMode::kSrcOut; break;
+			default: break;
+		}
+	}
+
+	if (mode == GBlendMode::kDst)
+	{
+		// nothing will change
+		return nullptr;
+	}
+	return get_blend_mode_procs(mode).color_row;
+}
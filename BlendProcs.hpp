@@ -0,0 +1,39 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef BlendProcs_hpp
+#define BlendProcs_hpp
+
+#include "include/GBlendMode.h"
+#include "include/GPixel.h"
+
+// blend a single source pixel over count destination pixels
+typedef void (*BlendColorRowProc)(GPixel source, GPixel* dest, int count);
+
+// blend count source pixels over count destination pixels
+typedef void (*BlendRowProc)(const GPixel* source, GPixel* dest, int count);
+
+// the pair of row procs used for one blend mode
+struct BlendProcs
+{
+	BlendColorRowProc color_row;
+	BlendRowProc row;
+	const char* name;
+};
+
+// get the srcover procs best suited to the cpu we are running on
+// this is picked once, the first time it is called
+const BlendProcs& get_srcover_blend_procs();
+
+// get every set of srcover procs the cpu can run, the scalar ones first, so they can be checked
+// against each other; returns how many were written to procs (at most 3)
+int get_all_srcover_blend_procs(BlendProcs procs[3]);
+
+// get the row procs for any blend mode (srcover gets the simd ones from above)
+const BlendProcs& get_blend_mode_procs(GBlendMode mode);
+
+// pick the row proc for blending a single color with the given mode, folding the mode
+// down to a simpler one when the color is opaque or transparent
+// returns nullptr if the blend would leave every destination pixel unchanged
+BlendColorRowProc choose_blend_color_row_proc(GBlendMode mode, GPixel source);
+
+#endif
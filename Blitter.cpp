@@ -0,0 +1,242 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "Blitter.hpp"
+#include "utils.hpp"
+#include <algorithm>
+
+Blitter::Blitter(const GBitmap& bitmap, const GPaint& paint, const GMatrix& ctm, const GIRect& clip, const ClipMask* mask)
+{
+	this->m_bitmap = &bitmap;
+	this->m_clip = clip;
+	this->m_mask = mask;
+	this->m_visible = true;
+	this->m_shader = paint.getShader();
+	this->m_row_proc = nullptr;
+	this->m_pixel = 0;
+	this->m_color_proc = nullptr;
+
+	GBlendMode mode = paint.getBlendMode();
+	this->m_mode = mode;
+	this->m_coverage_proc = get_blend_mode_procs(mode).row;
+
+	// a few modes do not care what the source is at all
+	if (mode == GBlendMode::kDst)
+	{
+		this->m_visible = false;
+		return;
+	}
+	if (mode == GBlendMode::kClear)
+	{
+		this->m_shader = nullptr;
+	}
+
+	if (this->m_shader == nullptr)
+	{
+		// convert that silly color into a pixel and pick the proc for it
+		if (mode != GBlendMode::kClear)
+		{
+			this->m_pixel = convert_color_to_pixel(paint.getColor().pinToUnit());
+		}
+		this->m_color_proc = choose_blend_color_row_proc(mode, this->m_pixel);
+		this->m_visible = (this->m_color_proc != nullptr);
+	}
+	else
+	{
+		// we have a shader so set its context
+		if (this->m_shader->setContext(ctm, paint.getAlpha()) == false)
+		{
+			this->m_visible = false;
+			return;
+		}
+		this->m_row_proc = get_blend_mode_procs(mode).row;
+	}
+}
+
+void Blitter::blit_row(int x, int y, int count)
+{
+	// only the part of the row inside the clip gets touched
+	int left = std::max(x, this->m_clip.fLeft);
+	int right = std::min(x + count, this->m_clip.fRight);
+	if (left >= right || y < this->m_clip.fTop || y >= this->m_clip.fBottom)
+	{
+		// nothing to draw
+		return;
+	}
+
+	if (this->m_mask != nullptr)
+	{
+		// just the parts of the row inside of the mask's runs
+		this->m_mask->for_each_run(y, left, right, [this, x, y, count] (int run_left, int run_right)
+			{
+				this->blit_span(x, y, count, run_left, run_right);
+			}
+		);
+		return;
+	}
+	this->blit_span(x, y, count, left, right);
+}
+
+void Blitter::blit_span(int x, int y, int count, int left, int right)
+{
+	// get the destination row
+	GPixel* row_pixels = this->m_bitmap->pixels() + ((this->m_bitmap->rowBytes() >> 2) * y);
+
+	// will it blend ?!?
+	if (this->m_shader != nullptr)
+	{
+		// do it with the shader, always in 256 pixel chunks counted from x so a clipped
+		// row asks the shader for exactly the same chunks as the whole row would
+		GPixel buffer[256];
+		for (int chunk = x + ((left - x) & ~255); chunk < right; chunk += 256)
+		{
+			int n = std::min(x + count - chunk, 256);
+			this->m_shader->shadeRow(chunk, y, n, buffer);
+
+			int start = std::max(chunk, left);
+			int end = std::min(chunk + n, right);
+			this->m_row_proc(buffer + (start - chunk), row_pixels + start, end - start);
+		}
+	}
+	else
+	{
+		// do it with the color
+		this->m_color_proc(this->m_pixel, row_pixels + left, right - left);
+	}
+}
+
+void Blitter::blit_rect(const GIRect& rect)
+{
+	if (this->m_shader != nullptr || this->m_mask != nullptr)
+	{
+		// the shader chunks have to start at rect.fLeft on every row, and a mask has different
+		// runs on every row, blit_row does both
+		int top = std::max(rect.fTop, this->m_clip.fTop);
+		int bottom = std::min(rect.fBottom, this->m_clip.fBottom);
+		for (int y = top; y < bottom; ++y)
+		{
+			this->blit_row(rect.fLeft, y, rect.width());
+		}
+		return;
+	}
+
+	// with just a color the clipping only has to be done once
+	GIRect area = rect;
+	if (area.intersect(this->m_clip) == false)
+	{
+		// nothing to draw
+		return;
+	}
+
+	size_t row_pixels = this->m_bitmap->rowBytes() >> 2;
+	GPixel* pixels = this->m_bitmap->pixels() + row_pixels * area.fTop + area.fLeft;
+	if (area.width() == (int)row_pixels)
+	{
+		// whole rows with nothing in between, so it is one long run
+		this->m_color_proc(this->m_pixel, pixels, area.width() * area.height());
+		return;
+	}
+	for (int y = area.fTop; y < area.fBottom; ++y)
+	{
+		this->m_color_proc(this->m_pixel, pixels, area.width());
+		pixels += row_pixels;
+	}
+}
+
+static inline GPixel scale_pixel(GPixel p, unsigned int scale)
+{
+	// scale every component, which keeps the pixel premultiplied
+	return GPixel_PackARGB(divide_by_255(GPixel_GetA(p) * scale), divide_by_255(GPixel_GetR(p) * scale),
+		divide_by_255(GPixel_GetG(p) * scale), divide_by_255(GPixel_GetB(p) * scale));
+}
+
+static inline GPixel lerp_pixel(GPixel from, GPixel to, unsigned int t)
+{
+	// from + (to - from) * t, one component at a time
+	unsigned int s = 255 - t;
+	return GPixel_PackARGB(divide_by_255(GPixel_GetA(from) * s + GPixel_GetA(to) * t),
+		divide_by_255(GPixel_GetR(from) * s + GPixel_GetR(to) * t),
+		divide_by_255(GPixel_GetG(from) * s + GPixel_GetG(to) * t),
+		divide_by_255(GPixel_GetB(from) * s + GPixel_GetB(to) * t));
+}
+
+void Blitter::blit_row_coverage(int x, int y, int count, const uint8_t coverage[])
+{
+	// only the part of the row inside the clip gets touched
+	int left = std::max(x, this->m_clip.fLeft);
+	int right = std::min(x + count, this->m_clip.fRight);
+	if (left >= right || y < this->m_clip.fTop || y >= this->m_clip.fBottom)
+	{
+		// nothing to draw
+		return;
+	}
+
+	if (this->m_mask != nullptr)
+	{
+		// just the parts of the row inside of the mask's runs
+		this->m_mask->for_each_run(y, left, right, [this, x, y, count, coverage] (int run_left, int run_right)
+			{
+				this->blit_span_coverage(x, y, count, run_left, run_right, coverage);
+			}
+		);
+		return;
+	}
+	this->blit_span_coverage(x, y, count, left, right, coverage);
+}
+
+void Blitter::blit_span_coverage(int x, int y, int count, int left, int right, const uint8_t coverage[])
+{
+	// get the destination row
+	GPixel* row_pixels = this->m_bitmap->pixels() + ((this->m_bitmap->rowBytes() >> 2) * y);
+
+	// same 256 pixel chunks as blit_row
+	GPixel buffer[256];
+	for (int chunk = x + ((left - x) & ~255); chunk < right; chunk += 256)
+	{
+		int n = std::min(x + count - chunk, 256);
+
+		// the source pixels, from the shader or just the color
+		if (this->m_shader != nullptr)
+		{
+			this->m_shader->shadeRow(chunk, y, n, buffer);
+		}
+		else
+		{
+			for (int i = 0; i < n; ++i)
+			{
+				buffer[i] = this->m_pixel;
+			}
+		}
+
+		// the part of the chunk inside the clip
+		int start = std::max(chunk, left);
+		int m = std::min(chunk + n, right) - start;
+		GPixel* source = buffer + (start - chunk);
+		GPixel* dest_pixels = row_pixels + start;
+		const uint8_t* chunk_coverage = coverage + (start - x);
+
+		if (this->m_mode == GBlendMode::kSrcOver)
+		{
+			// for srcover scaling the source by the coverage is the same as
+			// lerping towards the blended result, and is cheaper
+			for (int i = 0; i < m; ++i)
+			{
+				source[i] = scale_pixel(source[i], chunk_coverage[i]);
+			}
+			this->m_coverage_proc(source, dest_pixels, m);
+		}
+		else
+		{
+			// blend into a copy of the dest and then lerp the dest towards it
+			GPixel blended[256];
+			for (int i = 0; i < m; ++i)
+			{
+				blended[i] = dest_pixels[i];
+			}
+			this->m_coverage_proc(source, blended, m);
+			for (int i = 0; i < m; ++i)
+			{
+				dest_pixels[i] = lerp_pixel(dest_pixels[i], blended[i], chunk_coverage[i]);
+			}
+		}
+	}
+}
@@ -0,0 +1,62 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef Blitter_hpp
+#define Blitter_hpp
+
+#include "include/GBitmap.h"
+#include "include/GMatrix.h"
+#include "include/GPaint.h"
+#include "include/GPixel.h"
+#include "include/GRect.h"
+#include "include/GShader.h"
+#include "BlendProcs.hpp"
+#include "ClipMask.hpp"
+
+// writes horizontal runs of pixels for one draw
+// everything that depends on the paint (color, shader, blend mode) is worked out once
+// in the constructor so the per row work is just picking the right proc
+class Blitter
+{
+public:
+	// setup to draw with the paint onto the bitmap, this sets the shader context (if any)
+	// nothing outside of clip (or outside of the runs of mask, when there is one) is ever
+	// touched, rows can be passed in unclipped
+	Blitter(const GBitmap& bitmap, const GPaint& paint, const GMatrix& ctm, const GIRect& clip, const ClipMask* mask = nullptr);
+
+	// false if drawing with this paint cannot change any pixels
+	bool is_visible() const { return this->m_visible; }
+
+	// blend the pixels [x, x + count) on row y
+	void blit_row(int x, int y, int count);
+
+	// blend every pixel in rect, the same as blit_row on each of its rows
+	void blit_rect(const GIRect& rect);
+
+	// blend the pixels [x, x + count) on row y, each one only partially covered
+	// coverage[i] goes from 0 (leave the pixel alone) to 255 (same as blit_row)
+	void blit_row_coverage(int x, int y, int count, const uint8_t coverage[]);
+
+private:
+	// blend the pixels [left, right) on row y, out of the row [x, x + count) they were asked for with
+	void blit_span(int x, int y, int count, int left, int right);
+	void blit_span_coverage(int x, int y, int count, int left, int right, const uint8_t coverage[]);
+
+	const GBitmap* m_bitmap;
+	GIRect m_clip;
+	const ClipMask* m_mask;
+	bool m_visible;
+
+	// the paint's blend mode and its row proc, used for partial coverage
+	GBlendMode m_mode;
+	BlendRowProc m_coverage_proc;
+
+	// the shader and its blend proc
+	GShader* m_shader;
+	BlendRowProc m_row_proc;
+
+	// or the color and its blend proc
+	GPixel m_pixel;
+	BlendColorRowProc m_color_proc;
+};
+
+#endif
@@ -0,0 +1,94 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "ClipMask.hpp"
+#include <algorithm>
+
+ClipMaskBuilder::ClipMaskBuilder()
+{
+	this->m_within_rect = GIRect::MakeWH(0, 0);
+	this->m_within_mask = nullptr;
+}
+
+void ClipMaskBuilder::start(const GIRect& within_rect, const ClipMask* within_mask)
+{
+	this->m_within_rect = within_rect;
+	this->m_within_mask = within_mask;
+	this->m_runs.clear();
+	this->m_run_rows.clear();
+}
+
+void ClipMaskBuilder::blit_row(int x, int y, int count)
+{
+	int left = std::max(x, this->m_within_rect.fLeft);
+	int right = std::min(x + count, this->m_within_rect.fRight);
+	if (left >= right || y < this->m_within_rect.fTop || y >= this->m_within_rect.fBottom)
+	{
+		return;
+	}
+
+	if (this->m_within_mask == nullptr)
+	{
+		this->add_run(y, left, right);
+		return;
+	}
+
+	// keep just the parts inside of the runs already there
+	this->m_within_mask->for_each_run(y, left, right, [this, y] (int run_left, int run_right)
+		{
+			this->add_run(y, run_left, run_right);
+		}
+	);
+}
+
+void ClipMaskBuilder::add_run(int y, int left, int right)
+{
+	// spans that touch (or overlap) the last one on the same row just make it longer
+	if (this->m_runs.empty() == false && this->m_run_rows.back() == y && left <= this->m_runs.back().right)
+	{
+		this->m_runs.back().right = std::max(this->m_runs.back().right, right);
+		return;
+	}
+	this->m_runs.push_back({ left, right });
+	this->m_run_rows.push_back(y);
+}
+
+void ClipMaskBuilder::finish(ClipMask* mask)
+{
+	mask->m_runs.clear();
+	if (this->m_runs.empty() == true)
+	{
+		// nothing is inside of it
+		mask->m_bounds = GIRect::MakeWH(0, 0);
+		mask->m_row_starts.assign(1, 0);
+		return;
+	}
+
+	int top = this->m_run_rows.front();
+	int bottom = this->m_run_rows.back() + 1;
+	int left = this->m_runs.front().left;
+	int right = this->m_runs.front().right;
+	for (const ClipMask::Run& run : this->m_runs)
+	{
+		left = std::min(left, run.left);
+		right = std::max(right, run.right);
+	}
+	mask->m_bounds = GIRect::MakeLTRB(left, top, right, bottom);
+
+	// the rows with no runs just start where the next one does
+	mask->m_row_starts.resize(bottom - top + 1);
+	int run = 0;
+	int run_count = (int)this->m_runs.size();
+	for (int y = top; y <= bottom; ++y)
+	{
+		mask->m_row_starts[y - top] = run;
+		while (run < run_count && this->m_run_rows[run] == y)
+		{
+			++run;
+		}
+	}
+	// the builder takes the mask's old buffer for the next one
+	mask->m_runs.swap(this->m_runs);
+
+	this->m_runs.clear();
+	this->m_run_rows.clear();
+}
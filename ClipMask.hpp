@@ -0,0 +1,97 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef ClipMask_hpp
+#define ClipMask_hpp
+
+#include "include/GRect.h"
+#include <algorithm>
+#include <vector>
+
+// the pixels inside of a clip that is not just a rect, kept as the runs of pixels on each row
+// the runs on a row are sorted, do not overlap and do not touch
+// a mask is not changed while any clip still uses it, so canvases can share it between their
+// saved clips (and with each other)
+class ClipMask
+{
+public:
+	struct Run
+	{
+		int left;
+		int right;
+	};
+
+	// the rows with any runs, and the columns they span
+	const GIRect& bounds() const { return this->m_bounds; }
+
+	// the runs on row y, and how many there are (none outside of the bounds)
+	int row(int y, const Run** runs) const
+	{
+		if (y < this->m_bounds.fTop || y >= this->m_bounds.fBottom)
+		{
+			return 0;
+		}
+		int first = this->m_row_starts[y - this->m_bounds.fTop];
+		*runs = this->m_runs.data() + first;
+		return this->m_row_starts[y - this->m_bounds.fTop + 1] - first;
+	}
+
+	// call fn(run_left, run_right) for each part of the pixels [left, right) on row y that is
+	// inside of the mask's runs, left to right
+	template <typename Fn>
+	void for_each_run(int y, int left, int right, Fn fn) const
+	{
+		const Run* runs = nullptr;
+		int run_count = this->row(y, &runs);
+		for (int i = 0; i < run_count && runs[i].left < right; ++i)
+		{
+			int run_left = std::max(left, runs[i].left);
+			int run_right = std::min(right, runs[i].right);
+			if (run_left < run_right)
+			{
+				fn(run_left, run_right);
+			}
+		}
+	}
+
+private:
+	friend class ClipMaskBuilder;
+
+	GIRect m_bounds;
+
+	// where each row's runs start in m_runs, with one more entry for the end of the last row
+	std::vector<int> m_row_starts;
+	std::vector<Run> m_runs;
+};
+
+// makes a mask out of the spans a scan converter hands it, limited to what is inside of
+// the rect and the mask (if any) it is built within, so the result is their intersection
+// the spans have to come in row by row from the top, and left to right on each row
+// it keeps its buffers from one mask to the next
+class ClipMaskBuilder
+{
+public:
+	ClipMaskBuilder();
+
+	// start a new mask, built within within_rect and within_mask
+	void start(const GIRect& within_rect, const ClipMask* within_mask);
+
+	// add the pixels [x, x + count) on row y
+	void blit_row(int x, int y, int count);
+
+	// make mask the finished one (with no runs at all when nothing ended up inside of it),
+	// reusing the buffers mask already had
+	// the builder is empty again afterwards
+	void finish(ClipMask* mask);
+
+private:
+	void add_run(int y, int left, int right);
+
+	GIRect m_within_rect;
+	const ClipMask* m_within_mask;
+
+	// every run added so far, and the row it is on
+	std::vector<ClipMask::Run> m_runs;
+	std::vector<int> m_run_rows;
+};
+
+#endif
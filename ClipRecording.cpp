@@ -0,0 +1,133 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "ClipRecording.hpp"
+#include "include/GContour.h"
+#include <algorithm>
+#include <cmath>
+
+// stands in for the bounds of a clip whose points are not all numbers, big enough to cover
+// any bitmap but still small enough to turn into an int
+static const float kUnboundedClip = 1.0e9f;
+
+int ClipRecording::add_clip(int parent, const GRect& bounds)
+{
+	Clip clip;
+	clip.parent = parent;
+	clip.is_rect = false;
+	clip.rect = GRect::MakeLTRB(0, 0, 0, 0);
+
+	// nothing can be outside of the clip it is made inside of
+	clip.bounds = GRect::MakeLTRB(-kUnboundedClip, -kUnboundedClip, kUnboundedClip, kUnboundedClip);
+	if (std::isfinite(bounds.fLeft + bounds.fTop + bounds.fRight + bounds.fBottom) == true)
+	{
+		clip.bounds = bounds;
+	}
+	if (parent != NO_CLIP && clip.bounds.intersect(this->m_clips[parent].bounds) == false)
+	{
+		clip.bounds = GRect::MakeLTRB(0, 0, 0, 0);
+	}
+
+	this->m_clips.push_back(clip);
+	return (int)this->m_clips.size() - 1;
+}
+
+int ClipRecording::clip_rect(int parent, const GMatrix& ctm, const GRect& rect)
+{
+	GPoint corners[] = { GPoint::Make(rect.fLeft, rect.fTop), GPoint::Make(rect.fRight, rect.fTop),
+						 GPoint::Make(rect.fRight, rect.fBottom), GPoint::Make(rect.fLeft, rect.fBottom) };
+	GPoint device[4];
+	ctm.mapPoints(device, corners, 4);
+
+	GRect bounds = GRect::MakeLTRB(device[0].fX, device[0].fY, device[0].fX, device[0].fY);
+	for (int i = 1; i < 4; ++i)
+	{
+		bounds.fLeft = std::min(bounds.fLeft, device[i].fX);
+		bounds.fTop = std::min(bounds.fTop, device[i].fY);
+		bounds.fRight = std::max(bounds.fRight, device[i].fX);
+		bounds.fBottom = std::max(bounds.fBottom, device[i].fY);
+	}
+	int index = this->add_clip(parent, bounds);
+	Clip& clip = this->m_clips[index];
+
+	if (ctm.getType() & GMatrix::kAffine_Mask)
+	{
+		// turned, so the canvas clips to it as the path of its corners
+		clip.path.moveTo(device[0]).lineTo(device[1]).lineTo(device[2]).lineTo(device[3]);
+	}
+	else
+	{
+		// the corners as they were mapped, in order, so the canvas sorts them the same way
+		clip.is_rect = true;
+		clip.rect = GRect::MakeLTRB(device[0].fX, device[0].fY, device[2].fX, device[2].fY);
+	}
+	return index;
+}
+
+int ClipRecording::clip_path(int parent, const GMatrix& ctm, const GPath& path)
+{
+	GPath device_path;
+	std::vector<GPoint> device;
+	bool has_points = false;
+	GRect bounds = GRect::MakeLTRB(0, 0, 0, 0);
+
+	// curves are flattened for the ctm first, the same as the canvas would, so the device path
+	// is all lines and replays exactly
+	this->m_flattener.flatten(path, ctm);
+	for (int c = 0; c < this->m_flattener.contour_count(); ++c)
+	{
+		const GContour& contour = this->m_flattener.contours()[c];
+		if (contour.fCount < 1)
+		{
+			continue;
+		}
+		device.resize(contour.fCount);
+		ctm.mapPoints(device.data(), contour.fPts, contour.fCount);
+		device_path.moveTo(device[0]);
+		for (int i = 1; i < contour.fCount; ++i)
+		{
+			device_path.lineTo(device[i]);
+		}
+
+		for (const GPoint& p : device)
+		{
+			if (has_points == false)
+			{
+				bounds = GRect::MakeLTRB(p.fX, p.fY, p.fX, p.fY);
+				has_points = true;
+			}
+			bounds.fLeft = std::min(bounds.fLeft, p.fX);
+			bounds.fTop = std::min(bounds.fTop, p.fY);
+			bounds.fRight = std::max(bounds.fRight, p.fX);
+			bounds.fBottom = std::max(bounds.fBottom, p.fY);
+		}
+	}
+
+	int index = this->add_clip(parent, bounds);
+	this->m_clips[index].path = device_path;
+	return index;
+}
+
+void ClipRecording::apply(int index, GCanvas* canvas) const
+{
+	if (index == NO_CLIP)
+	{
+		return;
+	}
+
+	// the clips it was made inside of go first
+	this->apply(this->m_clips[index].parent, canvas);
+	this->apply_one(index, canvas);
+}
+
+void ClipRecording::apply_one(int index, GCanvas* canvas) const
+{
+	const Clip& clip = this->m_clips[index];
+	if (clip.is_rect == true)
+	{
+		canvas->clipRect(clip.rect);
+	}
+	else
+	{
+		canvas->clipPath(clip.path);
+	}
+}
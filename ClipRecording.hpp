@@ -0,0 +1,65 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef ClipRecording_hpp
+#define ClipRecording_hpp
+
+#include "include/GCanvas.h"
+#include "include/GMatrix.h"
+#include "include/GPath.h"
+#include "include/GRect.h"
+#include "PathFlattener.hpp"
+#include <vector>
+
+// the clips made on a recording canvas, so they can be made again on the canvas it plays back onto
+// each clip is kept already mapped to device space, as a rect when the ctm kept it lined up with
+// the pixels and as a path otherwise, and points at the clip it was made inside of
+// applied with an identity ctm they make exactly the same clip as the original calls would have
+class ClipRecording
+{
+public:
+	enum
+	{
+		// the clip index when nothing has been clipped to
+		NO_CLIP = -1,
+	};
+
+	// record a clip made inside of clip parent, and return its index
+	int clip_rect(int parent, const GMatrix& ctm, const GRect& rect);
+	int clip_path(int parent, const GMatrix& ctm, const GPath& path);
+
+	// clip canvas to clip index (and everything it was made inside of), canvas's ctm has to be
+	// where the recording's device space is
+	void apply(int index, GCanvas* canvas) const;
+	// the same, for a canvas that already has the clip index was made inside of
+	void apply_one(int index, GCanvas* canvas) const;
+
+	// how many clips there are, and the one clip index was made inside of (or NO_CLIP)
+	int count() const { return (int)this->m_clips.size(); }
+	int parent(int index) const { return this->m_clips[index].parent; }
+
+	// the device space area that can be inside of clip index, it can be empty
+	const GRect& bounds(int index) const { return this->m_clips[index].bounds; }
+
+	// forget every clip
+	void clear() { this->m_clips.clear(); }
+
+private:
+	struct Clip
+	{
+		int parent;
+		bool is_rect;
+		GRect rect;
+		GPath path;
+		GRect bounds;
+	};
+
+	// add the clip with the device bounds it has on its own
+	int add_clip(int parent, const GRect& bounds);
+
+	std::vector<Clip> m_clips;
+
+	// turns clip paths into lines, keeping its buffers between them
+	PathFlattener m_flattener;
+};
+
+#endif
@@ -0,0 +1,142 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "Dasher.hpp"
+#include <cmath>
+
+// the point distance along the segment from a to b of the given length
+static GPoint point_along(const GPoint& a, const GPoint& b, float length, float distance)
+{
+	if (length <= 0.0f)
+	{
+		return a;
+	}
+	float t = distance / length;
+	return GPoint::Make(a.fX + (b.fX - a.fX) * t, a.fY + (b.fY - a.fY) * t);
+}
+
+static float segment_length(const GPoint& a, const GPoint& b)
+{
+	float dx = b.fX - a.fX;
+	float dy = b.fY - a.fY;
+	return std::sqrt(dx * dx + dy * dy);
+}
+
+void Dasher::start(const GContour& contour, const GPaint& paint)
+{
+	this->m_contour = contour;
+	this->m_segment_count = 0;
+	if (contour.fCount >= 2)
+	{
+		this->m_segment_count = (contour.fClosed == true ? contour.fCount : contour.fCount - 1);
+	}
+	this->m_segment = 0;
+	this->m_distance = 0.0f;
+	this->m_whole = false;
+
+	this->m_interval_count = paint.getDashCount();
+	float pattern_length = 0.0f;
+	for (int i = 0; i < this->m_interval_count; ++i)
+	{
+		this->m_intervals[i] = paint.getDashIntervals()[i];
+		pattern_length += this->m_intervals[i];
+	}
+
+	// how many times the pattern goes around on this contour, which is too many to bother cutting
+	// up if it is not a number or there would be more dashes than anyone could see
+	float length = 0.0f;
+	for (int i = 0; i < this->m_segment_count; ++i)
+	{
+		length += segment_length(contour.fPts[i], contour.fPts[(i + 1) % contour.fCount]);
+	}
+	float repeats = length / pattern_length;
+	if (!(repeats * (this->m_interval_count / 2) <= MAX_DASHES) || std::isfinite(pattern_length) == false)
+	{
+		this->m_whole = true;
+		return;
+	}
+
+	// the phase wraps around the pattern (either way), then picks the interval it starts in
+	float phase = std::fmod(paint.getDashPhase(), pattern_length);
+	if (phase < 0.0f)
+	{
+		phase += pattern_length;
+	}
+	if (std::isfinite(phase) == false)
+	{
+		phase = 0.0f;
+	}
+	this->m_interval = 0;
+	while (this->m_interval < this->m_interval_count - 1 && phase >= this->m_intervals[this->m_interval])
+	{
+		phase -= this->m_intervals[this->m_interval];
+		++this->m_interval;
+	}
+	this->m_remaining = this->m_intervals[this->m_interval] - phase;
+	this->m_on = ((this->m_interval & 1) == 0);
+}
+
+void Dasher::next_interval()
+{
+	this->m_interval = (this->m_interval + 1) % this->m_interval_count;
+	this->m_remaining = this->m_intervals[this->m_interval];
+	this->m_on = !this->m_on;
+}
+
+bool Dasher::next(GContour* dash)
+{
+	if (this->m_whole == true)
+	{
+		// just the once
+		this->m_whole = false;
+		this->m_segment = this->m_segment_count;
+		*dash = this->m_contour;
+		return this->m_contour.fCount > 0;
+	}
+
+	const GPoint* pts = this->m_contour.fPts;
+	this->m_points.clear();
+	while (this->m_segment < this->m_segment_count)
+	{
+		const GPoint& a = pts[this->m_segment];
+		const GPoint& b = pts[(this->m_segment + 1) % this->m_contour.fCount];
+		float length = segment_length(a, b);
+		float left_in_segment = length - this->m_distance;
+		if (this->m_on == true && this->m_points.empty() == true && (left_in_segment > 0.0f || this->m_remaining <= 0.0f))
+		{
+			// a dash starts here (one starting right at the end of the segment starts on the next one instead)
+			this->m_points.push_back(point_along(a, b, length, this->m_distance));
+		}
+
+		if (this->m_remaining > left_in_segment)
+		{
+			// the interval goes on around the corner into the next segment
+			this->m_remaining -= left_in_segment;
+			if (this->m_on == true && this->m_points.empty() == false)
+			{
+				this->m_points.push_back(b);
+			}
+			++this->m_segment;
+			this->m_distance = 0.0f;
+			continue;
+		}
+
+		// the interval ends in this segment
+		this->m_distance += this->m_remaining;
+		bool was_on = this->m_on;
+		this->next_interval();
+		if (was_on == true)
+		{
+			this->m_points.push_back(point_along(a, b, length, this->m_distance));
+			*dash = { (int)this->m_points.size(), this->m_points.data(), false };
+			return true;
+		}
+	}
+
+	if (this->m_points.empty() == false)
+	{
+		// the contour ended partway through a dash
+		*dash = { (int)this->m_points.size(), this->m_points.data(), false };
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,55 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef Dasher_hpp
+#define Dasher_hpp
+
+#include "include/GContour.h"
+#include "include/GPaint.h"
+#include "include/GPoint.h"
+#include <vector>
+
+// cuts a contour into the dashes of a paint's dash pattern, one at a time as they are asked for,
+// so a dashed stroke never holds more than the dash it is working on
+// each dash is an open contour along the original one, with a point at every corner it goes around
+class Dasher
+{
+public:
+	// start over on the contour, with the paint's pattern (which has to be dashed)
+	// a contour that would be cut into more than MAX_DASHES comes back whole, as its one "dash"
+	void start(const GContour& contour, const GPaint& paint);
+
+	// the next dash, whose points are good until the next call, or false when there are no more
+	bool next(GContour* dash);
+
+private:
+	enum
+	{
+		MAX_DASHES = 1 << 20,
+	};
+
+	// move on to the next interval of the pattern
+	void next_interval();
+
+	GContour m_contour;
+	int m_segment_count;
+
+	// the pattern
+	float m_intervals[GPaint::kMaxDashIntervals];
+	int m_interval_count;
+
+	// where the dashing is: the segment, how far along it, the interval, how much of that interval
+	// is left, and whether it is a dash or a gap
+	int m_segment;
+	float m_distance;
+	int m_interval;
+	float m_remaining;
+	bool m_on;
+
+	// true when the whole contour is handed back as it is
+	bool m_whole;
+
+	// the points of the dash being handed out
+	std::vector<GPoint> m_points;
+};
+
+#endif
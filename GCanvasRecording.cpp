@@ -0,0 +1,252 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "GCanvasRecording.hpp"
+#include "GShaderRadial.hpp"
+#include <algorithm>
+
+GCanvasRecording::GCanvasRecording()
+{
+	this->m_ctm.setIdentity();
+	this->m_ctm_index = NO_MATRIX;
+	this->m_clip = ClipRecording::NO_CLIP;
+}
+
+void GCanvasRecording::save()
+{
+	this->m_state_stack.push({ this->m_ctm, this->m_ctm_index, this->m_clip });
+}
+
+void GCanvasRecording::restore()
+{
+	this->m_ctm = this->m_state_stack.top().ctm;
+	this->m_ctm_index = this->m_state_stack.top().ctm_index;
+	this->m_clip = this->m_state_stack.top().clip;
+	this->m_state_stack.pop();
+}
+
+void GCanvasRecording::concat(const GMatrix& matrix)
+{
+	// same math as the canvas we play back onto, so the matrices come out exactly the same
+	this->m_ctm = this->m_ctm.preConcat(matrix);
+	// typed once here so the clips and flattened paths recorded with it map their points with the cached type
+	this->m_ctm.getType();
+
+	// looked up lazily, a concat that nothing is drawn with never makes it into the table
+	this->m_ctm_index = NO_MATRIX;
+}
+
+void GCanvasRecording::clipRect(const GRect& rect)
+{
+	this->m_clip = this->m_clips.clip_rect(this->m_clip, this->m_ctm, rect);
+}
+
+void GCanvasRecording::clipPath(const GPath& path)
+{
+	this->m_clip = this->m_clips.clip_path(this->m_clip, this->m_ctm, path);
+}
+
+int GCanvasRecording::current_matrix()
+{
+	if (this->m_ctm_index == NO_MATRIX)
+	{
+		auto found = this->m_matrix_indices.find(this->m_ctm);
+		if (found != this->m_matrix_indices.end())
+		{
+			this->m_ctm_index = found->second;
+		}
+		else
+		{
+			this->m_ctm_index = (int)this->m_matrices.size();
+			this->m_matrices.push_back(this->m_ctm);
+			this->m_matrix_indices[this->m_ctm] = this->m_ctm_index;
+		}
+	}
+	return this->m_ctm_index;
+}
+
+void GCanvasRecording::clear(const GColor& color)
+{
+	ClearCommand command;
+	command.color = color;
+	this->add_command(command, COMMAND_CLEAR, NO_MATRIX);
+}
+
+void GCanvasRecording::fillBitmapRect(const GBitmap& src, const GRect& dst)
+{
+	BitmapRectCommand command;
+	command.bitmap = src;
+	command.dst = dst;
+	this->add_command(command, COMMAND_BITMAP_RECT, this->current_matrix());
+}
+
+void GCanvasRecording::drawRect(const GRect& rect, const GPaint& paint)
+{
+	RectCommand command;
+	command.paint = paint;
+	command.rect = rect;
+	this->add_command(command, COMMAND_RECT, this->current_matrix());
+}
+
+void GCanvasRecording::drawConvexPolygon(const GPoint points[], int count, const GPaint& paint)
+{
+	if (count < 3)
+	{
+		// nothing would get drawn
+		return;
+	}
+
+	ConvexPolygonCommand command;
+	command.paint = paint;
+	command.points = this->m_arena.copy_array(points, count);
+	command.count = count;
+	this->add_command(command, COMMAND_CONVEX_POLYGON, this->current_matrix());
+}
+
+void GCanvasRecording::drawContours(const GContour ctrs[], int count, const GPaint& paint)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	// copy the contours, then repoint each one at its own copy of the points
+	GContour* contours = this->m_arena.copy_array(ctrs, count);
+	for (int i = 0; i < count; ++i)
+	{
+		contours[i].fPts = this->m_arena.copy_array(ctrs[i].fPts, std::max(ctrs[i].fCount, 0));
+	}
+
+	ContoursCommand command;
+	command.paint = paint;
+	command.contours = contours;
+	command.count = count;
+	this->add_command(command, COMMAND_CONTOURS, this->current_matrix());
+}
+
+void GCanvasRecording::drawPath(const GPath& path, const GPaint& paint)
+{
+	// the curves are flattened for the ctm as it is recorded, which is what they get drawn
+	// with whenever the canvas played back onto has an identity ctm
+	this->m_path_flattener.flatten(path, this->m_ctm);
+	this->drawContours(this->m_path_flattener.contours(), this->m_path_flattener.contour_count(), paint);
+}
+
+void GCanvasRecording::drawMesh(int triCount, const GPoint pts[], const int indices[], const GColor colors[], const GPoint tex[], const GPaint& paint)
+{
+	if (triCount <= 0)
+	{
+		return;
+	}
+
+	// the mesh reads the first vertex_count entries of pts, colors and tex
+	int vertex_count = triCount * 3;
+	if (indices != nullptr)
+	{
+		vertex_count = *std::max_element(indices, indices + triCount * 3) + 1;
+	}
+
+	MeshCommand command;
+	command.paint = paint;
+	command.tri_count = triCount;
+	command.points = this->m_arena.copy_array(pts, vertex_count);
+	command.indices = (indices != nullptr ? this->m_arena.copy_array(indices, triCount * 3) : nullptr);
+	command.colors = (colors != nullptr ? this->m_arena.copy_array(colors, vertex_count) : nullptr);
+	command.tex = (tex != nullptr ? this->m_arena.copy_array(tex, vertex_count) : nullptr);
+	this->add_command(command, COMMAND_MESH, this->current_matrix());
+}
+
+GShader* GCanvasRecording::makeRadialGradient(float cx, float cy, float radius, const GColor colors[], int count)
+{
+	return new GShaderRadial(cx, cy, radius, colors, count);
+}
+
+void GCanvasRecording::playback(GCanvas* canvas) const
+{
+	// keep the canvas's own ctm and clip to come back to whenever the matrix or clip changes
+	canvas->save();
+
+	int current = NO_MATRIX;
+	int current_clip = ClipRecording::NO_CLIP;
+	for (const Command* command : this->m_commands)
+	{
+		bool matrix_changed = (command->matrix != NO_MATRIX && command->matrix != current);
+		if (matrix_changed == true || command->clip != current_clip)
+		{
+			if (current != NO_MATRIX || current_clip != ClipRecording::NO_CLIP)
+			{
+				canvas->restore();
+				canvas->save();
+			}
+
+			// the clip is in the canvas's space, and the matrix goes on top of it
+			this->m_clips.apply(command->clip, canvas);
+			current_clip = command->clip;
+			if (matrix_changed == true)
+			{
+				current = command->matrix;
+			}
+			if (current != NO_MATRIX)
+			{
+				canvas->concat(this->m_matrices[current]);
+			}
+		}
+
+		switch (command->type)
+		{
+			case COMMAND_CLEAR:
+			{
+				const ClearCommand* clear = static_cast<const ClearCommand*>(command);
+				canvas->clear(clear->color);
+				break;
+			}
+			case COMMAND_BITMAP_RECT:
+			{
+				const BitmapRectCommand* bitmap_rect = static_cast<const BitmapRectCommand*>(command);
+				canvas->fillBitmapRect(bitmap_rect->bitmap, bitmap_rect->dst);
+				break;
+			}
+			case COMMAND_RECT:
+			{
+				const RectCommand* rect = static_cast<const RectCommand*>(command);
+				canvas->drawRect(rect->rect, rect->paint);
+				break;
+			}
+			case COMMAND_CONVEX_POLYGON:
+			{
+				const ConvexPolygonCommand* polygon = static_cast<const ConvexPolygonCommand*>(command);
+				canvas->drawConvexPolygon(polygon->points, polygon->count, polygon->paint);
+				break;
+			}
+			case COMMAND_CONTOURS:
+			{
+				const ContoursCommand* contours = static_cast<const ContoursCommand*>(command);
+				canvas->drawContours(contours->contours, contours->count, contours->paint);
+				break;
+			}
+			case COMMAND_MESH:
+			{
+				const MeshCommand* mesh = static_cast<const MeshCommand*>(command);
+				canvas->drawMesh(mesh->tri_count, mesh->points, mesh->indices, mesh->colors, mesh->tex, mesh->paint);
+				break;
+			}
+		}
+	}
+
+	canvas->restore();
+}
+
+void GCanvasRecording::reset()
+{
+	this->m_arena.reset();
+	this->m_commands.clear();
+	this->m_matrices.clear();
+	this->m_matrix_indices.clear();
+	this->m_clips.clear();
+	while (this->m_state_stack.empty() == false)
+	{
+		this->m_state_stack.pop();
+	}
+	this->m_ctm.setIdentity();
+	this->m_ctm_index = NO_MATRIX;
+	this->m_clip = ClipRecording::NO_CLIP;
+}
@@ -0,0 +1,185 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef GCanvasRecording_hpp
+#define GCanvasRecording_hpp
+
+#include "include/GCanvas.h"
+#include "include/GBitmap.h"
+#include "include/GColor.h"
+#include "include/GRect.h"
+#include "include/GMatrix.h"
+#include "include/GPaint.h"
+#include "include/GPoint.h"
+#include "include/GContour.h"
+#include "Arena.hpp"
+#include "PathFlattener.hpp"
+#include "ClipRecording.hpp"
+#include <map>
+#include <stack>
+#include <vector>
+
+// a canvas that does not draw anything, it just remembers the draws so they can be
+// played back onto another canvas as many times as needed
+// the points (and everything else a draw points at) are copied into an arena once, and
+// save/concat/restore are not kept at all: every draw instead refers to the full matrix it
+// was made with, out of a table where each distinct matrix shows up once
+// shaders and bitmaps are kept by pointer, so they have to outlive the recording
+class GCanvasRecording : public GCanvas
+{
+public:
+	GCanvasRecording();
+
+	void save() override;
+	void restore() override;
+	void concat(const GMatrix& matrix) override;
+	void clipRect(const GRect& rect) override;
+	void clipPath(const GPath& path) override;
+
+	void clear(const GColor& color) override;
+	void fillBitmapRect(const GBitmap& src, const GRect& dst) override;
+	void drawRect(const GRect& rect, const GPaint& paint) override;
+	void drawConvexPolygon(const GPoint points[], int count, const GPaint& paint) override;
+	void drawContours(const GContour ctrs[], int count, const GPaint& paint) override;
+	void drawPath(const GPath& path, const GPaint& paint) override;
+	void drawMesh(int triCount, const GPoint pts[], const int indices[], const GColor colors[], const GPoint tex[], const GPaint& paint) override;
+
+	GShader* makeRadialGradient(float cx, float cy, float radius, const GColor colors[], int count) override;
+
+	// draw everything recorded onto canvas, on top of whatever its ctm is
+	// the target only sees one save/concat/restore each time the matrix (or the clip) changes
+	// between draws, the clips are made again in the target's space before the matrix
+	// when the canvas's ctm is the identity the pixels match drawing straight to it exactly,
+	// otherwise its ctm gets folded in with the recorded matrices in a different order, which
+	// can round differently
+	void playback(GCanvas* canvas) const;
+
+	// forget everything recorded (the memory is kept for the next recording)
+	void reset();
+
+	int command_count() const { return (int)this->m_commands.size(); }
+	int matrix_count() const { return (int)this->m_matrices.size(); }
+
+private:
+	enum CommandType
+	{
+		COMMAND_CLEAR,
+		COMMAND_BITMAP_RECT,
+		COMMAND_RECT,
+		COMMAND_CONVEX_POLYGON,
+		COMMAND_CONTOURS,
+		COMMAND_MESH,
+	};
+
+	// what every recorded draw starts with
+	// matrix indexes m_matrices, or is NO_MATRIX for draws that ignore the ctm
+	// clip indexes m_clips, or is ClipRecording::NO_CLIP
+	struct Command
+	{
+		CommandType type;
+		int matrix;
+		int clip;
+	};
+
+	enum
+	{
+		NO_MATRIX = -1,
+	};
+
+	struct ClearCommand : Command
+	{
+		GColor color;
+	};
+
+	struct BitmapRectCommand : Command
+	{
+		GBitmap bitmap;
+		GRect dst;
+	};
+
+	struct RectCommand : Command
+	{
+		GPaint paint;
+		GRect rect;
+	};
+
+	struct ConvexPolygonCommand : Command
+	{
+		GPaint paint;
+		const GPoint* points;
+		int count;
+	};
+
+	// the contours point at points in the arena, so they get handed over as is
+	struct ContoursCommand : Command
+	{
+		GPaint paint;
+		const GContour* contours;
+		int count;
+	};
+
+	struct MeshCommand : Command
+	{
+		GPaint paint;
+		int tri_count;
+		const GPoint* points;
+		const int* indices;
+		const GColor* colors;
+		const GPoint* tex;
+	};
+
+	// orders matrices by their entries, so identical ones can be found in m_matrix_indices
+	struct MatrixLess
+	{
+		bool operator()(const GMatrix& a, const GMatrix& b) const
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				if (a[i] != b[i])
+				{
+					return a[i] < b[i];
+				}
+			}
+			return false;
+		}
+	};
+
+	// copy a command into the arena and add it to the list
+	template <typename T>
+	void add_command(T command, CommandType type, int matrix)
+	{
+		command.type = type;
+		command.matrix = matrix;
+		command.clip = this->m_clip;
+		this->m_commands.push_back(this->m_arena.make(command));
+	}
+
+	// the index of the current ctm in m_matrices, adding it the first time it is drawn with
+	int current_matrix();
+
+	Arena m_arena;
+	std::vector<const Command*> m_commands;
+
+	// the distinct matrices the draws were made with
+	std::vector<GMatrix> m_matrices;
+	std::map<GMatrix, int, MatrixLess> m_matrix_indices;
+
+	// the clips the draws were made inside of
+	ClipRecording m_clips;
+
+	// turns paths into contours for drawPath, keeping its buffers between them
+	PathFlattener m_path_flattener;
+
+	// the ctm as the draws come in, with its index once it has one (or NO_MATRIX), and the clip
+	struct SavedState
+	{
+		GMatrix ctm;
+		int ctm_index;
+		int clip;
+	};
+	std::stack<SavedState> m_state_stack;
+	GMatrix m_ctm;
+	int m_ctm_index;
+	int m_clip;
+};
+
+#endif
@@ -4,29 +4,19 @@
 
 #include "GCanvasSteffey.hpp"
 #include <cstring>
+#include <cmath>
+#include <algorithm>
 #include "GShaderBitmapSteffey.hpp"
-#include "GShaderColorTriangle.hpp"
-#include "GShaderBitmapProxy.hpp"
-#include "GShaderCompose.hpp"
 #include <iostream>
 #include "utils.hpp"
+#include "Blitter.hpp"
+#include "MeshRasterizer.hpp"
+#include "include/GPath.h"
 
 GCanvas* GCanvas::Create(const GBitmap& bitmap)
 {
 	// sanity checks for valid GBitmap
-	if (bitmap.width() < 0)
-	{
-		return NULL;
-	}
-	if (bitmap.height() < 0)
-	{
-		return NULL;
-	}
-	if (bitmap.pixels() == NULL)
-	{
-		return NULL;
-	}
-	if (bitmap.rowBytes() < 4 * bitmap.width())
+	if (is_valid_bitmap(bitmap) == false)
 	{
 		return NULL;
 	}
@@ -42,6 +32,58 @@ GCanvasSteffey::GCanvasSteffey(const GBitmap& bitmap)
 
 	// no ctm for now
 	this->m_global_ctm_current.setIdentity();
+
+	// draw everywhere on the bitmap
+	this->m_device_clip = GIRect::MakeWH(bitmap.width(), bitmap.height());
+	this->m_clip.bounds = this->m_device_clip;
+	this->m_draw_clip = this->m_device_clip;
+}
+
+void GCanvasSteffey::set_device_clip(const GIRect& clip)
+{
+	// only allow clips inside of the bitmap
+	this->m_device_clip = GIRect::MakeWH(this->m_bitmap->width(), this->m_bitmap->height());
+	if (this->m_device_clip.intersect(clip) == false)
+	{
+		this->m_device_clip = GIRect::MakeWH(0, 0);
+	}
+	this->update_draw_clip();
+}
+
+void GCanvasSteffey::update_draw_clip()
+{
+	this->m_draw_clip = this->m_device_clip;
+	if (this->m_draw_clip.intersect(this->m_clip.bounds) == false)
+	{
+		this->m_draw_clip = GIRect::MakeWH(0, 0);
+	}
+}
+
+std::shared_ptr<ClipMask> GCanvasSteffey::unused_mask()
+{
+	// only m_masks holding on to it means no clip (saved, current or on another canvas) uses it
+	for (const std::shared_ptr<ClipMask>& mask : this->m_masks)
+	{
+		if (mask.use_count() == 1)
+		{
+			return mask;
+		}
+	}
+	this->m_masks.push_back(std::make_shared<ClipMask>());
+	return this->m_masks.back();
+}
+
+void GCanvasSteffey::set_clip_state(const ClipState& clip)
+{
+	this->m_clip = clip;
+	this->update_draw_clip();
+}
+
+GRect GCanvasSteffey::edge_clip_rect() const
+{
+	// the clip's bounds, which are never bigger than the bitmap
+	const GIRect& bounds = this->m_clip.bounds;
+	return GRect::MakeLTRB(bounds.fLeft, bounds.fTop, bounds.fRight, bounds.fBottom);
 }
 
 GCanvasSteffey::~GCanvasSteffey()
@@ -51,33 +93,57 @@ GCanvasSteffey::~GCanvasSteffey()
 
 void GCanvasSteffey::clear(const GColor& color)
 {
-	// clear the entire bitmap to the given color
+	// clear the entire bitmap (inside the clip) to the given color
+	const GIRect& clip = this->m_draw_clip;
+	if (clip.isEmpty() == true)
+	{
+		return;
+	}
 	
 	// first convert that nasty GColor into an GPixel
 	GPixel new_pixel = convert_color_to_pixel(color.pinToUnit());
+
+	if (this->m_clip.mask != nullptr)
+	{
+		// just the runs of the mask on each row
+		size_t row_pixels = this->m_bitmap->rowBytes() >> 2;
+		for (int y = clip.fTop; y < clip.fBottom; ++y)
+		{
+			GPixel* row = this->m_bitmap->pixels() + row_pixels * y;
+			this->m_clip.mask->for_each_run(y, clip.fLeft, clip.fRight, [row, new_pixel] (int left, int right)
+				{
+					for (int x = left; x < right; ++x)
+					{
+						row[x] = new_pixel;
+					}
+				}
+			);
+		}
+		return;
+	}
 	
-	// get pointer to beginning of pixels of the bitmap
-	GPixel* pixels = this->m_bitmap->pixels();
+	// get pointer to the first pixel of the clip
+	GPixel* first_row = this->m_bitmap->pixels() + (this->m_bitmap->rowBytes() >> 2) * clip.fTop + clip.fLeft;
 	
 	// get pointer to beginning of first row
-	GPixel* row = pixels;
+	GPixel* row = first_row;
 	
 	// set all pixels in the first row to the color
-	for (int x = 0; x < this->m_bitmap->width(); ++x)
+	for (int x = 0; x < clip.width(); ++x)
 	{
 		row[x] = new_pixel;
 	}
 	
 	// now memcpy the first row to all subsequent rows..the entire row at a time
 	// this is faster than continuing to set each pixel at a time
-	for (int y = 1; y < this->m_bitmap->height(); ++y)
+	for (int y = clip.fTop + 1; y < clip.fBottom; ++y)
 	{
 		// advance the pointer to the next row by the number of pixels wide
 		// the actual bitmap memory takes up, which is number bytes / 4
 		row += (this->m_bitmap->rowBytes() >> 2);
 		
 		// copy the first row to the current row
-		std::memcpy(row, pixels, this->m_bitmap->rowBytes());
+		std::memcpy(row, first_row, clip.width() * sizeof(GPixel));
 	}
 }
 
@@ -104,26 +170,150 @@ void GCanvasSteffey::fillBitmapRect(const GBitmap& src, const GRect& dst)
 
 void GCanvasSteffey::save()
 {
-	// push the current matrix on the stack
-	this->m_global_ctm_stack.push(this->m_global_ctm_current);
+	// push the current matrix and clip on the stack
+	this->m_state_stack.push({ this->m_global_ctm_current, this->m_clip });
 }
 
 void GCanvasSteffey::restore()
 {
-	// make the current matrix the top element of the stack
-	this->m_global_ctm_current = this->m_global_ctm_stack.top();
+	// make the current matrix and clip the top element of the stack
+	this->m_global_ctm_current = this->m_state_stack.top().ctm;
+	this->m_clip = this->m_state_stack.top().clip;
 	// then pop it off the stack
-	this->m_global_ctm_stack.pop();
+	this->m_state_stack.pop();
+	this->update_draw_clip();
 }
 
 void GCanvasSteffey::concat(const GMatrix& matrix)
 {
 	// set up the matrix so that CTM = CTM * matrix
 	this->m_global_ctm_current = this->m_global_ctm_current.preConcat(matrix);
+
+	// work out its type once here, so every draw until the next concat maps its points with
+	// the remembered type (mapPoints only reads it, it never remembers it itself)
+	this->m_global_ctm_current.getType();
+}
+
+void GCanvasSteffey::clipRect(const GRect& rect)
+{
+	const GMatrix& ctm = this->m_global_ctm_current;
+	GPoint corners[] = { GPoint::Make(rect.fLeft, rect.fTop), GPoint::Make(rect.fRight, rect.fTop),
+						 GPoint::Make(rect.fRight, rect.fBottom), GPoint::Make(rect.fLeft, rect.fBottom) };
+	if (ctm.getType() & GMatrix::kAffine_Mask)
+	{
+		// turned, so it is a path
+		GContour contour = { 4, corners, true };
+		this->clip_contours(&contour, 1);
+		return;
+	}
+
+	GPoint device[4];
+	ctm.mapPoints(device, corners, 4);
+	float left = std::min(device[0].fX, device[2].fX);
+	float right = std::max(device[0].fX, device[2].fX);
+	float top = std::min(device[0].fY, device[2].fY);
+	float bottom = std::max(device[0].fY, device[2].fY);
+	if (!(left < right && top < bottom))
+	{
+		// no area (or not a number), so nothing is left
+		this->m_clip.bounds = GIRect::MakeWH(0, 0);
+		this->update_draw_clip();
+		return;
+	}
+
+	// keep the pixels whose centers are inside, pinned to the bitmap first so the
+	// conversion to int cannot overflow
+	float width = (float)this->m_bitmap->width();
+	float height = (float)this->m_bitmap->height();
+	GIRect pixels = GIRect::MakeLTRB((int)std::floor(std::min(std::max(left, 0.0f), width) + 0.5f),
+		(int)std::floor(std::min(std::max(top, 0.0f), height) + 0.5f),
+		(int)std::floor(std::min(std::max(right, 0.0f), width) + 0.5f),
+		(int)std::floor(std::min(std::max(bottom, 0.0f), height) + 0.5f));
+	if (this->m_clip.bounds.intersect(pixels) == false)
+	{
+		this->m_clip.bounds = GIRect::MakeWH(0, 0);
+	}
+	this->update_draw_clip();
+}
+
+void GCanvasSteffey::clipPath(const GPath& path)
+{
+	this->m_path_flattener.flatten(path, this->m_global_ctm_current);
+	this->clip_contours(this->m_path_flattener.contours(), this->m_path_flattener.contour_count());
+}
+
+void GCanvasSteffey::clip_contours(const GContour contours[], int count)
+{
+	// the new bounds are the pixels the contours' bounds could touch, so like the old ones they
+	// do not depend on the device clip
+	GIRect bounds = GIRect::MakeWH(0, 0);
+	bool has_points = false;
+	float left = 0, top = 0, right = 0, bottom = 0;
+	std::vector<GPoint>& device_points = this->m_device_points;
+	for (int i = 0; i < count; ++i)
+	{
+		if (contours[i].fCount < 3)
+		{
+			continue;
+		}
+		device_points.resize(contours[i].fCount);
+		this->m_global_ctm_current.mapPoints(device_points.data(), contours[i].fPts, contours[i].fCount);
+		for (const GPoint& p : device_points)
+		{
+			if (has_points == false)
+			{
+				left = right = p.fX;
+				top = bottom = p.fY;
+				has_points = true;
+			}
+			left = std::min(left, p.fX);
+			top = std::min(top, p.fY);
+			right = std::max(right, p.fX);
+			bottom = std::max(bottom, p.fY);
+		}
+	}
+	if (has_points == true && std::isfinite(left + top + right + bottom) == true)
+	{
+		float width = (float)this->m_bitmap->width();
+		float height = (float)this->m_bitmap->height();
+		bounds = GIRect::MakeLTRB((int)std::floor(std::min(std::max(left, 0.0f), width)),
+			(int)std::floor(std::min(std::max(top, 0.0f), height)),
+			(int)std::ceil(std::min(std::max(right, 0.0f), width)),
+			(int)std::ceil(std::min(std::max(bottom, 0.0f), height)));
+	}
+
+	// scan convert the contours with the old clip still in place, keeping just the runs inside
+	// of it (and only the rows any draw here could use)
+	GIRect within = this->m_draw_clip;
+	if (within.intersect(bounds) == false)
+	{
+		within = GIRect::MakeWH(0, 0);
+	}
+	ClipMaskBuilder& builder = this->m_mask_builder;
+	builder.start(within, this->m_clip.mask.get());
+	if (within.isEmpty() == false && this->build_contour_edges(contours, count) == true)
+	{
+		this->walk_contour_edges(builder);
+	}
+	std::shared_ptr<ClipMask> mask = this->unused_mask();
+	builder.finish(mask.get());
+	this->m_clip.mask = mask;
+
+	if (this->m_clip.bounds.intersect(bounds) == false)
+	{
+		this->m_clip.bounds = GIRect::MakeWH(0, 0);
+	}
+	this->update_draw_clip();
 }
 
 void GCanvasSteffey::drawRect(const GRect& rect, const GPaint& paint)
 {
+	// rects that stay lined up with the pixel grid do not need edges at all
+	if (paint.isAntiAlias() == false && this->fill_axis_aligned_rect(rect, paint) == true)
+	{
+		return;
+	}
+
 	// make points out of the 4 corners of the rect
 	GPoint points[] = { GPoint::Make(rect.fLeft, rect.fTop), GPoint::Make(rect.fRight, rect.fTop),
 						GPoint::Make(rect.fRight, rect.fBottom), GPoint::Make(rect.fLeft, rect.fBottom) };
@@ -132,6 +322,67 @@ void GCanvasSteffey::drawRect(const GRect& rect, const GPaint& paint)
 	this->drawConvexPolygon(points, 4, paint);
 }
 
+bool GCanvasSteffey::fill_axis_aligned_rect(const GRect& rect, const GPaint& paint)
+{
+	// only a ctm that scales and translates keeps the rect a rect
+	const GMatrix& ctm = this->m_global_ctm_current;
+	if (ctm[GMatrix::KX] != 0.0f || ctm[GMatrix::KY] != 0.0f)
+	{
+		return false;
+	}
+
+	// map two opposite corners the same way drawConvexPolygon maps all four
+	GPoint corner0 = ctm.mapPt(GPoint::Make(rect.fLeft, rect.fTop));
+	GPoint corner1 = ctm.mapPt(GPoint::Make(rect.fRight, rect.fBottom));
+	float left = std::min(corner0.fX, corner1.fX);
+	float right = std::max(corner0.fX, corner1.fX);
+	float top = std::min(corner0.fY, corner1.fY);
+	float bottom = std::max(corner0.fY, corner1.fY);
+	if (std::isfinite(left) == false || std::isfinite(right) == false || std::isfinite(top) == false || std::isfinite(bottom) == false)
+	{
+		// let the edge code deal with it
+		return false;
+	}
+
+	// now work out the rows and columns just like the two vertical edges of the polygon would,
+	// clipped to the clip's bounds and rounded to pixel centers
+	GRect clip_rect = this->edge_clip_rect();
+	if (bottom < clip_rect.fTop || top > clip_rect.fBottom)
+	{
+		// all of it is above or below the clip
+		return true;
+	}
+	int y_min = (int)(std::max(top, clip_rect.fTop) + 0.5f);
+	int y_max = (int)(std::min(bottom, clip_rect.fBottom) + 0.5f);
+	if (y_min == y_max)
+	{
+		// too thin to cover a pixel center
+		return true;
+	}
+
+	// the columns come from edges pinned to the sides of the clip, stepped in fixed point
+	// if the polygon's would be, so they land on the same pixels
+	bool use_fixed_point = this->can_step_edges_in_fixed_point();
+	PolygonEdge left_edge(y_min, y_max, 0.0f, std::min(std::max(left, clip_rect.fLeft), clip_rect.fRight), 1);
+	PolygonEdge right_edge(y_min, y_max, 0.0f, std::min(std::max(right, clip_rect.fLeft), clip_rect.fRight), -1);
+	if (use_fixed_point == true)
+	{
+		left_edge.use_fixed_point();
+		right_edge.use_fixed_point();
+	}
+
+	// work out how we are going to blend the paint
+	Blitter blitter(*this->m_bitmap, paint, ctm, this->m_draw_clip, this->m_clip.mask.get());
+	if (blitter.is_visible() == false)
+	{
+		// nothing this paint draws will change a pixel
+		return true;
+	}
+
+	blitter.blit_rect(GIRect::MakeLTRB(left_edge.current_pixel(), y_min, right_edge.current_pixel(), y_max));
+	return true;
+}
+
 void GCanvasSteffey::drawConvexPolygon(const GPoint points[], int count, const GPaint& paint)
 {
 	// not enough points
@@ -141,35 +392,93 @@ void GCanvasSteffey::drawConvexPolygon(const GPoint points[], int count, const G
 		return;
 	}
 
-	// create the clip rect the size of our canvas/bitmap
-	GRect clip_rect = GRect::MakeWH(this->m_bitmap->width(), this->m_bitmap->height());
+	// anti-aliased polygons go through the coverage rasterizer
+	if (paint.isAntiAlias() == true)
+	{
+		GContour contour = { count, points, true };
+		this->draw_contours_antialiased(&contour, 1, paint);
+		return;
+	}
+
+	// map the points once, into the canvas's buffer for them
+	std::vector<GPoint>& device_points = this->m_device_points;
+	device_points.resize(count);
+	this->m_global_ctm_current.mapPoints(device_points.data(), points, count);
+
+	if (this->build_convex_edges(device_points.data(), count) == false)
+	{
+		// nothing to draw
+		return;
+	}
+
+	// work out how we are going to blend the paint
+	Blitter blitter(*this->m_bitmap, paint, this->m_global_ctm_current, this->m_draw_clip, this->m_clip.mask.get());
+	if (blitter.is_visible() == false)
+	{
+		// nothing this paint draws will change a pixel
+		return;
+	}
+
+	// will it blend ?!?
+	this->walk_convex_edges(blitter);
+}
+
+bool GCanvasSteffey::build_convex_edges(const GPoint device_points[], int count)
+{
+	// the edges get clipped to the clip's bounds
+	GRect clip_rect = this->edge_clip_rect();
 
 
-	// vector to hold our edges
-	std::vector<PolygonEdge> edges;
+	// the canvas's edge buffer, so small polygons do not allocate
+	std::vector<PolygonEdge>& edges = this->m_edges;
+	edges.clear();
 
-	// foreach pair of points, send to the create_and_clip_polygon_edges 
-	for (int i = 0; i < count - 1; ++i)
+	// foreach pair of points that reaches the rows of the draw clip, send to the create_and_clip_polygon_edges 
+	int top = this->m_draw_clip.fTop;
+	int bottom = this->m_draw_clip.fBottom;
+	for (int i = 0; i < count; ++i)
 	{
-		GPoint p1 = this->m_global_ctm_current.mapPt(points[i]);
-		GPoint p2 = this->m_global_ctm_current.mapPt(points[i + 1]);
-		GCanvasSteffey::create_and_clip_polygon_edges(p1, p2, clip_rect, edges);
+		const GPoint& p0 = device_points[i];
+		const GPoint& p1 = device_points[i + 1 < count ? i + 1 : 0];
+		if (GCanvasSteffey::edge_crosses_rows(p0, p1, top, bottom) == true)
+		{
+			GCanvasSteffey::create_and_clip_polygon_edges(p0, p1, clip_rect, edges);
+		}
 	}
-	// from last point to first point
-	GCanvasSteffey::create_and_clip_polygon_edges(this->m_global_ctm_current.mapPt(points[count - 1]), this->m_global_ctm_current.mapPt(points[0]), clip_rect, edges);
 
+	// the pieces an edge gets split into at the sides of the clip can still miss the rows
+	edges.erase(std::remove_if(edges.begin(), edges.end(), [top, bottom] (const PolygonEdge& edge)
+		{
+			return edge.y_max <= top || edge.y_min >= bottom;
+		}
+	), edges.end());
 
 	// check to see if we got any edges
 	if (edges.size() < 2)
 	{
 		// nothing to draw
-		return;
+		return false;
 	}
 
-	// now sort our edges
-	GCanvasSteffey::sort_polygon_edges(edges);
+	// now sort our edges (this can swap another buffer in for them)
+	this->sort_polygon_edges();
+
+	// step in fixed point when the matrix keeps things lined up on the pixel grid
+	if (this->can_step_edges_in_fixed_point() == true)
+	{
+		for (PolygonEdge& edge : edges)
+		{
+			edge.use_fixed_point();
+		}
+	}
+	return true;
+}
+
+template <typename RowBlitter>
+void GCanvasSteffey::walk_convex_edges(RowBlitter& blitter)
+{
+	std::vector<PolygonEdge>& edges = this->m_edges;
 
-	// draw
 	// get left edge
 	PolygonEdge* left_edge = &(edges[0]);
 
@@ -182,61 +491,42 @@ void GCanvasSteffey::drawConvexPolygon(const GPoint points[], int count, const G
 	// init our first scanline
 	int current_scanline = left_edge->y_min;
 
-	// convert that silly color into a pixel if needed (i.e. not using a shader)
-	GPixel pixel;
-	int pixel_alpha = 0;
-	if (paint.getShader() == nullptr)
-	{
-		pixel = convert_color_to_pixel(paint.getColor().pinToUnit());
-		pixel_alpha = GPixel_GetA(pixel);
-	}
-	else
+	// the edges that ended above the draw clip were never built, so when the polygon starts
+	// above it the first two edges are the ones crossing its top row (a tile's band, when it is
+	// one of many), which move straight down to it
+	int top = this->m_draw_clip.fTop;
+	if (current_scanline < top)
 	{
-		// we have a shader so set its context
-		paint.getShader()->setContext(this->m_global_ctm_current, paint.getAlpha());
+		current_scanline = top;
+		left_edge->advance(top - left_edge->y_min);
+		if (right_edge->y_min < top)
+		{
+			right_edge->advance(top - right_edge->y_min);
+		}
 	}
 
 	// keep LOOPING forever and ever and ever...but return from the function when we are out of edges
 	while (true)
 	{
-		// get the starting and ending x coords for this scanline
-		int start_x = (int)(left_edge->x_current + 0.5f);
-		int end_x = (int)(right_edge->x_current + 0.5f);
-
-		// get the destination pixels
-		GPixel* dest_pixels = this->m_bitmap->pixels() + ((this->m_bitmap->rowBytes() >> 2) * current_scanline);
-		dest_pixels += start_x;
-
-		// will it blend ?!?
-		if (paint.getShader() != nullptr)
-		{
-			// do it with the shader
-			GPixel buffer[256];
-			int count = end_x - start_x;
-			while (count > 0)
-			{
-				int n = std::min(count, 256);
-				paint.getShader()->shadeRow(start_x, current_scanline, n, buffer);
-				GCanvasSteffey::blend(buffer, dest_pixels, n);
-				count -= n;
-				start_x += n;
-				dest_pixels += n;
-			}
-		}
-		else
+		// get the starting and ending x coords for this scanline, which edge is on the left can
+		// change when one starts where another did (like the pieces split off at the sides of the clip)
+		int start_x = left_edge->current_pixel();
+		int end_x = right_edge->current_pixel();
+		if (end_x < start_x)
 		{
-			// do it with the color
-			if (pixel_alpha == 255)
-			{
-				GCanvasSteffey::blend_opaque(pixel, dest_pixels, end_x - start_x + 0);
-			}
-			else
-			{
-				GCanvasSteffey::blend(pixel, dest_pixels, end_x - start_x + 0);
-			}
+			std::swap(start_x, end_x);
 		}
+
+		// will it blend ?!?
+		blitter.blit_row(start_x, current_scanline, end_x - start_x);
+
 		// advance the scanline
 		++current_scanline;
+		if (current_scanline >= this->m_draw_clip.fBottom)
+		{
+			// the rest is below the device clip
+			return;
+		}
 
 		// determine if we ran out of scanlines on the left edge
 		if (current_scanline == left_edge->y_max)
@@ -251,7 +541,7 @@ void GCanvasSteffey::drawConvexPolygon(const GPoint points[], int count, const G
 		}
 		else
 		{
-			left_edge->x_current += left_edge->m_slope;
+			left_edge->step();
 		}
 
 		// determine if we ran out of scanlines on the right edge
@@ -267,11 +557,17 @@ void GCanvasSteffey::drawConvexPolygon(const GPoint points[], int count, const G
 		}
 		else
 		{
-			right_edge->x_current += right_edge->m_slope;
+			right_edge->step();
 		}
 	}
 }
 
+void GCanvasSteffey::drawPath(const GPath& path, const GPaint& paint)
+{
+	this->m_path_flattener.flatten(path, this->m_global_ctm_current);
+	this->drawContours(this->m_path_flattener.contours(), this->m_path_flattener.contour_count(), paint);
+}
+
 void GCanvasSteffey::drawContours(const GContour ctrs[], int count, const GPaint& paint)
 {
 	#ifdef _VERBOSE
@@ -287,16 +583,6 @@ void GCanvasSteffey::drawContours(const GContour ctrs[], int count, const GPaint
 		std::cout << std::endl;
 	#endif
 
-	// create the clip rect the size of our canvas/bitmap
-	GRect clip_rect = GRect::MakeWH(this->m_bitmap->width(), this->m_bitmap->height());
-
-	#ifdef _VERBOSE
-		std::cout << "clip_rect: " << convert_grect_to_string(clip_rect) << std::endl;
-	#endif
-	
-	// vector to hold our edges
-	std::vector<PolygonEdge> edges;
-
 	// check if stroking
 	if (paint.isStroke() == true)
 	{
@@ -305,186 +591,159 @@ void GCanvasSteffey::drawContours(const GContour ctrs[], int count, const GPaint
 
 	}
 
-	// put all the contours into an edge list
-	for (int i = 0; i < count; ++i)
+	// anti-aliased contours go through the coverage rasterizer
+	if (paint.isAntiAlias() == true)
 	{
-		// need at least 3 points for a contour
-		if (ctrs[i].fCount >= 3)
-		{
-			// foreach pair of points, send to the create_and_clip_polygon_edges 
-			for (int j = 0; j < ctrs[i].fCount - 1; ++j)
-			{
-				GPoint p1 = this->m_global_ctm_current.mapPt(ctrs[i].fPts[j]);
-				GPoint p2 = this->m_global_ctm_current.mapPt(ctrs[i].fPts[j + 1]);
-
-				GCanvasSteffey::create_and_clip_polygon_edges(p1, p2, clip_rect, edges);
-			}
-			// from last point to first point
-			GCanvasSteffey::create_and_clip_polygon_edges(this->m_global_ctm_current.mapPt(ctrs[i].fPts[ctrs[i].fCount - 1]),
-				this->m_global_ctm_current.mapPt(ctrs[i].fPts[0]), clip_rect, edges);
-		}
+		this->draw_contours_antialiased(ctrs, count, paint);
+		return;
 	}
 
-	// check to see if we got any edges
-	if (edges.size() < 2)
+	if (this->build_contour_edges(ctrs, count) == false)
 	{
 		// nothing to draw
 		return;
 	}
 
-	// now sort all our edges in y and then x
-	GCanvasSteffey::sort_polygon_edges(edges);
-
-	#ifdef _VERBOSE
-		std::cout << "polygon edges sorted: \n";
-		std::cout << convert_edge_list_to_string(edges) << "\n";
-	#endif
-
-	// convert that silly color into a pixel if needed (i.e. not using a shader)
-	GPixel pixel;
-	int pixel_alpha = 0;
-	if (paint.getShader() == nullptr)
-	{
-		pixel = convert_color_to_pixel(paint.getColor().pinToUnit());
-		pixel_alpha = GPixel_GetA(pixel);
-	}
-	else
+	// work out how we are going to blend the paint
+	Blitter blitter(*this->m_bitmap, paint, this->m_global_ctm_current, this->m_draw_clip, this->m_clip.mask.get());
+	if (blitter.is_visible() == false)
 	{
-		// we have a shader so set its context
-		paint.getShader()->setContext(this->m_global_ctm_current, paint.getAlpha());
+		// nothing this paint draws will change a pixel
+		return;
 	}
 
-	// maintain a list of current drawing edges
-	std::vector<PolygonEdge*> drawing_edges;
-
-	// store index to next edge to check in the edge vector
-	int next_edge_index = 0;
-
-	// init our first scanline
-	int current_scanline = 0;
-
-	// keep track of checking if we need to sort
-	bool need_to_sort = true;
+	this->walk_contour_edges(blitter);
+}
 
-	// loop forever and ever and ever....or at least until we run out of edges and return
-	while (true)
+bool GCanvasSteffey::build_contour_edges(const GContour ctrs[], int count)
+{
+	// the edges get clipped to the clip's bounds
+	GRect clip_rect = this->edge_clip_rect();
+
+	// put all the contours into the canvas's edge buffer
+	int top = this->m_draw_clip.fTop;
+	int bottom = this->m_draw_clip.fBottom;
+	std::vector<PolygonEdge>& edges = this->m_edges;
+	edges.clear();
+	std::vector<GPoint>& device_points = this->m_device_points;
+	for (int i = 0; i < count; ++i)
 	{
-		// determine if any edges need to be removed
-		for (int i = 0; i < drawing_edges.size(); ++i)
+		// need at least 3 points for a contour
+		if (ctrs[i].fCount >= 3)
 		{
-			if (drawing_edges[i]->y_max <= current_scanline)
+			// map each point once, it is the end of one edge and the start of the next
+			int point_count = ctrs[i].fCount;
+			device_points.resize(point_count);
+			this->m_global_ctm_current.mapPoints(device_points.data(), ctrs[i].fPts, point_count);
+
+			// foreach pair of points that reaches the rows of the draw clip, send to the create_and_clip_polygon_edges 
+			for (int j = 0; j < point_count; ++j)
 			{
-				drawing_edges.erase(drawing_edges.begin() + i);
-				--i;
-				need_to_sort = true;
+				const GPoint& p0 = device_points[j];
+				const GPoint& p1 = device_points[j + 1 < point_count ? j + 1 : 0];
+				if (GCanvasSteffey::edge_crosses_rows(p0, p1, top, bottom) == true)
+				{
+					GCanvasSteffey::create_and_clip_polygon_edges(p0, p1, clip_rect, edges);
+				}
 			}
 		}
+	}
 
-		// determine if any other edges need to be added
-		if (drawing_edges.size() == 0)
+	// check to see if we got any edges
+	return edges.size() >= 2;
+}
+
+template <typename RowBlitter>
+void GCanvasSteffey::walk_contour_edges(RowBlitter& blitter)
+{
+	std::vector<PolygonEdge>& edges = this->m_edges;
+
+	// step in fixed point when the matrix keeps things lined up on the pixel grid
+	bool use_fixed_point = this->can_step_edges_in_fixed_point();
+
+	// only the rows of the draw clip get walked (a tile's band, when it is one of many), the
+	// edges that do not reach them are dropped and the ones that start above jump straight down
+	// the edges are clipped to the canvas so every y_min is in range
+	int top = this->m_draw_clip.fTop;
+	int bottom = this->m_draw_clip.fBottom;
+	int height = this->m_bitmap->height();
+	if ((int)this->m_edge_buckets.size() < height + 1)
+	{
+		this->m_edge_buckets.resize(height + 1, nullptr);
+	}
+	int first_scanline = height;
+	int last_scanline = 0;
+	for (PolygonEdge& edge : edges)
+	{
+		if (edge.y_max <= top || edge.y_min >= bottom)
 		{
-			// make sure we still have enough edges for drawing
-			if (next_edge_index >= edges.size())
-			{
-				// out of edges, means we are done drawing
-				return;
-			}
-			// just add in the first edge
-			drawing_edges.push_back(&(edges[next_edge_index]));
-			next_edge_index += 1;
-			current_scanline = drawing_edges[0]->y_min;
-			need_to_sort = true;
+			// a piece of an edge that got split at the sides of the clip can still miss them
+			continue;
 		}
-		for (int i = next_edge_index; i < edges.size(); ++i)
+		if (use_fixed_point == true)
 		{
-			if (edges[i].y_min == current_scanline)
-			{
-				drawing_edges.push_back(&(edges[i]));
-				next_edge_index += 1;
-				need_to_sort = true;
-			}
-			else
-			{
-				// break out of the for loop
-				break;
-			}
+			edge.use_fixed_point();
+		}
+		int start = edge.y_min;
+		if (start < top)
+		{
+			edge.advance(top - start);
+			start = top;
 		}
+		edge.next = this->m_edge_buckets[start];
+		this->m_edge_buckets[start] = &edge;
+		first_scanline = std::min(first_scanline, start);
+		last_scanline = std::max(last_scanline, edge.y_max);
+	}
 
-		// ensure edges are sorted for drawing
-		if (need_to_sort == true)
+	// the active edges, always kept sorted by their current x
+	std::vector<PolygonEdge*>& active_edges = this->m_active_edges;
+	active_edges.clear();
+
+	// every edge left starts above the bottom of the draw clip, and nothing below it gets drawn
+	int stop_scanline = std::min(last_scanline, bottom);
+
+	for (int current_scanline = first_scanline; current_scanline < stop_scanline; ++current_scanline)
+	{
+		// bring in the edges that start here
+		if (this->m_edge_buckets[current_scanline] != nullptr)
 		{
-			GCanvasSteffey::sort_polygon_drawing_edges(drawing_edges);
+			GCanvasSteffey::merge_new_edges(this->m_edge_buckets[current_scanline], active_edges, this->m_new_edges);
+			this->m_edge_buckets[current_scanline] = nullptr;
 		}
-		need_to_sort = false;
 
 		#ifdef _VERBOSE
 			std::cout << "\nscanline sorted polygon drawing edges\n";
-			std::cout << convert_edge_list_to_string(drawing_edges);
+			std::cout << convert_edge_list_to_string(active_edges);
 		#endif
 
-		// start our accumulator at 0
-		int edge_orientation_accumulator = 0;
-
 		// go through the edges looking for start and stop pixel runs to send to the renderer
-		for (int i = 0; i < drawing_edges.size(); ++i)
+		int edge_count = (int)active_edges.size();
+		for (int i = 0; i < edge_count; ++i)
 		{
-			// reset the orientation accumulator
-			edge_orientation_accumulator = 0;
-
 			// calculate the start x
-			int start_x = (int)(drawing_edges[i]->x_current + 0.5f);
+			int start_x = active_edges[i]->current_pixel();
 
-			// update the orientation accumulator
-			edge_orientation_accumulator += drawing_edges[i]->m_orientation;
+			// start the accumulator with this edge
+			int edge_orientation_accumulator = active_edges[i]->m_orientation;
 
 			// look for the end
-			for (int j = i + 1; j < drawing_edges.size(); ++j)
+			for (int j = i + 1; j < edge_count; ++j)
 			{
-				edge_orientation_accumulator += drawing_edges[j]->m_orientation;
+				edge_orientation_accumulator += active_edges[j]->m_orientation;
 
 				// if the accumulator is 0 then we stop drawing here
 				if (edge_orientation_accumulator == 0)
 				{
 					// this edge marks an end to a run
-					int end_x = (int)(drawing_edges[j]->x_current + 0.5f);
+					int end_x = active_edges[j]->current_pixel();
 
 					#ifdef _VERBOSE
 						std::cout << "scanline=" << current_scanline << "\tstart=" << start_x << "\tend=" << (end_x - 0) << "\n";
 					#endif
 
 					// draw the run from start to end
-					// get the destination pixels
-					GPixel* dest_pixels = this->m_bitmap->pixels() + ((this->m_bitmap->rowBytes() >> 2) * current_scanline);
-					dest_pixels += start_x;
-
-					// will it blend ?!?
-					if (paint.getShader() != nullptr)
-					{
-						// do it with the shader
-						GPixel buffer[256];
-						int count = end_x - start_x;
-						while (count > 0)
-						{
-							int n = std::min(count, 256);
-							paint.getShader()->shadeRow(start_x, current_scanline, n, buffer);
-							GCanvasSteffey::blend(buffer, dest_pixels, n);
-							count -= n;
-							start_x += n;
-							dest_pixels += n;
-						}
-					}
-					else
-					{
-						// do it with the color
-						if (pixel_alpha == 255)
-						{
-							GCanvasSteffey::blend_opaque(pixel, dest_pixels, end_x - start_x + 0);
-						}
-						else
-						{
-							GCanvasSteffey::blend(pixel, dest_pixels, end_x - start_x + 0);
-						}
-					}
+					blitter.blit_row(start_x, current_scanline, end_x - start_x);
 
 					// update i to be the next edge after j
 					i = j;
@@ -495,138 +754,273 @@ void GCanvasSteffey::drawContours(const GContour ctrs[], int count, const GPaint
 			}
 		}
 
-		// before going to the next scanline we update all the x_currents
-		drawing_edges[0]->x_current += drawing_edges[0]->m_slope;
-		for (int i = 1; i < drawing_edges.size(); ++i)
+		// before going to the next scanline drop the finished edges and step the rest
+		int keep = 0;
+		bool need_to_sort = false;
+		for (int i = 0; i < edge_count; ++i)
 		{
-			drawing_edges[i]->x_current += drawing_edges[i]->m_slope;
-			if (drawing_edges[i]->x_current < drawing_edges[i-1]->x_current)
+			PolygonEdge* edge = active_edges[i];
+			if (edge->y_max <= current_scanline + 1)
+			{
+				continue;
+			}
+			edge->step();
+			if (keep > 0 && edge->is_left_of(*active_edges[keep - 1]))
 			{
-				// out of order now so need to resort
 				need_to_sort = true;
 			}
+			active_edges[keep++] = edge;
 		}
+		active_edges.resize(keep);
 
-		// scanline complete
-		current_scanline += 1;
+		if (need_to_sort == true)
+		{
+			GCanvasSteffey::sort_active_edges(active_edges, this->m_new_edges);
+		}
 	}
 }
 
-inline GPixel GCanvasSteffey::blend(const GPixel& source, const GPixel& destination)
+void GCanvasSteffey::draw_contours_antialiased(const GContour contours[], int count, const GPaint& paint)
 {
-	// precalc once what we can
-	unsigned int source_pixel_a = GPixel_GetA(source);
-	int sa_compute = 255 - source_pixel_a;
-
-
-	if (sa_compute == 0)
-	{
-		// full alpha so only the source
-		return source;
-	}
-	else if (sa_compute == 255)
+	// work out how we are going to blend the paint
+	Blitter blitter(*this->m_bitmap, paint, this->m_global_ctm_current, this->m_draw_clip, this->m_clip.mask.get());
+	if (blitter.is_visible() == false)
 	{
-		// no alpha so only the dest
-		return destination;
+		// nothing this paint draws will change a pixel
+		return;
 	}
 
-	// calculate each result color component
-	unsigned int Ra = source_pixel_a + divide_by_255(sa_compute * GPixel_GetA(destination));
-	unsigned int Rr = GPixel_GetR(source) + divide_by_255(sa_compute * GPixel_GetR(destination));
-	unsigned int Rg = GPixel_GetG(source) + divide_by_255(sa_compute * GPixel_GetG(destination));
-	unsigned int Rb = GPixel_GetB(source) + divide_by_255(sa_compute * GPixel_GetB(destination));
-
-	// pack it into a pixel
-	return GPixel_PackARGB(Ra, Rr, Rg, Rb);
+	// let the rasterizer compute the coverage and feed it to the blitter
+	// only the rows are limited to the device clip, the rasterizer still sees whole rows so its
+	// runs (and the shader chunks inside them) start in the same place however the canvas is clipped
+	GIRect clip = GIRect::MakeLTRB(0, this->m_draw_clip.fTop, this->m_bitmap->width(), this->m_draw_clip.fBottom);
+	this->m_aa_rasterizer.fill_contours(contours, count, this->m_global_ctm_current, clip, blitter);
 }
 
-inline void GCanvasSteffey::blend(const GPixel& source, GPixel* dest, int count)
+void GCanvasSteffey::draw_hairlines(const GContour contours[], int count, const GPaint& paint, float device_width)
 {
-	for (int i = 0; i < count; ++i)
+	Blitter blitter(*this->m_bitmap, paint, this->m_global_ctm_current, this->m_draw_clip, this->m_clip.mask.get());
+	if (blitter.is_visible() == false)
 	{
-		dest[i] = GCanvasSteffey::blend(source, dest[i]);
+		return;
 	}
+
+	// anti-aliased lines cover as much of each pixel as the stroke is wide, a width of 0 is a full hairline
+	float coverage = (device_width > 0.0f ? device_width : 1.0f);
+	this->m_hairline_rasterizer.stroke_contours(contours, count, this->m_global_ctm_current, paint, coverage,
+		this->m_draw_clip, blitter);
 }
 
-inline void GCanvasSteffey::blend_opaque(const GPixel& source, GPixel* dest, int count)
+bool GCanvasSteffey::edge_sorts_before(const PolygonEdge& a, const PolygonEdge& b)
 {
-	for (int i = 0; i < count; ++i)
+	// top to bottom, then left to right, then by slope for edges starting at the same point
+	if (a.y_min != b.y_min)
+	{
+		return a.y_min < b.y_min;
+	}
+	if (a.x_current != b.x_current)
 	{
-		dest[i] = source;
-	}	
+		return a.x_current < b.x_current;
+	}
+	return a.m_slope < b.m_slope;
 }
 
-inline void GCanvasSteffey::blend(const GPixel* source, GPixel* dest, int count)
+void GCanvasSteffey::sort_polygon_edges()
 {
-	for (int i = 0; i < count; ++i)
+	std::vector<PolygonEdge>& edges = this->m_edges;
+	int edge_count = (int)edges.size();
+
+	// rects and triangles only have a handful of edges, just insertion sort those
+	if (edge_count <= SMALL_EDGE_COUNT)
+	{
+		for (int i = 1; i < edge_count; ++i)
+		{
+			PolygonEdge edge = edges[i];
+			int j = i;
+			while (j > 0 && GCanvasSteffey::edge_sorts_before(edge, edges[j - 1]) == true)
+			{
+				edges[j] = edges[j - 1];
+				--j;
+			}
+			edges[j] = edge;
+		}
+		return;
+	}
+
+	// otherwise counting sort them by y_min, over the scanlines the polygon covers
+	int top = edges[0].y_min;
+	int bottom = edges[0].y_min;
+	for (const PolygonEdge& edge : edges)
+	{
+		top = std::min(top, edge.y_min);
+		bottom = std::max(bottom, edge.y_min);
+	}
+	std::vector<int>& starts = this->m_edge_starts;
+	starts.assign(bottom - top + 2, 0);
+	for (const PolygonEdge& edge : edges)
 	{
-		dest[i] = GCanvasSteffey::blend(source[i], dest[i]);
+		++starts[edge.y_min - top + 1];
 	}
+	for (int i = 1; i < (int)starts.size(); ++i)
+	{
+		starts[i] += starts[i - 1];
+	}
+
+	std::vector<PolygonEdge>& sorted = this->m_sorted_edges;
+	sorted.assign(edge_count, edges[0]);
+	for (const PolygonEdge& edge : edges)
+	{
+		sorted[starts[edge.y_min - top]++] = edge;
+	}
+
+	// the edges sharing a scanline still need to go left to right, there are rarely more than two
+	for (int i = 1; i < edge_count; ++i)
+	{
+		if (sorted[i].y_min != sorted[i - 1].y_min)
+		{
+			continue;
+		}
+		PolygonEdge edge = sorted[i];
+		int j = i;
+		while (j > 0 && GCanvasSteffey::edge_sorts_before(edge, sorted[j - 1]) == true)
+		{
+			sorted[j] = sorted[j - 1];
+			--j;
+		}
+		sorted[j] = edge;
+	}
+
+	// the sorted edges become the edge buffer, the old one is kept for next time
+	edges.swap(sorted);
 }
 
-inline unsigned int GCanvasSteffey::divide_by_255(unsigned int p)
+bool GCanvasSteffey::can_step_edges_in_fixed_point() const
 {
-	// fast divide by 255 by approximating very very *very* close
-	// and getting to use a shift instead of divide
-	return (p * 65793 + (1 << 23)) >> 24;
+	// 16.16 rounds x and the slope to 1/65536 of a pixel, and the slope's rounding adds up once per
+	// row, so over fewer than 16384 rows an edge drifts at most 1/8 of a pixel from its exact x
+	// (float adds round too, and drift further on tall edges), so the two can only pick different
+	// pixels on rows where the edge passes that close to the line between two pixels
+	// that is kept to matrices that just scale and translate by whole numbers, where integer
+	// points stay on integers; the fixed_point_edges tests pin both the bound and how rarely the
+	// pixels differ
+	const GMatrix& ctm = this->m_global_ctm_current;
+	if (ctm[GMatrix::KX] != 0.0f || ctm[GMatrix::KY] != 0.0f)
+	{
+		return false;
+	}
+	for (int i = 0; i < 6; ++i)
+	{
+		if (ctm[i] != std::floor(ctm[i]))
+		{
+			return false;
+		}
+	}
+
+	// and the canvas has to fit in 16.16 with few enough rows to keep the drift in bounds
+	return this->m_bitmap->width() < 16384 && this->m_bitmap->height() < 16384;
 }
 
-inline void GCanvasSteffey::sort_polygon_edges(std::vector<PolygonEdge>& edges)
+void GCanvasSteffey::merge_new_edges(PolygonEdge* bucket, std::vector<PolygonEdge*>& active_edges, std::vector<PolygonEdge*>& new_edges)
 {
-	std::sort(edges.begin(), edges.end(), [] (const PolygonEdge& a, const PolygonEdge& b)
+	// sort the new edges on their own (by x and then slope, same as edge_sorts_before)
+	new_edges.clear();
+	for (PolygonEdge* edge = bucket; edge != nullptr; edge = edge->next)
+	{
+		new_edges.push_back(edge);
+	}
+	std::sort(new_edges.begin(), new_edges.end(), [] (const PolygonEdge* a, const PolygonEdge* b)
 		{
-			if (a.y_min < b.y_min)
-			{
-				// a is higher than b
-				return true;
-			}
-			else if (a.y_min > b.y_min)
-			{
-				// b is higher than a
-				return false;
-			}
-			else
+			// edges that jumped down to a band's top row are only kept current in fixed point
+			float a_x = a->current_x();
+			float b_x = b->current_x();
+			if (a_x != b_x)
 			{
-				// same height
-				if (a.x_current < b.x_current)
-				{
-					// a starting x is to the left of b starting x
-					return true;
-				}
-				else if (a.x_current > b.x_current)
-				{
-					// b starting x is to the left of a starting x
-					return false;
-				}
-				else
-				{
-					// same exact point...compare the slopes
-					if (a.m_slope < b.m_slope)
-					{
-						// a is to the left
-						return true;
-					}
-					return false;
-				}
+				return a_x < b_x;
 			}
-			return false;
+			return a->m_slope < b->m_slope;
 		}
 	);
+
+	// then merge them into the active edges from the back, so nothing gets shifted more than once
+	int i = (int)active_edges.size() - 1;
+	int j = (int)new_edges.size() - 1;
+	active_edges.resize(active_edges.size() + new_edges.size());
+	for (int k = (int)active_edges.size() - 1; j >= 0; --k)
+	{
+		if (i >= 0 && new_edges[j]->is_left_of(*active_edges[i]))
+		{
+			active_edges[k] = active_edges[i];
+			--i;
+		}
+		else
+		{
+			active_edges[k] = new_edges[j];
+			--j;
+		}
+	}
 }
 
-inline void GCanvasSteffey::sort_polygon_drawing_edges(std::vector<PolygonEdge*>& edges)
+void GCanvasSteffey::sort_active_edges(std::vector<PolygonEdge*>& edges, std::vector<PolygonEdge*>& scratch)
 {
-	// only sort on x_current
-	std::sort(edges.begin(), edges.end(), [] (const PolygonEdge* a, const PolygonEdge* b)
+	// usually only a couple of edges have crossed since the last scanline, so insertion
+	// sort them back into place...but on paths where lots of edges cross every scanline
+	// that goes quadratic, so give up and do a full sort once it has moved too much
+	int budget = 4 * (int)edges.size();
+	for (int i = 1; i < (int)edges.size(); ++i)
+	{
+		PolygonEdge* edge = edges[i];
+		int j = i;
+		while (j > 0 && edge->is_left_of(*edges[j - 1]))
 		{
-			if (a->x_current <= b->x_current)
-			{
-				// a x is to the left of (or equal to) b x
-				return true;
-			}
-			return false;
+			edges[j] = edges[j - 1];
+			--j;
 		}
-	);
+		edges[j] = edge;
+
+		budget -= i - j;
+		if (budget < 0)
+		{
+			GCanvasSteffey::merge_sort_active_edges(edges, scratch);
+			return;
+		}
+	}
+}
+
+void GCanvasSteffey::merge_sort_active_edges(std::vector<PolygonEdge*>& edges, std::vector<PolygonEdge*>& scratch)
+{
+	// a bottom up merge sort, std::stable_sort would allocate a buffer of its own every time
+	auto left_of = [] (const PolygonEdge* a, const PolygonEdge* b)
+	{
+		return a->is_left_of(*b);
+	};
+
+	int count = (int)edges.size();
+	scratch.resize(count);
+	PolygonEdge** src = edges.data();
+	PolygonEdge** dst = scratch.data();
+	for (int width = 1; width < count; width *= 2)
+	{
+		for (int left = 0; left < count; left += 2 * width)
+		{
+			int middle = std::min(left + width, count);
+			int right = std::min(left + 2 * width, count);
+			std::merge(src + left, src + middle, src + middle, src + right, dst + left, left_of);
+		}
+		std::swap(src, dst);
+	}
+
+	// the last pass may have left them in the scratch
+	if (src != edges.data())
+	{
+		std::copy(src, src + count, edges.data());
+	}
+}
+
+bool GCanvasSteffey::edge_crosses_rows(const GPoint& p0, const GPoint& p1, int top, int bottom)
+{
+	// the rows are rounded from the ends, so an edge can only reach a row whose center it passes;
+	// this stays in floats, since the ends are not clipped yet and may be far past any int
+	return std::max(p0.fY, p1.fY) > top - 0.5f && std::min(p0.fY, p1.fY) < bottom + 0.5f;
 }
 
 void GCanvasSteffey::create_and_clip_polygon_edges(const GPoint& p0, const GPoint& p1, const GRect& clip_rect, std::vector<PolygonEdge>& edges)
@@ -974,567 +1368,84 @@ void GCanvasSteffey::create_and_clip_polygon_edges(const GPoint& p0, const GPoin
 
 void GCanvasSteffey::draw_stroked_contours(const GContour contours[], int count, const GPaint& paint)
 {
-	// TODO come back and figure out the joints if I have time
-	// I have tried 3-4 different approaches and could not get it to 
-	// work properly....i made the images worse
-	
-	// this function will take our array of contours
-	// for EACH contour that represents a stroked line, we will generate alot of contours
-	// for that single stroked contour and add it to a list
-	// once all have been processed then we will have a list of contours and need to be filled
-	// and we can call our normal drawContour method
-	// create a container of new generated contours
-	std::vector<GContour> contour_vector;
-
-	// loop through each input contour
-	for (int i = 0; i < count; ++i)
+	// how wide the stroke gets on the bitmap, in the direction the ctm stretches it the most
+	float scale = max_scale(this->m_global_ctm_current);
+	float device_width = paint.getStrokeWidth() * scale;
+	if (device_width <= 1.0f)
 	{
-		// get a pointer to this contour for easy handling
-		const GContour* contour = &(contours[i]);
-
-		if (contour->fCount < 2)
-		{
-			// not enough points
-			// continue this i loop
-			continue;
-		}
-		else if (contour->fCount == 2)
-		{
-			// simple with no joints
-			// put a new contour in the vector
-			GContour empty;
-			contour_vector.push_back(empty);
-		
-			// get a pointer to it for manipulation
-			GContour* new_contour = &(contour_vector[contour_vector.size() - 1]);
-
-			// call our special for 2 points
-			this->create_stroked_contour_2_points_cap_AB(contour->fPts[0], contour->fPts[1], new_contour, paint.getStrokeWidth());
-
-			// continue with the next i
-			continue;
-		}
-		else
-		{
-			// 3 or more points....harder
-			// loop through all the points in the contour
-			for (int j = 0; j < contour->fCount; ++j)
-			{
-				#ifdef _VERBOSE
-					std::cout << "counter: " << i << " point: " << j << "\n";
-				#endif
-				// check if we need to go from last point to first point
-				if ((j == (contour->fCount - 1)) && (contour->fClosed == false))
-				{
-					// we are on the last point
-					// if closed is false then nothing else to do and break out of this j loop
-					// this will cause it to go back to the next i
-					break;
-				}
-				else if ((j == (contour->fCount - 2)) && (contour->fClosed == false))
-				{
-					// next to last point AND NOT closed
-					// so just need to build a simple quad from A to B and cap B
-					// no other joint needed
-					// put a new contour in the vector
-					GContour empty;
-					contour_vector.push_back(empty);
-		
-					// get a pointer to it for manipulation
-					GContour* new_contour = &(contour_vector[contour_vector.size() - 1]);
-					this->create_stroked_contour_2_points_cap_B(contour->fPts[contour->fCount - 2], contour->fPts[contour->fCount - 1], new_contour, paint.getStrokeWidth());
-
-					// finsihed with this contour
-					// break out of j
-					break;
-				}
-				else
-				{
-					// we will have valid A, B, C points to build the quad and joint
-					// gather our known points
-					GPoint A, B, C, Q, P, R;
-					if (j == contour->fCount - 2)
-					{
-						A = contour->fPts[j];
-						B = contour->fPts[j+1];
-						C = contour->fPts[0];
-					}
-					else if (j == contour->fCount - 1)
-					{
-						A = contour->fPts[j];
-						B = contour->fPts[0];
-						C = contour->fPts[1];
-					}
-					else
-					{
-						A = contour->fPts[j];
-						B = contour->fPts[j+1];
-						C = contour->fPts[j+2];
-					}
-
-					// compute width over 2
-					float w2 = paint.getStrokeWidth() / 2.0f;
-
-					// create all of our vectors
-					float ABx = B.fX - A.fX;
-					float ABy = B.fY - A.fY;
-					float length = sqrt((ABx * ABx) + (ABy * ABy));
-					if (length == 0.0f)
-					{
-						// A and B are same point
-						// skip this whole thing
-						// continue to the next j
-						continue;
-					}
-					ABx /= length;
-					ABy /= length;
-
-					float BCx = C.fX - B.fX;
-					float BCy = C.fY - B.fY;
-					length = sqrt((BCx * BCx) + (BCy * BCy));
-					if (length == 0.0f)
-					{
-						// B and C are same point
-						// just make the AB quad and forget C
-						GContour empty;
-						contour_vector.push_back(empty);
-			
-						// get a pointer to it for manipulation
-						GContour* new_contour = &(contour_vector[contour_vector.size() - 1]);
-						this->create_stroked_contour_2_points_no_cap(A, B, new_contour, paint.getStrokeWidth());
-
-						// continue to next j
-						continue;
-					}
-
-					BCx /= length;
-					BCy /= length;
-
-					float BQx = ABy;
-					float BQy = -ABx;
-
-					float BRx = BCy;
-					float BRy = -BCx;
-
-					Q.fX = B.fX + (BQx * w2);
-					Q.fY = B.fY + (BQy * w2);
-
-					R.fX = B.fX + (BRx * w2);
-					R.fY = B.fY + (BRy * w2);
-
-					float BPx = BQx + BRx;
-					float BPy = BQy + BRy;
-					length = sqrt((BPx * BPx) + (BPy * BPy));
-					BPx /= length;
-					BPy /= length;
-
-
-					float ABdotBC = (-ABx * BCx) + (-ABy * BCy);
-					float ABxBC = (-ABx * BCy) - (-ABy * BCx);
-
-					float BPlength = w2 * sqrt(2 / (1 - ABdotBC));
-
-
-
-					// should have everything we need now
-					// first the quad 
-					if (j == 0 && contour->fClosed == false)
-					{
-						// create the contour with A capped and B not
-						GContour empty;
-						contour_vector.push_back(empty);
-				
-						// get a pointer to it for manipulation
-						GContour* new_contour = &(contour_vector[contour_vector.size() - 1]);
-						this->create_stroked_contour_2_points_cap_A(A, B, new_contour, paint.getStrokeWidth());
-					}
-					else
-					{
-						// create the contour with neither capped
-						GContour empty;
-						contour_vector.push_back(empty);
-				
-						// get a pointer to it for manipulation
-						GContour* new_contour = &(contour_vector[contour_vector.size() - 1]);
-						this->create_stroked_contour_2_points_no_cap(A, B, new_contour, paint.getStrokeWidth());
-					}
-					// lets try and build that joint now
-					if (BPlength > (paint.getMiterLimit() * w2))
-					{
-						// just blunt it between BQR
-						if (ABxBC == 0)
-						{
-							// straight, no need for joint
-						}
-						else
-						{
-							// create the BQR triangle
-							GContour empty;
-							contour_vector.push_back(empty);
-					
-							// get a pointer to it for manipulation
-							GContour* new_contour = &(contour_vector[contour_vector.size() - 1]);
-
-							// setup the new contour
-							new_contour->fCount = 3;
-							GPoint* points = new GPoint[3];
-							new_contour->fPts = &(points[0]);
-							new_contour->fClosed = true;
-							if (ABxBC > 0)
-							{
-								Q.fX = B.fX + (BQx * -w2);
-								Q.fY = B.fY + (BQy * -w2);
-								R.fX = B.fX + (BRx * -w2);
-								R.fY = B.fY + (BRy * -w2);
-								points[0] = B;
-								points[1] = Q;
-								points[2] = R;
-							}
-							else if (ABxBC < 0)
-							{
-								points[0] = B;
-								points[1] = Q;
-								points[2] = R;
-							}
-						}
-					}
-					else
-					{
-						if (ABxBC == 0)
-						{
-							// straight ? no need to do a joint
-						}
-						else
-						{
-							// create the BQPR quad
-							// create a new quad
-							GContour empty;
-							contour_vector.push_back(empty);
-					
-							// get a pointer to it for manipulation
-							GContour* new_contour = &(contour_vector[contour_vector.size() - 1]);
-
-							// setup the new contour
-							new_contour->fCount = 4;
-							GPoint* points = new GPoint[4];
-							new_contour->fPts = &(points[0]);
-							new_contour->fClosed = true;
-
-							if (ABxBC > 0)
-							{
-								// bend one way
-								// create the 4 corner points
-								P.fX = B.fX + BPx * -BPlength;
-								P.fY = B.fY + BPy * -BPlength;
-								Q.fX = B.fX + (BQx * -w2);
-								Q.fY = B.fY + (BQy * -w2);
-								R.fX = B.fX + (BRx * -w2);
-								R.fY = B.fY + (BRy * -w2);
-
-								points[0] = B;
-								points[1] = Q;
-								points[2] = P;
-								points[3] = R;
-							}
-							else if (ABxBC < 0)
-							{
-								// bend the other
-								// create the 4 corner points
-								P.fX = B.fX + BPx * BPlength;
-								P.fY = B.fY + BPy * BPlength;
-								points[0] = B;
-								points[1] = R;
-								points[2] = P;
-								points[3] = Q;
-							}
-						}
-					}
-					#ifdef _VERBOSE
-						std::cout << convert_point_to_string(A, "A") << "\n";
-						std::cout << convert_point_to_string(B, "B") << "\n";
-						std::cout << convert_point_to_string(C, "C") << "\n";
-						std::cout << convert_point_to_string(Q, "Q") << "\n";
-						std::cout << convert_point_to_string(R, "R") << "\n";
-						std::cout << convert_point_to_string(P, "P") << "\n";
-						std::cout << "AB: " << ABx << " " << ABy << "\n";
-						std::cout << "BQ: " << BQx << " " << BQy << "\n";
-						std::cout << "BC: " << BCx << " " << BCy << "\n";
-						std::cout << "BR: " << BRx << " " << BRy << "\n";
-						std::cout << "BP: " << BPx << " " << BPy << "\n";
-						std::cout << "BPlength: " << BPlength << "\n";
-						std::cout << "ABdotBC: " << ABdotBC << "\n";
-						std::cout << "ABxBC: " << ABxBC << "\n";
-					#endif
-				}
-			}
-		}
-
-	}
-
-	// now we have a container full of contours, lets call drawContours on it
-	// adjust the paint width since we have made the strokes
-	GPaint new_paint;
-	new_paint.setColor(paint.getColor());
-	new_paint.setShader(paint.getShader());
-	new_paint.setFill();
-	// miter limit doesnt matter
-
-	this->drawContours(&(contour_vector[0]), contour_vector.size(), new_paint);
-	// free up our memory
-	for (int i = 0; i < contour_vector.size(); ++i)
-	{
-		delete contour_vector[i].fPts;
+		// a pixel or less, so draw it as lines instead of outlines too thin to fill reliably
+		this->draw_hairlines(contours, count, paint, device_width);
+		return;
 	}
-}
 
-void GCanvasSteffey::create_stroked_contour_2_points_cap_AB(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width)
-{
-	// get points A and B
-	GPoint A = p0;
-	GPoint B = p1;
-
-	// compute the vector between them
-	float ABx = p1.fX - p0.fX;
-	float ABy = p1.fY - p0.fY;
-
-	// normalize it
-	float length = sqrt((ABx * ABx) + (ABy * ABy));
-	ABx = ABx / length;
-	ABy = ABy / length;
-
-	// extend out A and B by width / 2
-	// this is for capping
-	float w2 = width / 2.0f;
-	A.fX = A.fX - (ABx * w2);
-	A.fY = A.fY - (ABy * w2);
-	B.fX = B.fX + (ABx * w2);
-	B.fY = B.fY + (ABy * w2);
-
-	// now compute the transpose of AB
-	float ABTx = -ABy;
-	float ABTy = ABx;
-
-	// setup the new contour
-	fill_contour->fCount = 4;
-	GPoint* points = new GPoint[4];
-	fill_contour->fPts = &(points[0]);
-	fill_contour->fClosed = true;
-
-	// create the 4 corner points
-	points[0] = GPoint::Make(A.fX + ABTx * w2, A.fY + ABTy * w2);
-	points[1] = GPoint::Make(B.fX + ABTx * w2, B.fY + ABTy * w2);
-	points[2] = GPoint::Make(B.fX + -ABTx * w2, B.fY + -ABTy * w2);
-	points[3] = GPoint::Make(A.fX + -ABTx * w2, A.fY + -ABTy * w2);
-}
+	// outline the strokes, then fill the outlines like any other contours
+	this->m_stroker.stroke(contours, count, paint, scale);
 
-void GCanvasSteffey::create_stroked_contour_2_points_cap_B(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width)
-{
-	// get points A and B
-	GPoint A = p0;
-	GPoint B = p1;
-
-	// compute the vector between them
-	float ABx = p1.fX - p0.fX;
-	float ABy = p1.fY - p0.fY;
-
-	// normalize it
-	float length = sqrt((ABx * ABx) + (ABy * ABy));
-	ABx = ABx / length;
-	ABy = ABy / length;
-
-	// extend out B by width / 2
-	// this is for capping
-	float w2 = width / 2.0f;
-	B.fX = B.fX + (ABx * w2);
-	B.fY = B.fY + (ABy * w2);
-
-	// now compute the transpose of AB
-	float ABTx = -ABy;
-	float ABTy = ABx;
-
-	// setup the new contour
-	fill_contour->fCount = 4;
-	GPoint* points = new GPoint[4];
-	fill_contour->fPts = &(points[0]);
-	fill_contour->fClosed = true;
-
-	// create the 4 corner points
-	points[0] = GPoint::Make(A.fX + ABTx * w2, A.fY + ABTy * w2);
-	points[1] = GPoint::Make(B.fX + ABTx * w2, B.fY + ABTy * w2);
-	points[2] = GPoint::Make(B.fX + -ABTx * w2, B.fY + -ABTy * w2);
-	points[3] = GPoint::Make(A.fX + -ABTx * w2, A.fY + -ABTy * w2);
+	// same paint, but filled (the width, joins and caps do not matter anymore)
+	GPaint fill_paint = paint;
+	fill_paint.setFill();
+	this->drawContours(this->m_stroker.contours(), this->m_stroker.contour_count(), fill_paint);
 }
 
-void GCanvasSteffey::create_stroked_contour_2_points_cap_A(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width)
+void GCanvasSteffey::drawMesh(int triCount, const GPoint pts[], const int indices[], const GColor colors[], const GPoint tex[], const GPaint& paint)
 {
-	// get points A and B
-	GPoint A = p0;
-	GPoint B = p1;
-
-	// compute the vector between them
-	float ABx = p1.fX - p0.fX;
-	float ABy = p1.fY - p0.fY;
-
-	// normalize it
-	float length = sqrt((ABx * ABx) + (ABy * ABy));
-	ABx = ABx / length;
-	ABy = ABy / length;
-
-	// extend out A by width / 2
-	// this is for capping
-	float w2 = width / 2.0f;
-	A.fX = A.fX - (ABx * w2);
-	A.fY = A.fY - (ABy * w2);
-
-	// now compute the transpose of AB
-	float ABTx = -ABy;
-	float ABTy = ABx;
-
-	// setup the new contour
-	fill_contour->fCount = 4;
-	GPoint* points = new GPoint[4];
-	fill_contour->fPts = &(points[0]);
-	fill_contour->fClosed = true;
-
-	// create the 4 corner points
-	points[0] = GPoint::Make(A.fX + ABTx * w2, A.fY + ABTy * w2);
-	points[1] = GPoint::Make(B.fX + ABTx * w2, B.fY + ABTy * w2);
-	points[2] = GPoint::Make(B.fX + -ABTx * w2, B.fY + -ABTy * w2);
-	points[3] = GPoint::Make(A.fX + -ABTx * w2, A.fY + -ABTy * w2);
-}
+	if (triCount <= 0)
+	{
+		return;
+	}
 
-void GCanvasSteffey::create_stroked_contour_2_points_no_cap(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width)
-{
-	// get points A and B
-	GPoint A = p0;
-	GPoint B = p1;
-
-	// compute the vector between them
-	float ABx = p1.fX - p0.fX;
-	float ABy = p1.fY - p0.fY;
-
-	// normalize it
-	float length = sqrt((ABx * ABx) + (ABy * ABy));
-	ABx = ABx / length;
-	ABy = ABy / length;
-
-	// now compute the transpose of AB
-	float ABTx = -ABy;
-	float ABTy = ABx;
-
-	float w2 = width / 2.0f;
-
-	// setup the new contour
-	fill_contour->fCount = 4;
-	GPoint* points = new GPoint[4];
-	fill_contour->fPts = &(points[0]);
-	fill_contour->fClosed = true;
-
-	// create the 4 corner points
-	points[0] = GPoint::Make(A.fX + ABTx * w2, A.fY + ABTy * w2);
-	points[1] = GPoint::Make(B.fX + ABTx * w2, B.fY + ABTy * w2);
-	points[2] = GPoint::Make(B.fX + -ABTx * w2, B.fY + -ABTy * w2);
-	points[3] = GPoint::Make(A.fX + -ABTx * w2, A.fY + -ABTy * w2);
-}
+	// work out how the triangles get shaded and blended, once for all of them
+	MeshRasterizer rasterizer(*this->m_bitmap, paint, this->m_global_ctm_current, this->m_draw_clip, this->m_clip.mask.get(),
+		colors != nullptr, tex != nullptr);
+	if (rasterizer.is_visible() == false)
+	{
+		// no colors or texture, or nothing this paint draws will change a pixel
+		return;
+	}
 
-void GCanvasSteffey::drawMesh(int triCount, const GPoint pts[], const int indices[], const GColor colors[], const GPoint tex[], const GPaint& paint)
-{
+	// map every vertex once, so triangles sharing an index share the mapped point too
+	int vertex_count = triCount * 3;
+	if (indices != nullptr)
+	{
+		vertex_count = *std::max_element(indices, indices + triCount * 3) + 1;
+	}
+	std::vector<GPoint>& device_points = this->m_device_points;
+	device_points.resize(vertex_count);
+	this->m_global_ctm_current.mapPoints(device_points.data(), pts, vertex_count);
 
-	int index = 0;
-	for (int i = 0; i < triCount; ++i)
+	for (int i = 0; i < triCount * 3; i += 3)
 	{
-		GPoint p[3];
+		int i0 = (indices != nullptr ? indices[i + 0] : i + 0);
+		int i1 = (indices != nullptr ? indices[i + 1] : i + 1);
+		int i2 = (indices != nullptr ? indices[i + 2] : i + 2);
+
+		GPoint device[3] = { device_points[i0], device_points[i1], device_points[i2] };
+		GPoint local[3] = { pts[i0], pts[i1], pts[i2] };
 		GColor c[3];
 		GPoint t[3];
-		GContour contour;
-		contour.fCount = 3;
-		contour.fClosed = true;
-		contour.fPts = p;
-		if (indices == nullptr)
+		if (colors != nullptr)
 		{
-			p[0] = pts[index + 0];
-			p[1] = pts[index + 1];
-			p[2] = pts[index + 2];
-
-			if (colors != nullptr)
-			{
-				c[0] = colors[index + 0];
-				c[1] = colors[index + 1];
-				c[2] = colors[index + 2];
-			}
-
-			if (tex != nullptr)
-			{
-				t[0] = tex[index + 0];
-				t[1] = tex[index + 1];
-				t[2] = tex[index + 2];
-			}
+			c[0] = colors[i0];
+			c[1] = colors[i1];
+			c[2] = colors[i2];
 		}
-		else
+		if (tex != nullptr)
 		{
-			int i0 = indices[index + 0];
-			int i1 = indices[index + 1];
-			int i2 = indices[index + 2];
-
-			p[0] = pts[i0];
-			p[1] = pts[i1];
-			p[2] = pts[i2];
-
-			if (colors != nullptr)
-			{
-				c[0] = colors[i0];
-				c[1] = colors[i1];
-				c[2] = colors[i2];
-			}
-
-			if (tex != nullptr)
-			{
-				t[0] = tex[i0];
-				t[1] = tex[i1];
-				t[2] = tex[i2];
-			}
+			t[0] = tex[i0];
+			t[1] = tex[i1];
+			t[2] = tex[i2];
 		}
 
-		// now construct a paint with a shader based on if we have colors and/or tex
-		GPaint new_paint;
-		// set the alpha
-		new_paint.setAlpha(paint.getAlpha());
-
-		if (colors != nullptr && tex != nullptr)
+		// the same edges drawConvexPolygon would make, so neighbours meet without gaps or overlap
+		if (this->build_convex_edges(device, 3) == false)
 		{
-			// do the color shader
-			GShaderColorTriangle tri_shader(p, c);
-
-			// do the bitmap proxy shader
-			GShaderBitmapProxy tex_shader(paint.getShader(), p, t);
-
-			// do the composite shader
-			GShaderCompose comp_shader(&tex_shader, &tri_shader);
-			new_paint.setShader(&comp_shader);
-			this->drawContours(&contour, 1, new_paint);
-
-		}
-		else if (colors != nullptr && tex == nullptr)
-		{
-			// do the color shader
-			GShaderColorTriangle tri_shader(p, c);
-			new_paint.setShader(&tri_shader);
-			this->drawContours(&contour, 1, new_paint);
-		}
-		else if (colors == nullptr && tex != nullptr)
-		{
-			// do the bitmap proxy shader
-			GShaderBitmapProxy tex_shader(paint.getShader(), p, t);
-			new_paint.setShader(&tex_shader);
-			this->drawContours(&contour, 1, new_paint);
+			continue;
 		}
-		else
+		if (rasterizer.set_triangle(device, local, c, t) == false)
 		{
-			// give up
 			continue;
 		}
-
-		index += 3;
+		this->walk_convex_edges(rasterizer);
 	}
 }
 
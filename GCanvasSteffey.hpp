@@ -15,8 +15,14 @@
 #include <list>
 #include "PolygonEdge.hpp"
 #include <stack>
+#include <memory>
 #include "include/GContour.h"
 #include "GShaderRadial.hpp"
+#include "AntiAliasRasterizer.hpp"
+#include "HairlineRasterizer.hpp"
+#include "PathFlattener.hpp"
+#include "Stroker.hpp"
+#include "ClipMask.hpp"
 
 
 class GCanvasSteffey : public GCanvas
@@ -42,55 +48,159 @@ public:
 	// draw a rectangle
 	void drawRect(const GRect& rect, const GPaint& paint) override;
 
+	// shrink the clip to the rect or path, mapped by the ctm
+	// the clip is saved and restored along with the ctm
+	void clipRect(const GRect& rect) override;
+	void clipPath(const GPath& path) override;
+
 	// draw a polygon
 	void drawConvexPolygon(const GPoint points[], int count, const GPaint& paint) override;
 
 	// draw some contours
 	void drawContours(const GContour ctrs[], int count, const GPaint& paint) override;
 
+	// draw a path, its curves flattened for the ctm
+	void drawPath(const GPath& path, const GPaint& paint) override;
+
 	// draw a mesh
 	void drawMesh(int triCount, const GPoint pts[], const int indices[], const GColor colors[], const GPoint tex[], const GPaint& paint) override;
 	
 	GShader* makeRadialGradient(float cx, float cy, float radius, const GColor colors[], int count) override;
 
+	// limit every draw (and clear) to the pixels inside of clip
+	// the geometry is still worked out for the whole bitmap, so a pixel inside of clip
+	// comes out exactly the same as it would without it
+	void set_device_clip(const GIRect& clip);
+
+	// the clip: only pixels inside of bounds (and inside of mask, when there is one) get drawn
+	// bounds only depends on what was clipped to, never on the device clip, so the edges
+	// clipped to it come out the same on every tile
+	struct ClipState
+	{
+		GIRect bounds;
+		std::shared_ptr<const ClipMask> mask;
+	};
+
+	// the current clip, and replace it with one taken from another canvas on the same size of
+	// bitmap, so a clip built once with the whole bitmap can be shared by the canvases drawing its tiles
+	const ClipState& clip_state() const { return this->m_clip; }
+	void set_clip_state(const ClipState& clip);
 
 protected:
 	
 private:
 
+	// what save pushes and restore pops
+	struct SavedState
+	{
+		GMatrix ctm;
+		ClipState clip;
+	};
+
+	// recompute m_draw_clip after the clip or the device clip changes
+	void update_draw_clip();
+
+	// a mask out of m_masks that no clip uses anymore, or a new one added to it
+	std::shared_ptr<ClipMask> unused_mask();
+
+	// intersect the clip with the inside of the contours (in local space)
+	void clip_contours(const GContour contours[], int count);
+
+	// the rect the edges of every draw get clipped to
+	GRect edge_clip_rect() const;
+
+	// fill a rect the ctm keeps axis aligned straight from its bounds, false if it cannot
+	bool fill_axis_aligned_rect(const GRect& rect, const GPaint& paint);
+
+	// fill contours with partial coverage along the edges
+	void draw_contours_antialiased(const GContour contours[], int count, const GPaint& paint);
+
+	enum
+	{
+		// polygons with up to this many edges get insertion sorted instead of bucketed
+		SMALL_EDGE_COUNT = 8,
+	};
+
+	// sort m_edges by y_min, then x, then slope
+	void sort_polygon_edges();
+	static bool edge_sorts_before(const PolygonEdge& a, const PolygonEdge& b);
 
-	// blend the source and destination pixels
-	static inline GPixel blend(const GPixel& source, const GPixel& destination);
+	static void sort_active_edges(std::vector<PolygonEdge*>& edges, std::vector<PolygonEdge*>& scratch);
+	static void merge_sort_active_edges(std::vector<PolygonEdge*>& edges, std::vector<PolygonEdge*>& scratch);
+	static void merge_new_edges(PolygonEdge* bucket, std::vector<PolygonEdge*>& active_edges, std::vector<PolygonEdge*>& new_edges);
 
-	// blend a single color to an array destination
-	static inline void blend(const GPixel& source, GPixel* dest, int count);
-	static inline void blend_opaque(const GPixel& source, GPixel* dest, int count);
+	// can this draw step its edges in 16.16 fixed point instead of float
+	bool can_step_edges_in_fixed_point() const;
 
-	// blend the arrays of source and destination pixels
-	static inline void blend(const GPixel* source, GPixel* dest, int count);	
+	// fill m_edges with the sorted edges of a convex polygon already in device space, ready to walk
+	// false if there is nothing of it on the bitmap
+	bool build_convex_edges(const GPoint device_points[], int count);
+	// hand each scanline between the two sides of the convex polygon in m_edges to blitter.blit_row
+	template <typename RowBlitter>
+	void walk_convex_edges(RowBlitter& blitter);
 
-	// execute a very fast divide by 255
-	static inline unsigned int divide_by_255(unsigned int p);
+	// fill m_edges with the edges of the contours (in local space), false if there are not enough
+	// of them on the bitmap to draw anything
+	bool build_contour_edges(const GContour contours[], int count);
+	// hand each run inside of the contours in m_edges (by the nonzero winding rule) to blitter.blit_row
+	template <typename RowBlitter>
+	void walk_contour_edges(RowBlitter& blitter);
 
-	// sort edges
-	static inline void sort_polygon_edges(std::vector<PolygonEdge>& edges);
-	static inline void sort_polygon_drawing_edges(std::vector<PolygonEdge*>& edges);
+	// could the edge from p0 to p1 cover any of the rows [top, bottom) (false means it surely cannot)
+	static bool edge_crosses_rows(const GPoint& p0, const GPoint& p1, int top, int bottom);
 
 	// clip edges
 	static void create_and_clip_polygon_edges(const GPoint& p0, const GPoint& p1, const GRect& clip_rect, std::vector<PolygonEdge>& edges);
 
-	// create the strokes
+	// fill the outlines of the strokes
 	void draw_stroked_contours(const GContour contours[], int count, const GPaint& paint);
-	void create_stroked_contour_2_points_cap_AB(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width);
-	void create_stroked_contour_2_points_cap_A(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width);
-	void create_stroked_contour_2_points_cap_B(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width);
-	void create_stroked_contour_2_points_no_cap(const GPoint& p0, const GPoint& p1, GContour* fill_contour, float width);
+
+	// draw strokes that are at most a pixel wide on the bitmap (device_width) as lines
+	void draw_hairlines(const GContour contours[], int count, const GPaint& paint, float device_width);
 
 
 	// the bitmap our canvas draws onto and our matrix
 	const GBitmap* m_bitmap;
-	std::stack<GMatrix> m_global_ctm_stack;
+	std::stack<SavedState> m_state_stack;
 	GMatrix m_global_ctm_current;
+	GIRect m_device_clip;
+
+	// the clip, and where it overlaps the device clip (which is all any draw can touch)
+	ClipState m_clip;
+	GIRect m_draw_clip;
+
+	// every mask the clips have made, so the ones no clip uses anymore get built into again
+	// instead of allocating, and the builder that keeps its buffers between them
+	std::vector<std::shared_ptr<ClipMask>> m_masks;
+	ClipMaskBuilder m_mask_builder;
+
+	// the edges of the current polygon or contours, kept between draws so they do not allocate
+	// m_sorted_edges and m_edge_starts are the scratch for sort_polygon_edges
+	std::vector<PolygonEdge> m_edges;
+	std::vector<PolygonEdge> m_sorted_edges;
+	std::vector<int> m_edge_starts;
+
+	// the points of the current polygon or mesh mapped through the ctm
+	std::vector<GPoint> m_device_points;
+
+	// the active edge table for drawContours, kept between draws
+	// m_edge_buckets has a list of the edges starting on each scanline
+	std::vector<PolygonEdge*> m_edge_buckets;
+	std::vector<PolygonEdge*> m_active_edges;
+	// m_new_edges is also the scratch for merge_sort_active_edges
+	std::vector<PolygonEdge*> m_new_edges;
+
+	// outlines the strokes, keeping its buffers between them
+	Stroker m_stroker;
+
+	// turns paths into contours, keeping its buffers between them
+	PathFlattener m_path_flattener;
+
+	// keeps its row buffers between anti-aliased draws
+	AntiAliasRasterizer m_aa_rasterizer;
+
+	// keeps its mapped points between hairline draws
+	HairlineRasterizer m_hairline_rasterizer;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,550 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "GCanvasTiled.hpp"
+#include "GShaderRadial.hpp"
+#include "utils.hpp"
+#include "include/GMath.h"
+#include <algorithm>
+#include <cmath>
+
+GCanvas* GCanvas::CreateTiled(const GBitmap& bitmap, int threadCount)
+{
+	// sanity checks for valid GBitmap
+	if (is_valid_bitmap(bitmap) == false)
+	{
+		return NULL;
+	}
+	if (threadCount < 1)
+	{
+		return NULL;
+	}
+
+	// seems the bitmap is valid
+	return new GCanvasTiled(bitmap, threadCount);
+}
+
+// stands in for a shader whose context was already set before the tiles started,
+// so the threads only ever call shadeRow on it (which does not change the shader)
+class PresetContextShader : public GShader
+{
+public:
+	PresetContextShader(GShader* shader, bool context_ok)
+	{
+		this->m_shader = shader;
+		this->m_context_ok = context_ok;
+	}
+
+	bool setContext(const GMatrix&, float) override
+	{
+		return this->m_context_ok;
+	}
+
+	void shadeRow(int x, int y, int count, GPixel row[]) override
+	{
+		this->m_shader->shadeRow(x, y, count, row);
+	}
+
+private:
+	GShader* m_shader;
+	bool m_context_ok;
+};
+
+GCanvasTiled::GCanvasTiled(const GBitmap& bitmap, int thread_count)
+	: m_pool(thread_count)
+{
+	this->m_bitmap = bitmap;
+	this->m_ctm.setIdentity();
+	this->m_clip = ClipRecording::NO_CLIP;
+
+	// split the bitmap up into bands, a single thread just gets the whole bitmap
+	int band_count = 1;
+	if (this->m_pool.thread_count() > 1)
+	{
+		band_count = std::min(this->m_pool.thread_count() * BANDS_PER_THREAD, bitmap.height() / MIN_BAND_HEIGHT);
+		band_count = std::max(band_count, 1);
+	}
+	this->m_band_height = std::max((bitmap.height() + band_count - 1) / band_count, 1);
+	band_count = std::max((bitmap.height() + this->m_band_height - 1) / this->m_band_height, 1);
+	this->m_bins.resize(band_count);
+	this->m_bin_positions.resize(this->m_bins.size(), 0);
+
+	// every thread gets its own canvas to draw its tiles with
+	for (int i = 0; i < this->m_pool.thread_count(); ++i)
+	{
+		this->m_canvases.push_back(std::unique_ptr<GCanvasSteffey>(new GCanvasSteffey(this->m_bitmap)));
+	}
+	this->m_canvas_clips.resize(this->m_pool.thread_count(), ClipRecording::NO_CLIP);
+	this->m_contour_scratch.resize(this->m_pool.thread_count());
+}
+
+GCanvasTiled::~GCanvasTiled()
+{
+	// draw whatever is left
+	this->flush();
+}
+
+void GCanvasTiled::save()
+{
+	this->m_state_stack.push(std::make_pair(this->m_ctm, this->m_clip));
+}
+
+void GCanvasTiled::restore()
+{
+	this->m_ctm = this->m_state_stack.top().first;
+	this->m_clip = this->m_state_stack.top().second;
+	this->m_state_stack.pop();
+}
+
+void GCanvasTiled::concat(const GMatrix& matrix)
+{
+	// same math as the serial canvas so the recorded matrices match it exactly
+	this->m_ctm = this->m_ctm.preConcat(matrix);
+
+	// with its type worked out here, so the copies the tiles map points with already have it
+	this->m_ctm.getType();
+}
+
+void GCanvasTiled::clipRect(const GRect& rect)
+{
+	this->m_clip = this->m_clips.clip_rect(this->m_clip, this->m_ctm, rect);
+}
+
+void GCanvasTiled::clipPath(const GPath& path)
+{
+	this->m_clip = this->m_clips.clip_path(this->m_clip, this->m_ctm, path);
+}
+
+void GCanvasTiled::clear(const GColor& color)
+{
+	Op op = {};
+	op.type = OP_CLEAR;
+	op.color = color;
+	this->add_op(op, GRect::MakeWH(0, 0), true);
+}
+
+void GCanvasTiled::fillBitmapRect(const GBitmap& src, const GRect& dst)
+{
+	Op op = {};
+	op.type = OP_BITMAP_RECT;
+	op.bitmap = src;
+	op.rect = dst;
+
+	GPoint corners[] = { GPoint::Make(dst.fLeft, dst.fTop), GPoint::Make(dst.fRight, dst.fTop),
+						GPoint::Make(dst.fRight, dst.fBottom), GPoint::Make(dst.fLeft, dst.fBottom) };
+	this->add_op(op, this->map_bounds(corners, 4), false);
+}
+
+void GCanvasTiled::drawRect(const GRect& rect, const GPaint& paint)
+{
+	Op op = {};
+	op.type = OP_RECT;
+	op.paint = paint;
+	op.rect = rect;
+
+	GPoint corners[] = { GPoint::Make(rect.fLeft, rect.fTop), GPoint::Make(rect.fRight, rect.fTop),
+						GPoint::Make(rect.fRight, rect.fBottom), GPoint::Make(rect.fLeft, rect.fBottom) };
+	this->add_op(op, this->map_bounds(corners, 4), false);
+}
+
+void GCanvasTiled::drawConvexPolygon(const GPoint points[], int count, const GPaint& paint)
+{
+	if (count < 3)
+	{
+		// nothing would get drawn
+		return;
+	}
+
+	Op op = {};
+	op.type = OP_CONVEX_POLYGON;
+	op.paint = paint;
+	op.first_point = (int)this->m_points.size();
+	op.point_count = count;
+	this->m_points.insert(this->m_points.end(), points, points + count);
+	this->add_op(op, this->map_bounds(points, count), false);
+}
+
+void GCanvasTiled::drawContours(const GContour ctrs[], int count, const GPaint& paint)
+{
+	Op op = {};
+	op.type = OP_CONTOURS;
+	op.paint = paint;
+	op.first_point = (int)this->m_points.size();
+	op.first_contour = (int)this->m_contours.size();
+	op.contour_count = count;
+	for (int i = 0; i < count; ++i)
+	{
+		RecordedContour contour = { (int)this->m_points.size(), ctrs[i].fCount, ctrs[i].fClosed };
+		this->m_contours.push_back(contour);
+		this->m_points.insert(this->m_points.end(), ctrs[i].fPts, ctrs[i].fPts + ctrs[i].fCount);
+	}
+	op.point_count = (int)this->m_points.size() - op.first_point;
+
+	// strokes grow past their points by an amount that depends on the width, the joins and
+	// the matrix, so they just go to every tile
+	bool all_tiles = (paint.isStroke() == true);
+	this->add_op(op, this->map_bounds(&(this->m_points[op.first_point]), op.point_count), all_tiles);
+}
+
+void GCanvasTiled::drawPath(const GPath& path, const GPaint& paint)
+{
+	// flattened once for every tile, so the bands get the same edges the whole bitmap would
+	this->m_path_flattener.flatten(path, this->m_ctm);
+	this->drawContours(this->m_path_flattener.contours(), this->m_path_flattener.contour_count(), paint);
+}
+
+void GCanvasTiled::drawMesh(int triCount, const GPoint pts[], const int indices[], const GColor colors[], const GPoint tex[], const GPaint& paint)
+{
+	if (triCount <= 0)
+	{
+		return;
+	}
+
+	// the mesh reads the first vertex_count entries of pts, colors and tex
+	int vertex_count = triCount * 3;
+	if (indices != nullptr)
+	{
+		vertex_count = *std::max_element(indices, indices + triCount * 3) + 1;
+	}
+
+	Op op = {};
+	op.type = OP_MESH;
+	op.paint = paint;
+	op.tri_count = triCount;
+	op.first_point = (int)this->m_points.size();
+	op.point_count = vertex_count;
+	this->m_points.insert(this->m_points.end(), pts, pts + vertex_count);
+	op.first_index = -1;
+	if (indices != nullptr)
+	{
+		op.first_index = (int)this->m_indices.size();
+		this->m_indices.insert(this->m_indices.end(), indices, indices + triCount * 3);
+	}
+	op.first_color = -1;
+	if (colors != nullptr)
+	{
+		op.first_color = (int)this->m_colors.size();
+		this->m_colors.insert(this->m_colors.end(), colors, colors + vertex_count);
+	}
+	op.first_tex = -1;
+	if (tex != nullptr)
+	{
+		op.first_tex = (int)this->m_points.size();
+		this->m_points.insert(this->m_points.end(), tex, tex + vertex_count);
+	}
+
+	// textured meshes give the paint's shader a new context for every triangle, which
+	// cannot be shared between threads, so those run by themselves
+	op.serial = (tex != nullptr && paint.getShader() != nullptr);
+	this->add_op(op, this->map_bounds(pts, vertex_count), false);
+}
+
+GShader* GCanvasTiled::makeRadialGradient(float cx, float cy, float radius, const GColor colors[], int count)
+{
+	return new GShaderRadial(cx, cy, radius, colors, count);
+}
+
+void GCanvasTiled::flush()
+{
+	this->build_clips();
+
+	int op_count = (int)this->m_ops.size();
+	int begin = 0;
+	while (begin < op_count)
+	{
+		if (this->m_ops[begin].serial == true)
+		{
+			// this one draws by itself on the whole bitmap
+			this->m_canvases[0]->set_device_clip(GIRect::MakeWH(this->m_bitmap.width(), this->m_bitmap.height()));
+			this->play_op(begin, 0);
+			++begin;
+			continue;
+		}
+
+		// then run as many ops as we can before some shader would need a different context
+		int end = this->setup_shader_contexts(begin);
+		this->m_pool.run((int)this->m_bins.size(), [this, end] (int tile, int thread)
+			{
+				this->play_tile(tile, thread, end);
+			}
+		);
+		begin = end;
+	}
+
+	// let go of the built clips, so their masks can be built into again
+	for (int i = 0; i < this->m_pool.thread_count(); ++i)
+	{
+		this->set_canvas_clip(i, ClipRecording::NO_CLIP);
+	}
+
+	// start a new recording, keeping the clips while the current or a saved clip could use them
+	this->m_ops.clear();
+	if (this->m_clip == ClipRecording::NO_CLIP && this->m_state_stack.empty() == true)
+	{
+		this->m_clips.clear();
+		this->m_built_clips.clear();
+	}
+	this->m_points.clear();
+	this->m_contours.clear();
+	this->m_indices.clear();
+	this->m_colors.clear();
+	for (int i = 0; i < (int)this->m_bins.size(); ++i)
+	{
+		this->m_bins[i].clear();
+		this->m_bin_positions[i] = 0;
+	}
+}
+
+void GCanvasTiled::add_op(const Op& op, const GRect& device_bounds, bool all_tiles)
+{
+	int op_index = (int)this->m_ops.size();
+	this->m_ops.push_back(op);
+	this->m_ops.back().ctm = this->m_ctm;
+	this->m_ops.back().clip = this->m_clip;
+
+	if (op.serial == true)
+	{
+		// not drawn by the tiles
+		return;
+	}
+
+	// nothing outside of the clip gets drawn
+	GRect bounds = device_bounds;
+	if (this->m_clip != ClipRecording::NO_CLIP)
+	{
+		const GRect& clip_bounds = this->m_clips.bounds(this->m_clip);
+		if (all_tiles == true)
+		{
+			bounds = clip_bounds;
+			all_tiles = false;
+		}
+		else if (bounds.intersect(clip_bounds) == false)
+		{
+			return;
+		}
+	}
+
+	// the bands that the bounds touch, pushed out a pixel for rounding
+	int band_top = 0;
+	int band_bottom = (int)this->m_bins.size();
+	if (all_tiles == false)
+	{
+		// pinned to just past the bitmap while still floats, since nothing has clipped them yet and
+		// they may be far past what an int holds
+		float width = (float)this->m_bitmap.width();
+		float height = (float)this->m_bitmap.height();
+		float pinned_left = std::min(std::max(bounds.fLeft, -1.0f), width + 1);
+		float pinned_right = std::min(std::max(bounds.fRight, -1.0f), width + 1);
+		float pinned_top = std::min(std::max(bounds.fTop, -1.0f), height + 1);
+		float pinned_bottom = std::min(std::max(bounds.fBottom, -1.0f), height + 1);
+
+		int top = std::max(GFloorToInt(pinned_top) - 1, 0);
+		int bottom = std::min(GCeilToInt(pinned_bottom) + 1, this->m_bitmap.height());
+		if (top >= bottom || GCeilToInt(pinned_right) + 1 <= 0 || GFloorToInt(pinned_left) - 1 >= this->m_bitmap.width())
+		{
+			// entirely off of the bitmap
+			return;
+		}
+		band_top = top / this->m_band_height;
+		band_bottom = (bottom + this->m_band_height - 1) / this->m_band_height;
+	}
+
+	for (int band = band_top; band < band_bottom; ++band)
+	{
+		this->m_bins[band].push_back(op_index);
+	}
+}
+
+GRect GCanvasTiled::map_bounds(const GPoint points[], int count) const
+{
+	// map the points a batch at a time
+	GPoint mapped[64];
+	GRect bounds = GRect::MakeLTRB(0, 0, 0, 0);
+	for (int first = 0; first < count; first += 64)
+	{
+		int n = std::min(count - first, 64);
+		this->m_ctm.mapPoints(mapped, points + first, n);
+		if (first == 0)
+		{
+			bounds = GRect::MakeLTRB(mapped[0].fX, mapped[0].fY, mapped[0].fX, mapped[0].fY);
+		}
+		for (int i = 0; i < n; ++i)
+		{
+			bounds.fLeft = std::min(bounds.fLeft, mapped[i].fX);
+			bounds.fTop = std::min(bounds.fTop, mapped[i].fY);
+			bounds.fRight = std::max(bounds.fRight, mapped[i].fX);
+			bounds.fBottom = std::max(bounds.fBottom, mapped[i].fY);
+		}
+	}
+	return bounds;
+}
+
+int GCanvasTiled::setup_shader_contexts(int begin)
+{
+	// the shaders given a context so far
+	struct Context
+	{
+		GShader* shader;
+		GMatrix ctm;
+		float alpha;
+		bool ok;
+	};
+	std::vector<Context> contexts;
+
+	int end = begin;
+	for (; end < (int)this->m_ops.size() && this->m_ops[end].serial == false; ++end)
+	{
+		Op& op = this->m_ops[end];
+		GShader* shader = op.paint.getShader();
+		if (shader == nullptr || op.type == OP_CLEAR || op.type == OP_BITMAP_RECT || op.type == OP_MESH)
+		{
+			// the paint's shader (if any) is not what gets drawn
+			continue;
+		}
+
+		bool found = false;
+		bool same = false;
+		for (const Context& context : contexts)
+		{
+			if (context.shader == shader)
+			{
+				found = true;
+				same = (context.alpha == op.paint.getAlpha());
+				for (int i = 0; i < 6; ++i)
+				{
+					same = same && (context.ctm[i] == op.ctm[i]);
+				}
+				op.context_ok = context.ok;
+				break;
+			}
+		}
+		if (found == true && same == false)
+		{
+			// the shader needs a different context here, so stop and let the tiles catch up
+			break;
+		}
+		if (found == false)
+		{
+			Context context = { shader, op.ctm, op.paint.getAlpha(), shader->setContext(op.ctm, op.paint.getAlpha()) };
+			contexts.push_back(context);
+			op.context_ok = context.ok;
+		}
+	}
+	return end;
+}
+
+void GCanvasTiled::play_tile(int tile, int thread, int end)
+{
+	// the clips are built for the whole bitmap, so one left on the canvas still works here
+	this->m_canvases[thread]->set_device_clip(GIRect::MakeXYWH(0, tile * this->m_band_height, this->m_bitmap.width(), this->m_band_height));
+
+	// the ops in this tile's bin before end, picking up where the last run of ops left off
+	const std::vector<int>& bin = this->m_bins[tile];
+	int& position = this->m_bin_positions[tile];
+	while (position < (int)bin.size() && bin[position] < end)
+	{
+		this->play_op(bin[position], thread);
+		++position;
+	}
+}
+
+void GCanvasTiled::build_clips()
+{
+	int clip_count = this->m_clips.count();
+	if ((int)this->m_built_clips.size() == clip_count)
+	{
+		return;
+	}
+
+	// the first canvas builds them with the whole bitmap, each one inside of the clip it was
+	// made in (which always comes before it)
+	GCanvasSteffey* canvas = this->m_canvases[0].get();
+	this->set_canvas_clip(0, ClipRecording::NO_CLIP);
+	canvas->set_device_clip(GIRect::MakeWH(this->m_bitmap.width(), this->m_bitmap.height()));
+	for (int i = (int)this->m_built_clips.size(); i < clip_count; ++i)
+	{
+		canvas->save();
+		int parent = this->m_clips.parent(i);
+		if (parent != ClipRecording::NO_CLIP)
+		{
+			canvas->set_clip_state(this->m_built_clips[parent]);
+		}
+		this->m_clips.apply_one(i, canvas);
+		this->m_built_clips.push_back(canvas->clip_state());
+		canvas->restore();
+	}
+}
+
+void GCanvasTiled::set_canvas_clip(int thread, int clip)
+{
+	int& current = this->m_canvas_clips[thread];
+	if (clip == current)
+	{
+		return;
+	}
+
+	// the canvas keeps one save around its clip, with the identity ctm under it
+	GCanvasSteffey* canvas = this->m_canvases[thread].get();
+	if (current != ClipRecording::NO_CLIP)
+	{
+		canvas->restore();
+	}
+	if (clip != ClipRecording::NO_CLIP)
+	{
+		canvas->save();
+		canvas->set_clip_state(this->m_built_clips[clip]);
+	}
+	current = clip;
+}
+
+void GCanvasTiled::play_op(int op_index, int thread)
+{
+	const Op& op = this->m_ops[op_index];
+	GCanvasSteffey* canvas = this->m_canvases[thread].get();
+	std::vector<GContour>& contours = this->m_contour_scratch[thread];
+	this->set_canvas_clip(thread, op.clip);
+	canvas->save();
+	canvas->concat(op.ctm);
+
+	// the tiles share shaders, so they get one whose context is already set
+	GPaint paint = op.paint;
+	PresetContextShader preset_shader(op.paint.getShader(), op.context_ok);
+	if (op.serial == false && paint.getShader() != nullptr)
+	{
+		paint.setShader(&preset_shader);
+	}
+
+	const GPoint* points = this->m_points.data() + op.first_point;
+	switch (op.type)
+	{
+		case OP_CLEAR:
+			canvas->clear(op.color);
+			break;
+		case OP_BITMAP_RECT:
+			canvas->fillBitmapRect(op.bitmap, op.rect);
+			break;
+		case OP_RECT:
+			canvas->drawRect(op.rect, paint);
+			break;
+		case OP_CONVEX_POLYGON:
+			canvas->drawConvexPolygon(points, op.point_count, paint);
+			break;
+		case OP_CONTOURS:
+			contours.clear();
+			for (int i = 0; i < op.contour_count; ++i)
+			{
+				const RecordedContour& recorded = this->m_contours[op.first_contour + i];
+				GContour contour = { recorded.count, this->m_points.data() + recorded.first_point, recorded.closed };
+				contours.push_back(contour);
+			}
+			canvas->drawContours(contours.data(), op.contour_count, paint);
+			break;
+		case OP_MESH:
+			canvas->drawMesh(op.tri_count, points,
+				(op.first_index >= 0 ? this->m_indices.data() + op.first_index : nullptr),
+				(op.first_color >= 0 ? this->m_colors.data() + op.first_color : nullptr),
+				(op.first_tex >= 0 ? this->m_points.data() + op.first_tex : nullptr), paint);
+			break;
+	}
+
+	canvas->restore();
+}
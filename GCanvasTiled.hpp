@@ -0,0 +1,168 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef GCanvasTiled_hpp
+#define GCanvasTiled_hpp
+
+#include "include/GCanvas.h"
+#include "include/GBitmap.h"
+#include "include/GColor.h"
+#include "include/GRect.h"
+#include "include/GMatrix.h"
+#include "include/GPaint.h"
+#include "include/GPoint.h"
+#include "include/GContour.h"
+#include "GCanvasSteffey.hpp"
+#include "ClipRecording.hpp"
+#include "PathFlattener.hpp"
+#include "ThreadPool.hpp"
+#include <memory>
+#include <stack>
+#include <vector>
+
+// a canvas that records its draws and plays them back one screen tile at a time,
+// with the tiles spread across a thread pool
+// every tile is drawn by a GCanvasSteffey limited to that tile, which works out the geometry
+// for the whole bitmap, so the pixels are exactly the ones the serial canvas would produce
+// the tiles are bands that go all the way across the bitmap, since the scan converters can
+// drop the edges above or below a band and jump the rest straight to its first row, but
+// still have to walk every edge across a row (left/right splits would just do that work
+// again) and shaders are run in the same chunks as the serial canvas
+class GCanvasTiled : public GCanvas
+{
+public:
+	GCanvasTiled(const GBitmap& bitmap, int thread_count);
+
+	// draws anything still recorded
+	~GCanvasTiled();
+
+	void save() override;
+	void restore() override;
+	void concat(const GMatrix& matrix) override;
+	void clipRect(const GRect& rect) override;
+	void clipPath(const GPath& path) override;
+
+	void clear(const GColor& color) override;
+	void fillBitmapRect(const GBitmap& src, const GRect& dst) override;
+	void drawRect(const GRect& rect, const GPaint& paint) override;
+	void drawConvexPolygon(const GPoint points[], int count, const GPaint& paint) override;
+	void drawContours(const GContour ctrs[], int count, const GPaint& paint) override;
+	void drawPath(const GPath& path, const GPaint& paint) override;
+	void drawMesh(int triCount, const GPoint pts[], const int indices[], const GColor colors[], const GPoint tex[], const GPaint& paint) override;
+
+	GShader* makeRadialGradient(float cx, float cy, float radius, const GColor colors[], int count) override;
+
+	// rasterize everything recorded so far
+	void flush() override;
+
+private:
+	enum
+	{
+		// a few bands per thread so the stealing has something to balance with
+		BANDS_PER_THREAD = 2,
+
+		// but not so thin the setup of each draw costs more than its rows
+		MIN_BAND_HEIGHT = 16,
+	};
+
+	enum OpType
+	{
+		OP_CLEAR,
+		OP_BITMAP_RECT,
+		OP_RECT,
+		OP_CONVEX_POLYGON,
+		OP_CONTOURS,
+		OP_MESH,
+	};
+
+	// one recorded draw, its points and such live in the shared arrays below
+	struct Op
+	{
+		OpType type;
+		GMatrix ctm;
+
+		// into m_clips, or ClipRecording::NO_CLIP
+		int clip;
+		GPaint paint;
+		GColor color;
+		GRect rect;
+		GBitmap bitmap;
+
+		// into m_points, and for contours into m_contours
+		int first_point;
+		int point_count;
+		int first_contour;
+		int contour_count;
+
+		// meshes, each of these is -1 when the draw did not have it
+		int tri_count;
+		int first_index;
+		int first_color;
+		int first_tex;
+
+		// draws that have to run on their own across the whole bitmap
+		bool serial;
+
+		// the pre-set shader context for this draw, from setup_shader_contexts
+		bool context_ok;
+	};
+
+	// a contour, pointing into m_points
+	struct RecordedContour
+	{
+		int first_point;
+		int count;
+		bool closed;
+	};
+
+	// add a recorded op and put it into the bins of the tiles its device bounds touch
+	void add_op(const Op& op, const GRect& device_bounds, bool all_tiles);
+	GRect map_bounds(const GPoint points[], int count) const;
+
+	// set the contexts of the shaders used by ops [begin, ...) until a shader would need a
+	// second context, and return where that run of ops ends
+	int setup_shader_contexts(int begin);
+
+	// draw one op with one of the per thread canvases
+	void play_op(int op_index, int thread);
+
+	// build the clips recorded since the last flush into m_built_clips
+	void build_clips();
+
+	// make the clip of thread's canvas clip index, or put it back to none with NO_CLIP
+	void set_canvas_clip(int thread, int clip);
+
+	// draw the ops of one tile that come before end, from where its last run stopped
+	void play_tile(int tile, int thread, int end);
+
+	GBitmap m_bitmap;
+	std::stack<std::pair<GMatrix, int>> m_state_stack;
+	GMatrix m_ctm;
+	int m_clip;
+
+	// the recording
+	std::vector<Op> m_ops;
+	std::vector<GPoint> m_points;
+	std::vector<RecordedContour> m_contours;
+	std::vector<int> m_indices;
+	std::vector<GColor> m_colors;
+	ClipRecording m_clips;
+
+	// each recorded clip built once for the whole bitmap, by index, shared by every tile's canvas
+	std::vector<GCanvasSteffey::ClipState> m_built_clips;
+
+	// turns paths into contours for drawPath, keeping its buffers between them
+	PathFlattener m_path_flattener;
+
+	// the bands and the op indices that touch each one, in order
+	int m_band_height;
+	std::vector<std::vector<int>> m_bins;
+	std::vector<int> m_bin_positions;
+
+	// the threads, each with its own canvas (and the clip it is set to) and contour scratch
+	ThreadPool m_pool;
+	std::vector<std::unique_ptr<GCanvasSteffey>> m_canvases;
+	std::vector<int> m_canvas_clips;
+	std::vector<std::vector<GContour>> m_contour_scratch;
+};
+
+#endif
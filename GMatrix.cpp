@@ -1,6 +1,11 @@
 // Copyright Daniel J. Steffey -- 2016
 
 #include "include/GMatrix.h"
+#include <cstring>
+
+#ifdef __SSE2__
+	#include <emmintrin.h>
+#endif
 
 void GMatrix::setIdentity()
 {
@@ -10,6 +15,7 @@ void GMatrix::setIdentity()
 	this->fMat[KY] = 0;
 	this->fMat[SY] = 1;
 	this->fMat[TY] = 0;
+	this->fTypeMask = kIdentity_Mask;
 }
 
 void GMatrix::setTranslate(float tx, float ty)
@@ -20,6 +26,7 @@ void GMatrix::setTranslate(float tx, float ty)
 	this->fMat[KY] = 0;
 	this->fMat[SY] = 1;
 	this->fMat[TY] = ty;
+	this->fTypeMask = kUnknown_Mask;
 }
 
 void GMatrix::setScale(float sx, float sy)
@@ -30,6 +37,7 @@ void GMatrix::setScale(float sx, float sy)
 	this->fMat[KY] = 0;
 	this->fMat[SY] = sy;
 	this->fMat[TY] = 0;
+	this->fTypeMask = kUnknown_Mask;
 }
 
 void GMatrix::setRotate(float radians)
@@ -40,6 +48,7 @@ void GMatrix::setRotate(float radians)
     this->fMat[KY] = std::sin(radians);
     this->fMat[SY] = std::cos(radians);
     this->fMat[TY] = 0;
+    this->fTypeMask = kUnknown_Mask;
 }
 
 void GMatrix::setConcat(const GMatrix& secundo, const GMatrix& primo)
@@ -57,6 +66,7 @@ void GMatrix::setConcat(const GMatrix& secundo, const GMatrix& primo)
     this->fMat[KY] = ky;
     this->fMat[SY] = sy;
     this->fMat[TY] = ty;
+    this->fTypeMask = kUnknown_Mask;
 }
 
 bool GMatrix::invert(GMatrix* inverse) const
@@ -91,20 +101,122 @@ bool GMatrix::invert(GMatrix* inverse) const
 	inverse->fMat[KY] = ky;
 	inverse->fMat[SY] = sy;
 	inverse->fMat[TY] = ty;
+	inverse->fTypeMask = kUnknown_Mask;
 
     return true;
 }
 
+unsigned GMatrix::computeType() const
+{
+	unsigned mask = kIdentity_Mask;
+	if (this->fMat[TX] != 0 || this->fMat[TY] != 0)
+	{
+		mask |= kTranslate_Mask;
+	}
+	if (this->fMat[SX] != 1 || this->fMat[SY] != 1)
+	{
+		mask |= kScale_Mask;
+	}
+	if (this->fMat[KX] != 0 || this->fMat[KY] != 0)
+	{
+		mask |= kAffine_Mask;
+	}
+	return mask;
+}
+
+// the routines for each type of matrix
+// the terms that are left out are 1 * x or 0 * y, which cannot change the sum for finite points,
+// and the sse2 versions do two points at a time with the same operations in the same order,
+// so every routine gives exactly the same points as the full affine math
+static void map_translate(const float m[6], GPoint dst[], const GPoint src[], int count)
+{
+	float tx = m[GMatrix::TX];
+	float ty = m[GMatrix::TY];
+	int i = 0;
+#ifdef __SSE2__
+	__m128 t = _mm_setr_ps(tx, ty, tx, ty);
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128 p = _mm_loadu_ps(&src[i].fX);
+		_mm_storeu_ps(&dst[i].fX, _mm_add_ps(p, t));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		dst[i] = GPoint::Make(src[i].fX + tx, src[i].fY + ty);
+	}
+}
+
+static void map_scale(const float m[6], GPoint dst[], const GPoint src[], int count)
+{
+	float sx = m[GMatrix::SX];
+	float sy = m[GMatrix::SY];
+	float tx = m[GMatrix::TX];
+	float ty = m[GMatrix::TY];
+	int i = 0;
+#ifdef __SSE2__
+	__m128 s = _mm_setr_ps(sx, sy, sx, sy);
+	__m128 t = _mm_setr_ps(tx, ty, tx, ty);
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128 p = _mm_loadu_ps(&src[i].fX);
+		_mm_storeu_ps(&dst[i].fX, _mm_add_ps(_mm_mul_ps(p, s), t));
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		dst[i] = GPoint::Make(sx * src[i].fX + tx, sy * src[i].fY + ty);
+	}
+}
+
+static void map_affine(const float m[6], GPoint dst[], const GPoint src[], int count)
+{
+	int i = 0;
+#ifdef __SSE2__
+	// x' = SX * x + KX * y and y' = SY * y + KY * x, with (y, x) swapped into each point's lanes
+	__m128 s = _mm_setr_ps(m[GMatrix::SX], m[GMatrix::SY], m[GMatrix::SX], m[GMatrix::SY]);
+	__m128 k = _mm_setr_ps(m[GMatrix::KX], m[GMatrix::KY], m[GMatrix::KX], m[GMatrix::KY]);
+	__m128 t = _mm_setr_ps(m[GMatrix::TX], m[GMatrix::TY], m[GMatrix::TX], m[GMatrix::TY]);
+	for (; i + 2 <= count; i += 2)
+	{
+		__m128 p = _mm_loadu_ps(&src[i].fX);
+		__m128 swapped = _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 mapped = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p, s), _mm_mul_ps(swapped, k)), t);
+		_mm_storeu_ps(&dst[i].fX, mapped);
+	}
+#endif
+	for (; i < count; ++i)
+	{
+		GPoint temp;
+		temp.fX = (m[GMatrix::SX] * src[i].fX) + (m[GMatrix::KX] * src[i].fY) + m[GMatrix::TX];
+		temp.fY = (m[GMatrix::KY] * src[i].fX) + (m[GMatrix::SY] * src[i].fY) + m[GMatrix::TY];
+		dst[i] = temp;
+	}
+}
+
 void GMatrix::mapPoints(GPoint dst[], const GPoint src[], int count) const
 {
-	for (int i = 0; i < count; ++i)
+	// only read the remembered type, working it out here does not write to the matrix
+	unsigned mask = this->fTypeMask;
+	if (mask == kUnknown_Mask)
 	{
-        GPoint temp;
+		mask = this->computeType();
+	}
 
-		temp.fX = (this->fMat[SX] * src[i].fX) + (this->fMat[KX] * src[i].fY) + this->fMat[TX];
-		temp.fY = (this->fMat[KY] * src[i].fX) + (this->fMat[SY] * src[i].fY) + this->fMat[TY];
-	
-		dst[i].fX = temp.fX;
-		dst[i].fY = temp.fY;
+	if (mask & kAffine_Mask)
+	{
+		map_affine(this->fMat, dst, src, count);
+	}
+	else if (mask & kScale_Mask)
+	{
+		map_scale(this->fMat, dst, src, count);
 	}
-}
\ No newline at end of file
+	else if (mask & kTranslate_Mask)
+	{
+		map_translate(this->fMat, dst, src, count);
+	}
+	else if (dst != src && count > 0)
+	{
+		memcpy(dst, src, sizeof(GPoint) * count);
+	}
+}
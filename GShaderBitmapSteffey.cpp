@@ -1,9 +1,13 @@
 // Copyright Daniel J. Steffey -- 2016
 
 #include "GShaderBitmapSteffey.hpp"
+#include "BitmapFilters.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 
-GShader* GShader::FromBitmap(const GBitmap& bitmap, const GMatrix& local_matrix, GShader::TileMode tilemode)
+GShader* GShader::FromBitmap(const GBitmap& bitmap, const GMatrix& local_matrix, GShader::TileMode tilemode, GShader::FilterQuality filter)
 {
 	// check for valid parameters on the bitmap
 	if (bitmap.fWidth <= 0)
@@ -25,10 +29,211 @@ GShader* GShader::FromBitmap(const GBitmap& bitmap, const GMatrix& local_matrix,
 	// the local matrix can really be about anything
 	// so no checks there
 	// return out shader
-	return new GShaderBitmapSteffey(bitmap, local_matrix, tilemode);
+	return new GShaderBitmapSteffey(bitmap, local_matrix, tilemode, filter);
 }
 
-GShaderBitmapSteffey::GShaderBitmapSteffey(const GBitmap& bitmap, const GMatrix& local_ctm, GShader::TileMode tilemode)
+/////////////////////////////////////////////////////////////////////////////////////////////////
+// nearest row procs, one for each kind of matrix, tile mode, and whether the alpha is 1
+
+// the pixel index for i, for a bitmap size pixels across
+template <GShader::TileMode tilemode> static inline int tile_nearest(int i, int size)
+{
+	if (tilemode == GShader::kClamp)
+	{
+		return std::max(0, std::min(i, size - 1));
+	}
+	if (tilemode == GShader::kRepeat)
+	{
+		i %= size;
+		return (i < 0 ? i + size : i);
+	}
+	// mirror repeats every other copy backwards
+	i %= size * 2;
+	if (i < 0)
+	{
+		i += size * 2;
+	}
+	return (i >= size ? (size * 2) - i - 1 : i);
+}
+
+// the pixel a sample point lands in (rounding down, so it works past the left and top too)
+static inline int floor_to_int(float value)
+{
+	int i = (int)value;
+	return (value < i ? i - 1 : i);
+}
+
+static inline const GPixel* bitmap_row(const GBitmap& bitmap, int y)
+{
+	return bitmap.pixels() + ((bitmap.rowBytes() >> 2) * y);
+}
+
+template <bool modulate> static inline GPixel modulate_pixel(GPixel pixel, float alpha)
+{
+	if (modulate == false)
+	{
+		return pixel;
+	}
+	int a = GPixel_GetA(pixel) * alpha;
+	int r = GPixel_GetR(pixel) * alpha;
+	int g = GPixel_GetG(pixel) * alpha;
+	int b = GPixel_GetB(pixel) * alpha;
+	return GPixel_PackARGB(a, r, g, b);
+}
+
+// count pixels in a row starting at src, copied straight when there is no alpha to apply
+template <bool modulate> static inline void copy_pixels(GPixel dst[], const GPixel src[], int count, float alpha)
+{
+	if (modulate == false)
+	{
+		memcpy(dst, src, count * sizeof(GPixel));
+		return;
+	}
+	for (int i = 0; i < count; ++i)
+	{
+		dst[i] = modulate_pixel<true>(src[i], alpha);
+	}
+}
+
+// anything goes, both coordinates step for every pixel
+template <GShader::TileMode tilemode, bool modulate>
+static void nearest_row_affine(const GBitmap& bitmap, const GMatrix& inverse, float alpha, int x, int y, int count, GPixel row[])
+{
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+	for (int i = 0; i < count; ++i)
+	{
+		int src_x = tile_nearest<tilemode>(floor_to_int(src_point.fX), bitmap.width());
+		int src_y = tile_nearest<tilemode>(floor_to_int(src_point.fY), bitmap.height());
+		row[i] = modulate_pixel<modulate>(bitmap_row(bitmap, src_y)[src_x], alpha);
+
+		src_point.fX += inverse[GMatrix::SX];
+		src_point.fY += inverse[GMatrix::KY];
+	}
+}
+
+// no skew, the whole row reads from one row of the bitmap and only x steps
+template <GShader::TileMode tilemode, bool modulate>
+static void nearest_row_scale(const GBitmap& bitmap, const GMatrix& inverse, float alpha, int x, int y, int count, GPixel row[])
+{
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+	const GPixel* src_row = bitmap_row(bitmap, tile_nearest<tilemode>(floor_to_int(src_point.fY), bitmap.height()));
+
+	// x steps exactly the way it does for affine so both pick the same pixels
+	float src_x = src_point.fX;
+	const float dx = inverse[GMatrix::SX];
+	for (int i = 0; i < count; ++i)
+	{
+		row[i] = modulate_pixel<modulate>(src_row[tile_nearest<tilemode>(floor_to_int(src_x), bitmap.width())], alpha);
+		src_x += dx;
+	}
+}
+
+// only moved, the row is runs of the bitmap's pixels copied in order (or reversed for mirror)
+template <GShader::TileMode tilemode, bool modulate>
+static void nearest_row_translate(const GBitmap& bitmap, const GMatrix& inverse, float alpha, int x, int y, int count, GPixel row[])
+{
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+
+	// stepping by 1 picks the next pixel over every time only while every step is exact in
+	// floats, which holds for an offset in 1/256ths with room to spare in the mantissa
+	float scaled = src_point.fX * 256.0f;
+	if (scaled != std::floor(scaled) || std::fabs(src_point.fX) + count >= 32768.0f)
+	{
+		nearest_row_scale<tilemode, modulate>(bitmap, inverse, alpha, x, y, count, row);
+		return;
+	}
+
+	const int width = bitmap.width();
+	const GPixel* src_row = bitmap_row(bitmap, tile_nearest<tilemode>(floor_to_int(src_point.fY), bitmap.height()));
+	int src_x = floor_to_int(src_point.fX);
+	int i = 0;
+	if (tilemode == GShader::kClamp)
+	{
+		// the left edge pixel, the pixels in between, then the right edge pixel
+		GPixel left = modulate_pixel<modulate>(src_row[0], alpha);
+		for (; i < count && src_x + i < 0; ++i)
+		{
+			row[i] = left;
+		}
+		int n = std::min(count - i, width - (src_x + i));
+		if (n > 0)
+		{
+			copy_pixels<modulate>(row + i, src_row + src_x + i, n, alpha);
+			i += n;
+		}
+		GPixel right = modulate_pixel<modulate>(src_row[width - 1], alpha);
+		for (; i < count; ++i)
+		{
+			row[i] = right;
+		}
+	}
+	else if (tilemode == GShader::kRepeat)
+	{
+		// from wherever we are in the bitmap to its right edge, then around again
+		while (i < count)
+		{
+			int start = tile_nearest<GShader::kRepeat>(src_x + i, width);
+			int n = std::min(count - i, width - start);
+			copy_pixels<modulate>(row + i, src_row + start, n, alpha);
+			i += n;
+		}
+	}
+	else
+	{
+		// forward runs to the right edge and backward runs to the left edge, taking turns
+		while (i < count)
+		{
+			int period = (src_x + i) % (width * 2);
+			if (period < 0)
+			{
+				period += width * 2;
+			}
+			if (period < width)
+			{
+				int n = std::min(count - i, width - period);
+				copy_pixels<modulate>(row + i, src_row + period, n, alpha);
+				i += n;
+			}
+			else
+			{
+				int n = std::min(count - i, (width * 2) - period);
+				const GPixel* src = src_row + (width * 2) - period - 1;
+				for (int k = 0; k < n; ++k)
+				{
+					row[i + k] = modulate_pixel<modulate>(src[-k], alpha);
+				}
+				i += n;
+			}
+		}
+	}
+}
+
+// the row procs and their names, for one kind of matrix
+struct NearestRowProcs
+{
+	NearestRowProc procs[3][2];
+	const char* names[3];
+};
+
+#define NEAREST_ROW_PROCS(kind) \
+	NearestRowProcs{ \
+		{ \
+			{ nearest_row_##kind<GShader::kClamp, false>, nearest_row_##kind<GShader::kClamp, true> }, \
+			{ nearest_row_##kind<GShader::kRepeat, false>, nearest_row_##kind<GShader::kRepeat, true> }, \
+			{ nearest_row_##kind<GShader::kMirror, false>, nearest_row_##kind<GShader::kMirror, true> }, \
+		}, \
+		{ #kind "_clamp", #kind "_repeat", #kind "_mirror" } \
+	}
+
+static const NearestRowProcs kTranslateProcs = NEAREST_ROW_PROCS(translate);
+static const NearestRowProcs kScaleProcs = NEAREST_ROW_PROCS(scale);
+static const NearestRowProcs kAffineProcs = NEAREST_ROW_PROCS(affine);
+
+#undef NEAREST_ROW_PROCS
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+GShaderBitmapSteffey::GShaderBitmapSteffey(const GBitmap& bitmap, const GMatrix& local_ctm, GShader::TileMode tilemode, GShader::FilterQuality filter)
 {
 	this->m_bitmap = &bitmap;
 	this->m_local_ctm = local_ctm;
@@ -37,6 +242,14 @@ GShaderBitmapSteffey::GShaderBitmapSteffey(const GBitmap& bitmap, const GMatrix&
 	this->m_combined_ctm.invert(&(this->m_combined_ctm));
 	this->m_alpha = 1.0f;
 	this->m_tilemode = tilemode;
+	this->m_filter = filter;
+	this->m_context_filter = filter;
+	this->m_alpha_scale = 256;
+	this->m_level_bitmap = this->m_bitmap;
+	this->m_level_ctm = this->m_combined_ctm;
+	this->m_next_level_bitmap = nullptr;
+	this->m_level_blend = 0;
+	this->choose_row_proc();
 }
 
 GShaderBitmapSteffey::~GShaderBitmapSteffey()
@@ -58,68 +271,173 @@ bool GShaderBitmapSteffey::setContext(const GMatrix& ctm, float alpha)
 	{
 		return false;
 	}
-	
+
+	// the filtered samplers scale by the alpha in fixed point
+	this->m_alpha_scale = (int)std::floor(std::max(0.0f, std::min(alpha, 1.0f)) * 256.0f + 0.5f);
+
+	// when the bitmap is only moved by whole pixels every sample point is on a pixel center,
+	// so the filters would just hand back that pixel
+	const GMatrix& inverse = this->m_combined_ctm;
+	bool whole_pixels = inverse[GMatrix::SX] == 1.0f && inverse[GMatrix::KX] == 0.0f &&
+		inverse[GMatrix::KY] == 0.0f && inverse[GMatrix::SY] == 1.0f &&
+		inverse[GMatrix::TX] == std::floor(inverse[GMatrix::TX]) && inverse[GMatrix::TY] == std::floor(inverse[GMatrix::TY]);
+	this->m_context_filter = this->m_filter;
+	if (whole_pixels == true && this->m_tilemode == GShader::kClamp)
+	{
+		this->m_context_filter = GShader::kNearest;
+	}
+
+	// any mip levels get made here rather than while shading, where rows can be running on
+	// several threads at once
+	this->choose_levels();
+	this->choose_row_proc();
+
 	// success
 	return true;
 }
 
-void GShaderBitmapSteffey::shadeRow(int x, int y, int count, GPixel row[])
+void GShaderBitmapSteffey::choose_levels()
 {
-	// calculate the first source point
-	GPoint src_point = this->m_combined_ctm.mapXY(x + 0.5f, y + 0.5f);
+	this->m_level_bitmap = this->m_bitmap;
+	this->m_level_ctm = this->m_combined_ctm;
+	this->m_next_level_bitmap = nullptr;
+	this->m_level_blend = 0;
+	if (this->m_context_filter != GShader::kTrilinear)
+	{
+		// only trilinear asks for the mip levels, the others sample the bitmap itself
+		return;
+	}
 
-	// loop through the count number of pixels
-	for (int i = 0; i < count; ++i)
+	// how many bitmap pixels go by for each device pixel, averaged over the two directions,
+	// as a power of two
+	const GMatrix& inverse = this->m_combined_ctm;
+	float area = std::fabs(inverse[GMatrix::SX] * inverse[GMatrix::SY] - inverse[GMatrix::KX] * inverse[GMatrix::KY]);
+	float lod = 0.5f * std::log2(area);
+	if (!(lod > 0.0f))
 	{
-		int src_x = 0;
-		int src_y = 0;
-		if (this->m_tilemode == GShader::kClamp)
-		{
-			// clamp to the min (0) and max (bitmap width - 1) values
-			src_x = std::max(0, std::min((int)(src_point.fX), this->m_bitmap->fWidth - 1));
-			src_y = std::max(0, std::min((int)(src_point.fY), this->m_bitmap->fHeight - 1));
-		}
-		else if (this->m_tilemode == GShader::kRepeat)
-		{
-			src_x = ((int)(src_point.fX)) % (this->m_bitmap->fWidth);
-			src_y = ((int)(src_point.fY)) % (this->m_bitmap->fHeight);
-		}
-		else if (this->m_tilemode == GShader::kMirror)
-		{
-			src_x = ((int)(src_point.fX)) % (this->m_bitmap->fWidth * 2);
-			src_y = ((int)(src_point.fY)) % (this->m_bitmap->fHeight * 2);
-			if (src_x >= this->m_bitmap->fWidth)
-			{
-				src_x = (this->m_bitmap->fWidth * 2) - src_x - 1;
-			}
-			if (src_y >= this->m_bitmap->fHeight)
-			{
-				src_y = (this->m_bitmap->fHeight * 2) - src_y - 1;
-			}
-		}
+		// not shrunk (or a NaN from a degenerate matrix), the filter works on the bitmap itself
+		return;
+	}
+
+	// blend the two levels on either side of the scale
+	int level = (int)std::floor(lod);
+	int blend = (int)std::floor((lod - level) * 256.0f + 0.5f);
+	if (blend == 256)
+	{
+		level++;
+		blend = 0;
+	}
+	if (level == 0 && blend == 0)
+	{
+		return;
+	}
+
+	if (this->m_mipmap == nullptr)
+	{
+		this->m_mipmap.reset(new Mipmap(*this->m_bitmap));
+	}
+	if (level >= this->m_mipmap->max_level())
+	{
+		level = this->m_mipmap->max_level();
+		blend = 0;
+	}
 
-		// get the row of pixels from the source
-		GPixel* src_row = this->m_bitmap->pixels() + ((this->m_bitmap->rowBytes() >> 2) * src_y);
+	// the matrix into a level scales the one into the bitmap down by how much smaller it is
+	const GBitmap& bitmap = this->m_mipmap->level(level);
+	GMatrix scale;
+	scale.setScale(bitmap.width() / (float)this->m_bitmap->width(), bitmap.height() / (float)this->m_bitmap->height());
+	this->m_level_bitmap = &bitmap;
+	this->m_level_ctm.setConcat(scale, inverse);
 
-		// now need to modulate that by the context alpha
-		if (this->m_alpha == 1.0f)
+	if (blend > 0)
+	{
+		const GBitmap& next_bitmap = this->m_mipmap->level(level + 1);
+		scale.setScale(next_bitmap.width() / (float)this->m_bitmap->width(), next_bitmap.height() / (float)this->m_bitmap->height());
+		this->m_next_level_bitmap = &next_bitmap;
+		this->m_next_level_ctm.setConcat(scale, inverse);
+		this->m_level_blend = blend;
+	}
+}
+
+void GShaderBitmapSteffey::choose_row_proc()
+{
+	// the tile modes are in the same order as the procs
+	const GMatrix& inverse = this->m_combined_ctm;
+	const NearestRowProcs* procs = &kAffineProcs;
+	if (inverse[GMatrix::KX] == 0.0f && inverse[GMatrix::KY] == 0.0f)
+	{
+		procs = &kScaleProcs;
+		if (inverse[GMatrix::SX] == 1.0f && inverse[GMatrix::SY] == 1.0f)
 		{
-			row[i] = src_row[src_x];
+			procs = &kTranslateProcs;
 		}
-		else
-		{
-			int a = GPixel_GetA(src_row[src_x]) * this->m_alpha;
-			int r = GPixel_GetR(src_row[src_x]) * this->m_alpha;
-			int g = GPixel_GetG(src_row[src_x]) * this->m_alpha;
-			int b = GPixel_GetB(src_row[src_x]) * this->m_alpha;
+	}
+	this->m_nearest_proc = procs->procs[this->m_tilemode][this->m_alpha != 1.0f];
+	this->m_row_proc_name = procs->names[this->m_tilemode];
 
-			// save it to the row
-			row[i] = GPixel_PackARGB(a, r, g, b);
-		}
+	if (this->m_context_filter == GShader::kBilinear)
+	{
+		this->m_row_proc_name = "bilinear";
+	}
+	else if (this->m_context_filter == GShader::kTrilinear)
+	{
+		// not shrunk enough to blend in a second level is just bilinear in one of them
+		this->m_row_proc_name = (this->m_next_level_bitmap != nullptr ? "trilinear" : "bilinear");
+	}
+	else if (this->m_context_filter == GShader::kBicubic)
+	{
+		this->m_row_proc_name = "bicubic";
+	}
+}
+
+// turn a coordinate in the bitmap into 16.16, kept far enough from the limits that
+// a row's worth of steps cannot overflow
+static inline int64_t to_fixed(float value)
+{
+	const double limit = 1 << 30;
+	return (int64_t)std::floor(std::max(-limit, std::min((double)value, limit)) * 65536.0 + 0.5);
+}
+
+void GShaderBitmapSteffey::shadeRow(int x, int y, int count, GPixel row[])
+{
+	if (this->m_context_filter == GShader::kNearest)
+	{
+		this->m_nearest_proc(*this->m_bitmap, this->m_combined_ctm, this->m_alpha, x, y, count, row);
+		return;
+	}
+
+	this->shade_row_filtered(*this->m_level_bitmap, this->m_level_ctm, x, y, count, row);
+	if (this->m_next_level_bitmap == nullptr)
+	{
+		return;
+	}
 
-		// increment the source point based on values in the matrix
-		src_point.fX += this->m_combined_ctm[GMatrix::SX];
-		src_point.fY += this->m_combined_ctm[GMatrix::KY];
+	// trilinear, shade the next level a piece at a time and blend it in
+	const int CHUNK = 64;
+	GPixel next_row[CHUNK];
+	for (int i = 0; i < count; i += CHUNK)
+	{
+		int n = std::min(CHUNK, count - i);
+		this->shade_row_filtered(*this->m_next_level_bitmap, this->m_next_level_ctm, x + i, y, n, next_row);
+		lerp_row(row + i, next_row, this->m_level_blend, n);
+	}
+}
+
+void GShaderBitmapSteffey::shade_row_filtered(const GBitmap& bitmap, const GMatrix& inverse, int x, int y, int count, GPixel row[])
+{
+	// the sample point for the first pixel, moved so the bitmap's pixel centers are on whole numbers
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+	int64_t src_x = to_fixed(src_point.fX - 0.5f);
+	int64_t src_y = to_fixed(src_point.fY - 0.5f);
+	int64_t dx = to_fixed(inverse[GMatrix::SX]);
+	int64_t dy = to_fixed(inverse[GMatrix::KY]);
 
+	if (this->m_context_filter == GShader::kBilinear || this->m_context_filter == GShader::kTrilinear)
+	{
+		bilinear_row(bitmap, this->m_tilemode, src_x, src_y, dx, dy, this->m_alpha_scale, count, row);
+	}
+	else
+	{
+		bicubic_row(bitmap, this->m_tilemode, src_x, src_y, dx, dy, this->m_alpha_scale, count, row);
 	}
-}
\ No newline at end of file
+}
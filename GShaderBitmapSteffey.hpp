@@ -7,11 +7,18 @@
 #include "include/GBitmap.h"
 #include "include/GMatrix.h"
 #include "include/GPixel.h"
+#include "Mipmap.hpp"
+#include <memory>
+
+// writes count pixels of a row from the bitmap with the nearest filter, given the matrix from
+// device space into the bitmap and the alpha to scale them by
+typedef void (*NearestRowProc)(const GBitmap& bitmap, const GMatrix& inverse, float alpha, int x, int y, int count, GPixel row[]);
 
 class GShaderBitmapSteffey : public GShader
 {
 public:
-    GShaderBitmapSteffey(const GBitmap&, const GMatrix& local_matrix, GShader::TileMode tilemode);
+    GShaderBitmapSteffey(const GBitmap&, const GMatrix& local_matrix, GShader::TileMode tilemode,
+                         GShader::FilterQuality filter = GShader::kNearest);
     ~GShaderBitmapSteffey();
 
     /**
@@ -29,16 +36,53 @@ public:
      */
     void shadeRow(int x, int y, int count, GPixel row[]) override;
 
+    // the name of the row routine setContext picked, so tests and benches can check that the
+    // fast paths are being taken ("translate_clamp", "scale_repeat", "affine_mirror", "bilinear", ...)
+    const char* row_proc_name() const { return this->m_row_proc_name; }
+
 protected:
 
 
 private:
+    // run the filter over one mip level, with the matrix from device space into that level
+    void shade_row_filtered(const GBitmap& bitmap, const GMatrix& inverse, int x, int y, int count, GPixel row[]);
+
+    // pick the mip levels for how much the current context shrinks the bitmap
+    void choose_levels();
+
+    // pick the nearest row proc for the matrix and tile mode, and name whichever routine is used
+    void choose_row_proc();
+
     const GBitmap* m_bitmap;
     GMatrix m_local_ctm;
     GMatrix m_global_ctm;
     GMatrix m_combined_ctm;
     float m_alpha;
     GShader::TileMode m_tilemode;
+
+    // the filter asked for, and the one actually used for the current context
+    // (a matrix that lands every sample point on a pixel center does not need filtering)
+    GShader::FilterQuality m_filter;
+    GShader::FilterQuality m_context_filter;
+
+    // the alpha out of 256 for the filtered samplers
+    int m_alpha_scale;
+
+    // the smaller copies of the bitmap for trilinear, made the first time the shader is drawn
+    // shrunk down and kept for as long as the shader is around
+    std::unique_ptr<Mipmap> m_mipmap;
+
+    // the level (and matrix into it) the filtered samplers read for the current context,
+    // plus the next smaller level that trilinear blends in by m_level_blend out of 256
+    const GBitmap* m_level_bitmap;
+    GMatrix m_level_ctm;
+    const GBitmap* m_next_level_bitmap;
+    GMatrix m_next_level_ctm;
+    int m_level_blend;
+
+    // the row proc for the nearest filter, and the name of the routine shadeRow goes to
+    NearestRowProc m_nearest_proc;
+    const char* m_row_proc_name;
 };
 
 #endif
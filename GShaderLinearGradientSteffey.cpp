@@ -1,7 +1,6 @@
 // Copyright Daniel J. Steffey -- 2016
 
 #include "GShaderLinearGradientSteffey.hpp"
-#include "utils.hpp"
 #include <cmath>
 
 
@@ -9,12 +8,23 @@ GShader* GShader::LinearGradient(const GPoint& p0, const GPoint& p1, const GColo
 {
 	// sanity checks
 	// cant think of any
-	return new GShaderLinearGradientSteffey(p0, p1, c0, c1, tilemode);
+	const GColor colors[] = { c0, c1 };
+	return new GShaderLinearGradientSteffey(p0, p1, colors, nullptr, 2, tilemode);
 }
 
+GShader* GShader::LinearGradient(const GPoint& p0, const GPoint& p1, const GColor colors[], const float positions[], int count, GShader::TileMode tilemode)
+{
+	// need at least one color
+	if (count < 1 || colors == nullptr)
+	{
+		return nullptr;
+	}
+	return new GShaderLinearGradientSteffey(p0, p1, colors, positions, count, tilemode);
+}
 
 
-GShaderLinearGradientSteffey::GShaderLinearGradientSteffey(const GPoint& p0, const GPoint& p1, const GColor& c0, const GColor& c1, GShader::TileMode tilemode)
+
+GShaderLinearGradientSteffey::GShaderLinearGradientSteffey(const GPoint& p0, const GPoint& p1, const GColor colors[], const float positions[], int count, GShader::TileMode tilemode)
 {
 	// calculate the local matrix
 	float dx = p1.fX - p0.fX;
@@ -33,12 +43,16 @@ GShaderLinearGradientSteffey::GShaderLinearGradientSteffey(const GPoint& p0, con
 	// set our alpha
 	this->m_alpha = 1.0f;
 
-	// save the colors
-	this->m_c0 = c0;
-	this->m_c1 = c1;
+	// save the stops
+	this->m_colors.assign(colors, colors + count);
+	this->m_positions.resize(count);
+	pin_gradient_positions(positions, count, this->m_positions.data());
 
 	// save our tilemode
 	this->m_tilemode = tilemode;
+
+	// no table yet
+	this->m_table_alpha = -1.0f;
 }
 
 GShaderLinearGradientSteffey::~GShaderLinearGradientSteffey()
@@ -61,98 +75,55 @@ bool GShaderLinearGradientSteffey::setContext(const GMatrix& ctm, float alpha)
 		return false;
 	}
 
-	// generate our lookup table
-	// the change in the color components each loop
-	float delta_ca = (1.0f/255.0f) * ((this->m_c1.fA * this->m_alpha) - (this->m_c0.fA * this->m_alpha));
-	float delta_cr = (1.0f/255.0f) * ((this->m_c1.fR) - (this->m_c0.fR));
-	float delta_cg = (1.0f/255.0f) * ((this->m_c1.fG) - (this->m_c0.fG));
-	float delta_cb = (1.0f/255.0f) * ((this->m_c1.fB) - (this->m_c0.fB));
-
-	// each color component starts off at c0 values
-	float a = (this->m_c0.fA * this->m_alpha);
-	float r = (this->m_c0.fR);
-	float g = (this->m_c0.fG);
-	float b = (this->m_c0.fB);
-
-	// fill up the table
-	for (int i = 0; i < 256; ++i)
+	// generate our lookup table, unless the one we have is for this alpha already
+	if (this->m_table_alpha != this->m_alpha)
 	{
-		this->m_lookup_table[i] = convert_color_to_pixel(GColor::MakeARGB(a, r, g, b));
-		a += delta_ca;
-		r += delta_cr;
-		g += delta_cg;
-		b += delta_cb;
+		build_gradient_table(this->m_colors.data(), this->m_positions.data(), (int)this->m_colors.size(),
+			this->m_alpha, this->m_lookup_table);
+		this->m_table_alpha = this->m_alpha;
 	}
 
 	// success
 	return true;
 }
 
-void GShaderLinearGradientSteffey::shadeRow(int x, int y, int count, GPixel row[])
-{
-	switch (this->m_tilemode)
-	{
-		case GShader::kClamp: { this->shadeRow_clamp(x, y, count, row); } break;
-		case GShader::kRepeat: { this->shadeRow_repeat(x, y, count, row); } break;
-		case GShader::kMirror: { this->shadeRow_mirror(x, y, count, row); } break;
-	}
-}
-
-void GShaderLinearGradientSteffey::shadeRow_clamp(int x, int y, int count, GPixel row[])
+// the position along the gradient only depends on x in the gradient's space, and it comes
+// 4 pixels at a time, each one 0, 1, 2 or 3 steps past the first of the 4
+template <GShader::TileMode tilemode>
+static void linear_row(const GPixel lookup_table[GRADIENT_TABLE_SIZE], const GMatrix& inverse, int x, int y, int count, GPixel row[])
 {
-	// calculate the first source point
-	GPoint src_point = this->m_combined_ctm.mapXY(x + 0.5f, y + 0.5f);
-
-	// loop through the count number of pixels
-	for (int i = 0; i < count; ++i)
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+	const float dx = inverse[GMatrix::SX];
+	const float steps[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+
+	int i = 0;
+	#ifdef GRADIENT_SSE2
+		const __m128 step_x = _mm_mul_ps(_mm_loadu_ps(steps), _mm_set1_ps(dx));
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 t = _mm_add_ps(_mm_set1_ps(src_point.fX), step_x);
+			gradient_lookup_sse2(lookup_table, tile_gradient_sse2<tilemode>(t), row + i);
+			src_point.fX += dx * 4.0f;
+		}
+	#endif
+	for (; i < count; i += 4)
 	{
-		// determine the xvalue based on the tilemode
-		float x_value = std::max(0.0f, std::min(src_point.fX, 1.0f));
-
-		// look up the pixel and store it in the row
-		row[i] = this->m_lookup_table[(int)(x_value * 255 + 0.5f)];
-
-		// increment the source point based on values in the matrix
-		src_point.fX += this->m_combined_ctm[GMatrix::SX];
+		int n = std::min(4, count - i);
+		for (int k = 0; k < n; ++k)
+		{
+			float t = src_point.fX + steps[k] * dx;
+			row[i + k] = lookup_table[gradient_index(tile_gradient<tilemode>(t))];
+		}
+		src_point.fX += dx * 4.0f;
 	}
 }
 
-void GShaderLinearGradientSteffey::shadeRow_repeat(int x, int y, int count, GPixel row[])
+void GShaderLinearGradientSteffey::shadeRow(int x, int y, int count, GPixel row[])
 {
-	// calculate the first source point
-	GPoint src_point = this->m_combined_ctm.mapXY(x + 0.5f, y + 0.5f);
-
-	// loop through the count number of pixels
-	for (int i = 0; i < count; ++i)
+	switch (this->m_tilemode)
 	{
-		// determine the xvalue based on the tilemode
-		float x_value = src_point.fX - std::floor(src_point.fX);
-
-		// look up the pixel and store it in the row
-		row[i] = this->m_lookup_table[(int)(x_value * 255 + 0.5f)];
-
-		// increment the source point based on values in the matrix
-		src_point.fX += this->m_combined_ctm[GMatrix::SX];
+		case GShader::kClamp: { linear_row<GShader::kClamp>(this->m_lookup_table, this->m_combined_ctm, x, y, count, row); } break;
+		case GShader::kRepeat: { linear_row<GShader::kRepeat>(this->m_lookup_table, this->m_combined_ctm, x, y, count, row); } break;
+		case GShader::kMirror: { linear_row<GShader::kMirror>(this->m_lookup_table, this->m_combined_ctm, x, y, count, row); } break;
 	}
 }
-
-void GShaderLinearGradientSteffey::shadeRow_mirror(int x, int y, int count, GPixel row[])
-{
-	// calculate the first source point
-	GPoint src_point = this->m_combined_ctm.mapXY(x + 0.5f, y + 0.5f);
-
-	// loop through the count number of pixels
-	for (int i = 0; i < count; ++i)
-	{
-		float x_value = src_point.fX * 0.5f;
-		x_value -= std::floor(x_value);
-		x_value *= 2;
-		x_value = 1.0f - std::abs(1.0f - x_value);
-
-		// look up the pixel and store it in the row
-		row[i] = this->m_lookup_table[(int)(x_value * 255 + 0.5f)];
-
-		// increment the source point based on values in the matrix
-		src_point.fX += this->m_combined_ctm[GMatrix::SX];
-	}
-}
\ No newline at end of file
@@ -7,11 +7,15 @@
 #include "include/GBitmap.h"
 #include "include/GMatrix.h"
 #include "include/GPixel.h"
+#include "include/GColor.h"
+#include "Gradient.hpp"
+#include <vector>
 
 class GShaderLinearGradientSteffey : public GShader
 {
 public:
-    GShaderLinearGradientSteffey(const GPoint& p0, const GPoint& p1, const GColor& c0, const GColor& c1, GShader::TileMode tilemode);
+    GShaderLinearGradientSteffey(const GPoint& p0, const GPoint& p1, const GColor colors[], const float positions[], int count,
+                                 GShader::TileMode tilemode);
     ~GShaderLinearGradientSteffey();
 
     /**
@@ -33,18 +37,20 @@ protected:
 
 
 private:
-    void shadeRow_clamp(int x, int y, int count, GPixel row[]);
-    void shadeRow_repeat(int x, int y, int count, GPixel row[]);
-    void shadeRow_mirror(int x, int y, int count, GPixel row[]);
+    // the stops, with the positions pinned to go from 0 to 1
+    std::vector<GColor> m_colors;
+    std::vector<float> m_positions;
 
-    GColor m_c0;
-    GColor m_c1;
     GMatrix m_local_ctm;
     GMatrix m_global_ctm;
     GMatrix m_combined_ctm;
     float m_alpha;
     GShader::TileMode m_tilemode;
-    GPixel m_lookup_table[256];
+
+    // the premultiplied colors along the gradient, and the alpha they were made with
+    // (the table only depends on the alpha, so a new ctm keeps it)
+    GPixel m_lookup_table[GRADIENT_TABLE_SIZE];
+    float m_table_alpha;
 };
 
 #endif
@@ -1,12 +1,21 @@
 // Copyright Daniel J. Steffey -- 2016
 
 #include "GShaderRadial.hpp"
-#include "utils.hpp"
+#include <algorithm>
 #include <cmath>
-#include <iostream>
 
 
-GShaderRadial::GShaderRadial(float cx, float cy, float radius, const GColor colors[], int count)
+GShader* GShader::RadialGradient(const GPoint& center, float radius, const GColor colors[], int count, GShader::TileMode tilemode)
+{
+	// need at least one color and a circle to spread them over
+	if (count < 1 || colors == nullptr || !(radius > 0.0f))
+	{
+		return nullptr;
+	}
+	return new GShaderRadial(center.fX, center.fY, radius, colors, count, tilemode);
+}
+
+GShaderRadial::GShaderRadial(float cx, float cy, float radius, const GColor colors[], int count, GShader::TileMode tilemode)
 {
 
 	// save the colors
@@ -18,6 +27,10 @@ GShaderRadial::GShaderRadial(float cx, float cy, float radius, const GColor colo
 		this->m_colors[i] = colors[i];
 	}
 
+	// spaced evenly from the center out
+	this->m_positions = new float[this->m_count];
+	pin_gradient_positions(nullptr, this->m_count, this->m_positions);
+
 
 	// calculate the local matrix
 	this->m_local_ctm.set6(radius, 0, cx, 0, radius, cy);
@@ -34,11 +47,18 @@ GShaderRadial::GShaderRadial(float cx, float cy, float radius, const GColor colo
 
 	// set our alpha
 	this->m_alpha = 1.0f;
+
+	// save our tilemode
+	this->m_tilemode = tilemode;
+
+	// no table yet
+	this->m_table_alpha = -1.0f;
 }
 
 GShaderRadial::~GShaderRadial()
 {
 	delete [] this->m_colors;
+	delete [] this->m_positions;
 }
 
 bool GShaderRadial::setContext(const GMatrix& ctm, float alpha)
@@ -56,42 +76,63 @@ bool GShaderRadial::setContext(const GMatrix& ctm, float alpha)
 		return false;
 	}
 
+	// generate our lookup table, unless the one we have is for this alpha already
+	if (this->m_table_alpha != this->m_alpha)
+	{
+		build_gradient_table(this->m_colors, this->m_positions, this->m_count, this->m_alpha, this->m_lookup_table);
+		this->m_table_alpha = this->m_alpha;
+	}
+
 	// success
 	return true;
 }
 
-void GShaderRadial::shadeRow(int x, int y, int count, GPixel row[])
+// the distances come 4 pixels at a time, each one offset from the first of the 4 by
+// 0, 1, 2 or 3 steps, so the sse2 and plain versions do the exact same float math
+template <GShader::TileMode tilemode>
+static void radial_row(const GPixel lookup_table[GRADIENT_TABLE_SIZE], const GMatrix& inverse, int x, int y, int count, GPixel row[])
 {
-
-	GPoint src_point = this->m_combined_ctm.mapXY(x + 0.5f, y + 0.5f);
-
-	for (int i = 0; i < count; ++i)
-	{
-		// compute distance at x, y
-		float distance = std::sqrt((src_point.fX * src_point.fX) + (src_point.fY * src_point.fY));
-
-		// now distance is in value from 0.0f -> 1.0f (or beyond just clamp)
-		if (distance >= 1.0f)
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+	const float dx = inverse[GMatrix::SX];
+	const float dy = inverse[GMatrix::KY];
+	const float steps[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+
+	int i = 0;
+	#ifdef GRADIENT_SSE2
+		const __m128 step_x = _mm_mul_ps(_mm_loadu_ps(steps), _mm_set1_ps(dx));
+		const __m128 step_y = _mm_mul_ps(_mm_loadu_ps(steps), _mm_set1_ps(dy));
+		for (; i + 4 <= count; i += 4)
 		{
-			// autoamatically last color
-			row[i] = convert_color_to_pixel(this->m_colors[this->m_count-1]);
+			__m128 px = _mm_add_ps(_mm_set1_ps(src_point.fX), step_x);
+			__m128 py = _mm_add_ps(_mm_set1_ps(src_point.fY), step_y);
+			__m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)));
+			gradient_lookup_sse2(lookup_table, tile_gradient_sse2<tilemode>(distance), row + i);
+
+			src_point.fX += dx * 4.0f;
+			src_point.fY += dy * 4.0f;
 		}
-		else
+	#endif
+	for (; i < count; i += 4)
+	{
+		int n = std::min(4, count - i);
+		for (int k = 0; k < n; ++k)
 		{
-			float temp = distance * (this->m_count - 1);
-			int c0 = std::floor(temp);
-			int c1 = std::ceil(temp);
-			temp -= c0;
-
-			// now interpolate between c0 and c1 linearly by temp percentage
-			float a = ((1.0f - temp) * this->m_colors[c0].fA) + (temp * this->m_colors[c1].fA) * this->m_alpha;
-			float r = ((1.0f - temp) * this->m_colors[c0].fR) + (temp * this->m_colors[c1].fR);
-			float g = ((1.0f - temp) * this->m_colors[c0].fG) + (temp * this->m_colors[c1].fG);
-			float b = ((1.0f - temp) * this->m_colors[c0].fB) + (temp * this->m_colors[c1].fB);
-			row[i] = convert_color_to_pixel(GColor::MakeARGB(a, r, g, b));
+			float px = src_point.fX + steps[k] * dx;
+			float py = src_point.fY + steps[k] * dy;
+			float distance = std::sqrt((px * px) + (py * py));
+			row[i + k] = lookup_table[gradient_index(tile_gradient<tilemode>(distance))];
 		}
+		src_point.fX += dx * 4.0f;
+		src_point.fY += dy * 4.0f;
+	}
+}
 
-		src_point.fX += this->m_combined_ctm[0];
-		src_point.fY += this->m_combined_ctm[3];
+void GShaderRadial::shadeRow(int x, int y, int count, GPixel row[])
+{
+	switch (this->m_tilemode)
+	{
+		case GShader::kClamp: { radial_row<GShader::kClamp>(this->m_lookup_table, this->m_combined_ctm, x, y, count, row); } break;
+		case GShader::kRepeat: { radial_row<GShader::kRepeat>(this->m_lookup_table, this->m_combined_ctm, x, y, count, row); } break;
+		case GShader::kMirror: { radial_row<GShader::kMirror>(this->m_lookup_table, this->m_combined_ctm, x, y, count, row); } break;
 	}
-}
\ No newline at end of file
+}
@@ -8,11 +8,13 @@
 #include "include/GMatrix.h"
 #include "include/GPixel.h"
 #include "include/GColor.h"
+#include "Gradient.hpp"
 
 class GShaderRadial : public GShader
 {
 public:
-    GShaderRadial(float cx, float cy, float radius, const GColor colors[], int count);
+    GShaderRadial(float cx, float cy, float radius, const GColor colors[], int count,
+                  GShader::TileMode tilemode = GShader::kClamp);
     ~GShaderRadial();
 
     /**
@@ -34,17 +36,20 @@ protected:
 
 
 private:
-    void shadeRow_clamp(int x, int y, int count, GPixel row[]);
-    void shadeRow_repeat(int x, int y, int count, GPixel row[]);
-    void shadeRow_mirror(int x, int y, int count, GPixel row[]);
-
     GColor* m_colors;
+    float* m_positions;
     int m_count;
 
     GMatrix m_local_ctm;
     GMatrix m_global_ctm;
     GMatrix m_combined_ctm;
     float m_alpha;
+    GShader::TileMode m_tilemode;
+
+    // the premultiplied colors (with the alpha) from the center out to the radius, and the
+    // alpha they were made with
+    GPixel m_lookup_table[GRADIENT_TABLE_SIZE];
+    float m_table_alpha;
 };
 
 #endif
@@ -0,0 +1,153 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "GShaderSweep.hpp"
+#include <cmath>
+
+
+GShader* GShader::SweepGradient(const GPoint& center, const GColor colors[], const float positions[], int count)
+{
+	// need at least one color
+	if (count < 1 || colors == nullptr)
+	{
+		return nullptr;
+	}
+	return new GShaderSweep(center.fX, center.fY, colors, positions, count);
+}
+
+GShaderSweep::GShaderSweep(float cx, float cy, const GColor colors[], const float positions[], int count)
+{
+	// save the stops
+	this->m_colors.assign(colors, colors + count);
+	this->m_positions.resize(count);
+	pin_gradient_positions(positions, count, this->m_positions.data());
+
+	// the local matrix just moves the center
+	this->m_local_ctm.setTranslate(cx, cy);
+	this->m_global_ctm.setIdentity();
+	this->m_combined_ctm.setConcat(this->m_global_ctm, this->m_local_ctm);
+	this->m_combined_ctm.invert(&(this->m_combined_ctm));
+
+	this->m_alpha = 1.0f;
+	this->m_table_alpha = -1.0f;
+}
+
+GShaderSweep::~GShaderSweep()
+{
+	// nothing to destroy
+}
+
+bool GShaderSweep::setContext(const GMatrix& ctm, float alpha)
+{
+	// save the passed in global ctm and alpha
+	this->m_global_ctm = ctm;
+	this->m_alpha = alpha;
+
+	// recompute our combined and invert it
+	this->m_combined_ctm.setConcat(this->m_global_ctm, this->m_local_ctm);
+	if (this->m_combined_ctm.invert(&(this->m_combined_ctm)) == false)
+	{
+		return false;
+	}
+
+	// generate our lookup table, unless the one we have is for this alpha already
+	if (this->m_table_alpha != this->m_alpha)
+	{
+		build_gradient_table(this->m_colors.data(), this->m_positions.data(), (int)this->m_colors.size(),
+			this->m_alpha, this->m_lookup_table);
+		this->m_table_alpha = this->m_alpha;
+	}
+
+	// success
+	return true;
+}
+
+// the angle of (x, y) as a fraction of a turn in [0, 1), good to about 1e-5 radians
+// atan of the smaller over the bigger side with a polynomial, then unfolded into the octant
+// both versions do the same float math, so they come out the same
+static inline float sweep_turn(float x, float y)
+{
+	float ax = std::abs(x);
+	float ay = std::abs(y);
+	float big = std::max(ax, ay);
+	float small = std::min(ax, ay);
+	float a = (big > 0.0f ? small / big : 0.0f);
+	float s = a * a;
+	float angle = ((((-0.0464964749f * s) + 0.15931422f) * s - 0.327622764f) * s * a) + a;
+
+	// to a turn, then into the right octant
+	angle *= 0.159154943f;
+	angle = (ay > ax ? 0.25f - angle : angle);
+	angle = (x < 0.0f ? 0.5f - angle : angle);
+	angle = (y < 0.0f ? 1.0f - angle : angle);
+
+	// 1 only comes back for a tiny negative y, which is really 0
+	return (angle < 1.0f ? angle : 0.0f);
+}
+
+#ifdef GRADIENT_SSE2
+
+static inline __m128 select_sse2(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 sweep_turn_sse2(__m128 x, __m128 y)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	__m128 ax = _mm_andnot_ps(sign, x);
+	__m128 ay = _mm_andnot_ps(sign, y);
+	__m128 big = _mm_max_ps(ax, ay);
+	__m128 small = _mm_min_ps(ax, ay);
+
+	// the lanes with a zero big get 0 (and a 0 / 1 instead of a 0 / 0)
+	__m128 nonzero = _mm_cmpgt_ps(big, zero);
+	__m128 a = _mm_and_ps(nonzero, _mm_div_ps(small, select_sse2(nonzero, big, _mm_set1_ps(1.0f))));
+	__m128 s = _mm_mul_ps(a, a);
+	__m128 angle = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.0464964749f), s),
+		_mm_set1_ps(0.15931422f)), s), _mm_set1_ps(0.327622764f)), s), a), a);
+
+	angle = _mm_mul_ps(angle, _mm_set1_ps(0.159154943f));
+	angle = select_sse2(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(0.25f), angle), angle);
+	angle = select_sse2(_mm_cmplt_ps(x, zero), _mm_sub_ps(_mm_set1_ps(0.5f), angle), angle);
+	angle = select_sse2(_mm_cmplt_ps(y, zero), _mm_sub_ps(_mm_set1_ps(1.0f), angle), angle);
+	return _mm_and_ps(_mm_cmplt_ps(angle, _mm_set1_ps(1.0f)), angle);
+}
+
+#endif
+
+void GShaderSweep::shadeRow(int x, int y, int count, GPixel row[])
+{
+	// 4 pixels at a time, each one 0, 1, 2 or 3 steps past the first of the 4
+	const GMatrix& inverse = this->m_combined_ctm;
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+	const float dx = inverse[GMatrix::SX];
+	const float dy = inverse[GMatrix::KY];
+	const float steps[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+
+	int i = 0;
+	#ifdef GRADIENT_SSE2
+		const __m128 step_x = _mm_mul_ps(_mm_loadu_ps(steps), _mm_set1_ps(dx));
+		const __m128 step_y = _mm_mul_ps(_mm_loadu_ps(steps), _mm_set1_ps(dy));
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps(src_point.fX), step_x);
+			__m128 py = _mm_add_ps(_mm_set1_ps(src_point.fY), step_y);
+			gradient_lookup_sse2(this->m_lookup_table, sweep_turn_sse2(px, py), row + i);
+			src_point.fX += dx * 4.0f;
+			src_point.fY += dy * 4.0f;
+		}
+	#endif
+	for (; i < count; i += 4)
+	{
+		int n = std::min(4, count - i);
+		for (int k = 0; k < n; ++k)
+		{
+			float px = src_point.fX + steps[k] * dx;
+			float py = src_point.fY + steps[k] * dy;
+			row[i + k] = this->m_lookup_table[gradient_index(sweep_turn(px, py))];
+		}
+		src_point.fX += dx * 4.0f;
+		src_point.fY += dy * 4.0f;
+	}
+}
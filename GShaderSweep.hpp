@@ -0,0 +1,53 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef GShaderSweep_hpp
+#define GShaderSweep_hpp
+
+#include "include/GShader.h"
+#include "include/GMatrix.h"
+#include "include/GPixel.h"
+#include "include/GColor.h"
+#include "Gradient.hpp"
+#include <vector>
+
+// colors around a center, starting at the +x axis and going towards +y (clockwise on screen)
+// for a full turn, so 0 and 1 meet back at the +x axis
+class GShaderSweep : public GShader
+{
+public:
+    GShaderSweep(float cx, float cy, const GColor colors[], const float positions[], int count);
+    ~GShaderSweep();
+
+    /**
+     *  Called with the drawing's current matrix (ctm) and paint's alpha.
+     *
+     *  Subsequent calls to shadeRow() must respect the CTM, and have its colors
+     *  modulated by alpha.
+     */
+    bool setContext(const GMatrix& ctm, float alpha) override;
+
+    /**
+     *  Given a row of pixels in device space [x, y] ... [x + count - 1, y], return the
+     *  corresponding src pixels in row[0...count - 1]. The caller must ensure that row[]
+     *  can hold at least [count] entries.
+     */
+    void shadeRow(int x, int y, int count, GPixel row[]) override;
+
+protected:
+
+
+private:
+    std::vector<GColor> m_colors;
+    std::vector<float> m_positions;
+
+    GMatrix m_local_ctm;
+    GMatrix m_global_ctm;
+    GMatrix m_combined_ctm;
+    float m_alpha;
+
+    // the premultiplied colors (with the alpha) around the turn, and the alpha they were made with
+    GPixel m_lookup_table[GRADIENT_TABLE_SIZE];
+    float m_table_alpha;
+};
+
+#endif
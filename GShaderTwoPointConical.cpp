@@ -0,0 +1,233 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "GShaderTwoPointConical.hpp"
+#include <cmath>
+
+
+GShader* GShader::TwoPointConicalGradient(const GPoint& p0, float r0, const GPoint& p1, float r1,
+	const GColor colors[], const float positions[], int count, GShader::TileMode tilemode)
+{
+	// need at least one color, and radii that are not negative
+	if (count < 1 || colors == nullptr || !(r0 >= 0.0f) || !(r1 >= 0.0f))
+	{
+		return nullptr;
+	}
+
+	// the same circle twice has no positions in between
+	if (p0.fX == p1.fX && p0.fY == p1.fY && r0 == r1)
+	{
+		return nullptr;
+	}
+	return new GShaderTwoPointConical(p0, r0, p1, r1, colors, positions, count, tilemode);
+}
+
+GShaderTwoPointConical::GShaderTwoPointConical(const GPoint& p0, float r0, const GPoint& p1, float r1, const GColor colors[],
+	const float positions[], int count, GShader::TileMode tilemode)
+{
+	// save the stops
+	this->m_colors.assign(colors, colors + count);
+	this->m_positions.resize(count);
+	pin_gradient_positions(positions, count, this->m_positions.data());
+
+	// the parts of the quadratic that are the same for every pixel
+	this->m_center.set(p1.fX - p0.fX, p1.fY - p0.fY);
+	this->m_r0 = r0;
+	this->m_dr = r1 - r0;
+	this->m_a = (this->m_center.fX * this->m_center.fX) + (this->m_center.fY * this->m_center.fY) - (this->m_dr * this->m_dr);
+
+	// the local matrix moves the first center to the origin
+	this->m_local_ctm.setTranslate(p0.fX, p0.fY);
+	this->m_global_ctm.setIdentity();
+	this->m_combined_ctm.setConcat(this->m_global_ctm, this->m_local_ctm);
+	this->m_combined_ctm.invert(&(this->m_combined_ctm));
+
+	this->m_alpha = 1.0f;
+	this->m_tilemode = tilemode;
+	this->m_table_alpha = -1.0f;
+}
+
+GShaderTwoPointConical::~GShaderTwoPointConical()
+{
+	// nothing to destroy
+}
+
+bool GShaderTwoPointConical::setContext(const GMatrix& ctm, float alpha)
+{
+	// save the passed in global ctm and alpha
+	this->m_global_ctm = ctm;
+	this->m_alpha = alpha;
+
+	// recompute our combined and invert it
+	this->m_combined_ctm.setConcat(this->m_global_ctm, this->m_local_ctm);
+	if (this->m_combined_ctm.invert(&(this->m_combined_ctm)) == false)
+	{
+		return false;
+	}
+
+	// generate our lookup table, unless the one we have is for this alpha already
+	if (this->m_table_alpha != this->m_alpha)
+	{
+		build_gradient_table(this->m_colors.data(), this->m_positions.data(), (int)this->m_colors.size(),
+			this->m_alpha, this->m_lookup_table);
+		this->m_table_alpha = this->m_alpha;
+	}
+
+	// success
+	return true;
+}
+
+// the constants for solving the cone's quadratic, 4 pixels at a time
+struct ConicalSetup
+{
+	float cx;
+	float cy;
+	float r0;
+	float dr;
+	float a;
+	float inverse_a;
+	bool linear;
+};
+
+// the position for the point (x, y), or false if no circle goes through it
+// when a is (close to) 0 the quadratic is really linear, otherwise the bigger root is used
+// as long as its radius is not negative, then the smaller one
+static inline bool conical_position(const ConicalSetup& setup, float x, float y, float* t)
+{
+	float b = (x * setup.cx) + (y * setup.cy) + (setup.r0 * setup.dr);
+	float c = (x * x) + (y * y) - (setup.r0 * setup.r0);
+	if (setup.linear)
+	{
+		*t = (c * 0.5f) / b;
+		return (b != 0.0f && setup.r0 + (*t * setup.dr) >= 0.0f);
+	}
+
+	float discriminant = (b * b) - (setup.a * c);
+	if (!(discriminant >= 0.0f))
+	{
+		return false;
+	}
+	float root = std::sqrt(discriminant);
+	float t0 = (b + root) * setup.inverse_a;
+	float t1 = (b - root) * setup.inverse_a;
+	float big = std::max(t0, t1);
+	float small = std::min(t0, t1);
+	if (setup.r0 + (big * setup.dr) >= 0.0f)
+	{
+		*t = big;
+		return true;
+	}
+	*t = small;
+	return (setup.r0 + (small * setup.dr) >= 0.0f);
+}
+
+#ifdef GRADIENT_SSE2
+
+static inline __m128 select_sse2(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// the same math as conical_position, the mask comes back all ones where there is a circle
+static inline __m128 conical_position_sse2(const ConicalSetup& setup, __m128 x, __m128 y, __m128* t)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 r0 = _mm_set1_ps(setup.r0);
+	const __m128 dr = _mm_set1_ps(setup.dr);
+	__m128 b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(setup.cx)), _mm_mul_ps(y, _mm_set1_ps(setup.cy))),
+		_mm_set1_ps(setup.r0 * setup.dr));
+	__m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_set1_ps(setup.r0 * setup.r0));
+	if (setup.linear)
+	{
+		*t = _mm_div_ps(_mm_mul_ps(c, _mm_set1_ps(0.5f)), b);
+		__m128 radius = _mm_add_ps(r0, _mm_mul_ps(*t, dr));
+		return _mm_and_ps(_mm_cmpneq_ps(b, zero), _mm_cmpge_ps(radius, zero));
+	}
+
+	__m128 discriminant = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(_mm_set1_ps(setup.a), c));
+	__m128 valid = _mm_cmpge_ps(discriminant, zero);
+	__m128 root = _mm_sqrt_ps(_mm_and_ps(valid, discriminant));
+	__m128 inverse_a = _mm_set1_ps(setup.inverse_a);
+	__m128 t0 = _mm_mul_ps(_mm_add_ps(b, root), inverse_a);
+	__m128 t1 = _mm_mul_ps(_mm_sub_ps(b, root), inverse_a);
+	__m128 big = _mm_max_ps(t0, t1);
+	__m128 small = _mm_min_ps(t0, t1);
+	__m128 big_ok = _mm_cmpge_ps(_mm_add_ps(r0, _mm_mul_ps(big, dr)), zero);
+	__m128 small_ok = _mm_cmpge_ps(_mm_add_ps(r0, _mm_mul_ps(small, dr)), zero);
+	*t = select_sse2(big_ok, big, small);
+	return _mm_and_ps(valid, _mm_or_ps(big_ok, small_ok));
+}
+
+#endif
+
+template <GShader::TileMode tilemode>
+static void conical_row(const GPixel lookup_table[GRADIENT_TABLE_SIZE], const ConicalSetup& setup, const GMatrix& inverse,
+	int x, int y, int count, GPixel row[])
+{
+	// 4 pixels at a time, each one 0, 1, 2 or 3 steps past the first of the 4
+	GPoint src_point = inverse.mapXY(x + 0.5f, y + 0.5f);
+	const float dx = inverse[GMatrix::SX];
+	const float dy = inverse[GMatrix::KY];
+	const float steps[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+
+	int i = 0;
+	#ifdef GRADIENT_SSE2
+		const __m128 step_x = _mm_mul_ps(_mm_loadu_ps(steps), _mm_set1_ps(dx));
+		const __m128 step_y = _mm_mul_ps(_mm_loadu_ps(steps), _mm_set1_ps(dy));
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 px = _mm_add_ps(_mm_set1_ps(src_point.fX), step_x);
+			__m128 py = _mm_add_ps(_mm_set1_ps(src_point.fY), step_y);
+			__m128 t;
+			__m128 mask = conical_position_sse2(setup, px, py, &t);
+
+			// the pixels without a circle look up 0 and then get cleared
+			gradient_lookup_sse2(lookup_table, _mm_and_ps(mask, tile_gradient_sse2<tilemode>(t)), row + i);
+			__m128i keep = _mm_castps_si128(mask);
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(row + i));
+			_mm_storeu_si128((__m128i*)(row + i), _mm_and_si128(keep, pixels));
+
+			src_point.fX += dx * 4.0f;
+			src_point.fY += dy * 4.0f;
+		}
+	#endif
+	for (; i < count; i += 4)
+	{
+		int n = std::min(4, count - i);
+		for (int k = 0; k < n; ++k)
+		{
+			float px = src_point.fX + steps[k] * dx;
+			float py = src_point.fY + steps[k] * dy;
+			float t = 0.0f;
+			if (conical_position(setup, px, py, &t))
+			{
+				row[i + k] = lookup_table[gradient_index(tile_gradient<tilemode>(t))];
+			}
+			else
+			{
+				row[i + k] = 0;
+			}
+		}
+		src_point.fX += dx * 4.0f;
+		src_point.fY += dy * 4.0f;
+	}
+}
+
+void GShaderTwoPointConical::shadeRow(int x, int y, int count, GPixel row[])
+{
+	// a tiny a would blow up 1 / a, that is the linear case instead
+	ConicalSetup setup;
+	setup.cx = this->m_center.fX;
+	setup.cy = this->m_center.fY;
+	setup.r0 = this->m_r0;
+	setup.dr = this->m_dr;
+	setup.a = this->m_a;
+	setup.linear = std::abs(this->m_a) < 1e-6f;
+	setup.inverse_a = (setup.linear ? 0.0f : 1.0f / this->m_a);
+
+	switch (this->m_tilemode)
+	{
+		case GShader::kClamp: { conical_row<GShader::kClamp>(this->m_lookup_table, setup, this->m_combined_ctm, x, y, count, row); } break;
+		case GShader::kRepeat: { conical_row<GShader::kRepeat>(this->m_lookup_table, setup, this->m_combined_ctm, x, y, count, row); } break;
+		case GShader::kMirror: { conical_row<GShader::kMirror>(this->m_lookup_table, setup, this->m_combined_ctm, x, y, count, row); } break;
+	}
+}
@@ -0,0 +1,65 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef GShaderTwoPointConical_hpp
+#define GShaderTwoPointConical_hpp
+
+#include "include/GShader.h"
+#include "include/GMatrix.h"
+#include "include/GPixel.h"
+#include "include/GColor.h"
+#include "Gradient.hpp"
+#include <vector>
+
+// the colors along a cone of circles, from the circle at p0 with radius r0 (position 0) to the
+// one at p1 with radius r1 (position 1)
+// each pixel takes the biggest position whose circle goes through it (and whose radius is not
+// negative), pixels no circle goes through are left transparent
+class GShaderTwoPointConical : public GShader
+{
+public:
+    GShaderTwoPointConical(const GPoint& p0, float r0, const GPoint& p1, float r1, const GColor colors[],
+                           const float positions[], int count, GShader::TileMode tilemode);
+    ~GShaderTwoPointConical();
+
+    /**
+     *  Called with the drawing's current matrix (ctm) and paint's alpha.
+     *
+     *  Subsequent calls to shadeRow() must respect the CTM, and have its colors
+     *  modulated by alpha.
+     */
+    bool setContext(const GMatrix& ctm, float alpha) override;
+
+    /**
+     *  Given a row of pixels in device space [x, y] ... [x + count - 1, y], return the
+     *  corresponding src pixels in row[0...count - 1]. The caller must ensure that row[]
+     *  can hold at least [count] entries.
+     */
+    void shadeRow(int x, int y, int count, GPixel row[]) override;
+
+protected:
+
+
+private:
+    std::vector<GColor> m_colors;
+    std::vector<float> m_positions;
+
+    // the cone, moved so the first circle is at the origin
+    // a point p (from the first center) is on the circle at t where
+    // m_a * t^2 - 2 * (p . m_center + m_r0 * m_dr) * t + (p . p - m_r0^2) = 0
+    GPoint m_center;
+    float m_r0;
+    float m_dr;
+    float m_a;
+
+    GMatrix m_local_ctm;
+    GMatrix m_global_ctm;
+    GMatrix m_combined_ctm;
+    float m_alpha;
+    GShader::TileMode m_tilemode;
+
+    // the premultiplied colors (with the alpha) along the cone, and the alpha they were made with
+    GPixel m_lookup_table[GRADIENT_TABLE_SIZE];
+    float m_table_alpha;
+};
+
+#endif
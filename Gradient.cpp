@@ -0,0 +1,46 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "Gradient.hpp"
+#include "utils.hpp"
+
+void pin_gradient_positions(const float positions[], int count, float positions_out[])
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (positions == nullptr)
+		{
+			positions_out[i] = (count > 1 ? i / (float)(count - 1) : 0.0f);
+			continue;
+		}
+		float position = std::max(0.0f, std::min(positions[i], 1.0f));
+		positions_out[i] = (i == 0 ? position : std::max(position, positions_out[i - 1]));
+	}
+}
+
+void build_gradient_table(const GColor colors[], const float positions[], int count, float alpha,
+	GPixel table[GRADIENT_TABLE_SIZE])
+{
+	// walk the stops along with the entries, k is the stop at or before t
+	int k = 0;
+	for (int i = 0; i < GRADIENT_TABLE_SIZE; ++i)
+	{
+		float t = i / (float)(GRADIENT_TABLE_SIZE - 1);
+		while (k < count - 2 && positions[k + 1] <= t)
+		{
+			k++;
+		}
+		float p0 = positions[k];
+		float p1 = positions[std::min(k + 1, count - 1)];
+
+		// how far t is between stops k and k + 1 (stops at the same position make a hard edge)
+		const GColor& c0 = colors[k];
+		const GColor& c1 = colors[std::min(k + 1, count - 1)];
+		float f = (p1 > p0 ? std::max(0.0f, std::min((t - p0) / (p1 - p0), 1.0f)) : 1.0f);
+
+		float a = ((1.0f - f) * c0.fA + f * c1.fA) * alpha;
+		float r = (1.0f - f) * c0.fR + f * c1.fR;
+		float g = (1.0f - f) * c0.fG + f * c1.fG;
+		float b = (1.0f - f) * c0.fB + f * c1.fB;
+		table[i] = convert_color_to_pixel(GColor::MakeARGB(a, r, g, b));
+	}
+}
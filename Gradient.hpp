@@ -0,0 +1,104 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef Gradient_hpp
+#define Gradient_hpp
+
+#include "include/GColor.h"
+#include "include/GPixel.h"
+#include "include/GShader.h"
+#include <algorithm>
+
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+	#define GRADIENT_SSE2
+#endif
+
+// the pieces the gradient shaders share: a table of the colors along the gradient, and
+// folding a position along it into the table for each tile mode
+// the sse2 and plain versions of the folding do the same float math, so they come out the same
+
+enum
+{
+	// fine enough that a gradient spread over a few hundred pixels never has an entry cover
+	// more than one of them, so neighbouring pixels are at most a step of the colors apart
+	GRADIENT_TABLE_SIZE = 1024,
+};
+
+// fill table with the premultiplied colors from position 0 to 1, entry i at i / (GRADIENT_TABLE_SIZE - 1)
+// colors[k] sits at positions[k] (pinned as below), before the first position and after the last
+// the table keeps the end colors, and everything gets scaled by alpha
+void build_gradient_table(const GColor colors[], const float positions[], int count, float alpha,
+	GPixel table[GRADIENT_TABLE_SIZE]);
+
+// copy count positions into positions_out pinned to [0, 1] and never going down (or evenly
+// spaced from 0 to 1 if positions is null)
+void pin_gradient_positions(const float positions[], int count, float positions_out[]);
+
+// a position along the gradient folded into [0, 1] for the tile mode
+// far enough out a float has no fraction left, so that is as far out as repeat and mirror go
+template <GShader::TileMode tilemode> static inline float tile_gradient(float t)
+{
+	if (tilemode == GShader::kClamp)
+	{
+		return std::max(0.0f, std::min(t, 1.0f));
+	}
+	t = std::max(-8388608.0f, std::min(t, 8388608.0f));
+	if (tilemode == GShader::kRepeat)
+	{
+		float whole = (float)(int)t;
+		whole -= (whole > t ? 1.0f : 0.0f);
+		return t - whole;
+	}
+	float half = t * 0.5f;
+	float whole = (float)(int)half;
+	whole -= (whole > half ? 1.0f : 0.0f);
+	half = (half - whole) * 2.0f;
+	return 1.0f - std::abs(1.0f - half);
+}
+
+// the table entry for a position already folded into [0, 1]
+static inline int gradient_index(float t)
+{
+	return (int)(t * (GRADIENT_TABLE_SIZE - 1) + 0.5f);
+}
+
+#ifdef GRADIENT_SSE2
+
+template <GShader::TileMode tilemode> static inline __m128 tile_gradient_sse2(__m128 t)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	if (tilemode == GShader::kClamp)
+	{
+		return _mm_max_ps(zero, _mm_min_ps(t, one));
+	}
+	t = _mm_max_ps(_mm_set1_ps(-8388608.0f), _mm_min_ps(t, _mm_set1_ps(8388608.0f)));
+	if (tilemode == GShader::kRepeat)
+	{
+		__m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(t));
+		whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, t), one));
+		return _mm_sub_ps(t, whole);
+	}
+	__m128 half = _mm_mul_ps(t, _mm_set1_ps(0.5f));
+	__m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(half));
+	whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmpgt_ps(whole, half), one));
+	half = _mm_mul_ps(_mm_sub_ps(half, whole), _mm_set1_ps(2.0f));
+	__m128 folded = _mm_andnot_ps(_mm_set1_ps(-0.0f), _mm_sub_ps(one, half));
+	return _mm_sub_ps(one, folded);
+}
+
+// look up 4 positions already folded into [0, 1]
+static inline void gradient_lookup_sse2(const GPixel table[GRADIENT_TABLE_SIZE], __m128 t, GPixel row[4])
+{
+	__m128i index = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, _mm_set1_ps((float)(GRADIENT_TABLE_SIZE - 1))), _mm_set1_ps(0.5f)));
+	int indices[4];
+	_mm_storeu_si128((__m128i*)indices, index);
+	row[0] = table[indices[0]];
+	row[1] = table[indices[1]];
+	row[2] = table[indices[2]];
+	row[3] = table[indices[3]];
+}
+
+#endif
+
+#endif
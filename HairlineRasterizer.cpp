@@ -0,0 +1,218 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "HairlineRasterizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// the part of a line worth stepping over, along its (possibly swapped) major axis
+// the line is p0 to p1 with p0.fX <= p1.fX, and slope is how much y changes for each x
+struct LineSpan
+{
+	int begin;
+	int end;
+};
+
+// narrow [begin, end) down to the steps whose minor coordinate could be in [minor_lo, minor_hi),
+// a step or so of slack either way since the exact check is made at each step
+static LineSpan clip_line_span(float begin, float end, const GPoint& p0, float slope, int major_lo, int major_hi,
+	int minor_lo, int minor_hi)
+{
+	begin = std::max(begin, (float)major_lo);
+	end = std::min(end, (float)major_hi);
+	if (slope != 0.0f)
+	{
+		float xa = p0.fX + ((minor_lo - 1) - p0.fY) / slope;
+		float xb = p0.fX + ((minor_hi + 1) - p0.fY) / slope;
+		begin = std::max(begin, std::floor(std::min(xa, xb)) - 1);
+		end = std::min(end, std::ceil(std::max(xa, xb)) + 1);
+	}
+	if (!(begin < end))
+	{
+		return { 0, 0 };
+	}
+	return { (int)begin, (int)end };
+}
+
+void HairlineRasterizer::stroke_contours(const GContour contours[], int count, const GMatrix& ctm, const GPaint& paint, float coverage,
+	const GIRect& clip, Blitter& blitter)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (paint.isDashed() == false)
+		{
+			this->stroke_contour(contours[i], ctm, paint.isAntiAlias(), coverage, clip, blitter);
+			continue;
+		}
+
+		// the dashes are cut before the ctm, so they scale along with the stroke
+		this->m_dasher.start(contours[i], paint);
+		GContour dash;
+		while (this->m_dasher.next(&dash) == true)
+		{
+			this->stroke_contour(dash, ctm, paint.isAntiAlias(), coverage, clip, blitter);
+		}
+	}
+}
+
+void HairlineRasterizer::stroke_contour(const GContour& contour, const GMatrix& ctm, bool anti_alias, float coverage,
+	const GIRect& clip, Blitter& blitter)
+{
+	if (contour.fCount < 2)
+	{
+		return;
+	}
+	this->m_points.resize(contour.fCount);
+	ctm.mapPoints(this->m_points.data(), contour.fPts, contour.fCount);
+
+	// every segment, and back to the start when it is closed (and more than a line)
+	int segment_count = contour.fCount - 1;
+	if (contour.fClosed == true && contour.fCount > 2)
+	{
+		++segment_count;
+	}
+	for (int j = 0; j < segment_count; ++j)
+	{
+		const GPoint& p0 = this->m_points[j];
+		const GPoint& p1 = this->m_points[(j + 1) % contour.fCount];
+		if (anti_alias == true)
+		{
+			this->draw_line_antialiased(p0, p1, coverage, clip, blitter);
+		}
+		else
+		{
+			this->draw_line(p0, p1, clip, blitter);
+		}
+	}
+}
+
+void HairlineRasterizer::draw_line(GPoint p0, GPoint p1, const GIRect& clip, Blitter& blitter)
+{
+	float dx = p1.fX - p0.fX;
+	float dy = p1.fY - p0.fY;
+	if (std::isfinite(dx) == false || std::isfinite(dy) == false || (dx == 0.0f && dy == 0.0f))
+	{
+		// not a number, or no length
+		return;
+	}
+
+	// step along y when the line is steeper, by swapping x and y
+	bool steep = std::fabs(dy) > std::fabs(dx);
+	if (steep == true)
+	{
+		std::swap(p0.fX, p0.fY);
+		std::swap(p1.fX, p1.fY);
+	}
+	if (p0.fX > p1.fX)
+	{
+		std::swap(p0, p1);
+	}
+	float slope = (p1.fY - p0.fY) / (p1.fX - p0.fX);
+	int major_lo = (steep == true ? clip.fTop : clip.fLeft);
+	int major_hi = (steep == true ? clip.fBottom : clip.fRight);
+	int minor_lo = (steep == true ? clip.fLeft : clip.fTop);
+	int minor_hi = (steep == true ? clip.fRight : clip.fBottom);
+
+	// the steps whose pixel centers are in [p0, p1), like the edges of a fill
+	LineSpan span = clip_line_span(std::floor(p0.fX + 0.5f), std::floor(p1.fX + 0.5f), p0, slope,
+		major_lo, major_hi, minor_lo, minor_hi);
+
+	// a flat line's pixels on the same row go out as one run
+	int run_left = 0;
+	int run_right = 0;
+	int run_row = 0;
+	for (int x = span.begin; x < span.end; ++x)
+	{
+		float y = p0.fY + slope * ((x + 0.5f) - p0.fX);
+		if (!(y >= minor_lo && y < minor_hi))
+		{
+			continue;
+		}
+		int row = (int)std::floor(y);
+		if (steep == true)
+		{
+			blitter.blit_row(row, x, 1);
+			continue;
+		}
+		if (row == run_row && x == run_right)
+		{
+			++run_right;
+			continue;
+		}
+		if (run_right > run_left)
+		{
+			blitter.blit_row(run_left, run_row, run_right - run_left);
+		}
+		run_left = x;
+		run_right = x + 1;
+		run_row = row;
+	}
+	if (run_right > run_left)
+	{
+		blitter.blit_row(run_left, run_row, run_right - run_left);
+	}
+}
+
+void HairlineRasterizer::draw_line_antialiased(GPoint p0, GPoint p1, float coverage, const GIRect& clip, Blitter& blitter)
+{
+	float dx = p1.fX - p0.fX;
+	float dy = p1.fY - p0.fY;
+	if (std::isfinite(dx) == false || std::isfinite(dy) == false || (dx == 0.0f && dy == 0.0f))
+	{
+		return;
+	}
+
+	bool steep = std::fabs(dy) > std::fabs(dx);
+	if (steep == true)
+	{
+		std::swap(p0.fX, p0.fY);
+		std::swap(p1.fX, p1.fY);
+	}
+	if (p0.fX > p1.fX)
+	{
+		std::swap(p0, p1);
+	}
+	float slope = (p1.fY - p0.fY) / (p1.fX - p0.fX);
+	int major_lo = (steep == true ? clip.fTop : clip.fLeft);
+	int major_hi = (steep == true ? clip.fBottom : clip.fRight);
+	int minor_lo = (steep == true ? clip.fLeft : clip.fTop);
+	int minor_hi = (steep == true ? clip.fRight : clip.fBottom);
+
+	// every step the line passes through, the ones at the ends only partly
+	LineSpan span = clip_line_span(std::floor(p0.fX), std::ceil(p1.fX), p0, slope, major_lo, major_hi, minor_lo, minor_hi);
+	for (int x = span.begin; x < span.end; ++x)
+	{
+		float left = std::max((float)x, p0.fX);
+		float right = std::min((float)(x + 1), p1.fX);
+		if (!(right > left))
+		{
+			continue;
+		}
+
+		// the line is a pixel thick, so it covers the two rows around the middle of its part of the step
+		float y = p0.fY + slope * ((left + right) * 0.5f - p0.fX) - 0.5f;
+		if (!(y >= minor_lo - 1 && y < minor_hi))
+		{
+			continue;
+		}
+		int row = (int)std::floor(y);
+		float below = y - row;
+		float amount = (right - left) * coverage * 255;
+		uint8_t covered[2] = { (uint8_t)(amount * (1 - below) + 0.5f), (uint8_t)(amount * below + 0.5f) };
+		for (int i = 0; i < 2; ++i)
+		{
+			if (covered[i] == 0)
+			{
+				continue;
+			}
+			if (steep == true)
+			{
+				blitter.blit_row_coverage(row + i, x, 1, &covered[i]);
+			}
+			else
+			{
+				blitter.blit_row_coverage(x, row + i, 1, &covered[i]);
+			}
+		}
+	}
+}
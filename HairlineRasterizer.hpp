@@ -0,0 +1,46 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef HairlineRasterizer_hpp
+#define HairlineRasterizer_hpp
+
+#include "include/GContour.h"
+#include "include/GMatrix.h"
+#include "include/GPaint.h"
+#include "include/GPoint.h"
+#include "include/GRect.h"
+#include "Blitter.hpp"
+#include "Dasher.hpp"
+#include <vector>
+
+// draws strokes no more than a pixel wide as lines straight onto the rows, instead of
+// filling outlines too thin to land on pixel centers reliably
+// a line steps along its longer axis, one pixel per column (or per row when it is steeper),
+// and the other coordinate comes from the line's equation at each pixel center, so where the
+// stepping starts (or gets clipped) never moves a pixel
+// aliased lines blit each run of pixels on a row at once, anti-aliased lines split each
+// step's coverage between the two pixels closest to the line
+class HairlineRasterizer
+{
+public:
+	// draw the segments of the contours (or of their dashes, when the paint is dashed), mapped by
+	// the ctm, inside of clip with the blitter
+	// anti-aliased pixels are scaled by coverage (0 to 1), aliased ones are always fully drawn
+	void stroke_contours(const GContour contours[], int count, const GMatrix& ctm, const GPaint& paint, float coverage,
+		const GIRect& clip, Blitter& blitter);
+
+private:
+	void stroke_contour(const GContour& contour, const GMatrix& ctm, bool anti_alias, float coverage,
+		const GIRect& clip, Blitter& blitter);
+
+	// the line from p0 to p1 in device space
+	void draw_line(GPoint p0, GPoint p1, const GIRect& clip, Blitter& blitter);
+	void draw_line_antialiased(GPoint p0, GPoint p1, float coverage, const GIRect& clip, Blitter& blitter);
+
+	// cuts up the contours of dashed strokes
+	Dasher m_dasher;
+
+	// the points of the current contour mapped by the ctm, kept between draws
+	std::vector<GPoint> m_points;
+};
+
+#endif
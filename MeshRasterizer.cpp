@@ -0,0 +1,177 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "MeshRasterizer.hpp"
+#include "utils.hpp"
+#include <algorithm>
+
+MeshRasterizer::MeshRasterizer(const GBitmap& bitmap, const GPaint& paint, const GMatrix& ctm, const GIRect& clip, const ClipMask* mask,
+	bool has_colors, bool has_tex)
+{
+	this->m_bitmap = &bitmap;
+	this->m_clip = clip;
+	this->m_mask = mask;
+	this->m_ctm = ctm;
+	this->m_row_proc = get_blend_mode_procs(paint.getBlendMode()).row;
+	this->m_shader = (has_tex == true ? paint.getShader() : nullptr);
+	this->m_has_colors = has_colors;
+	this->m_alpha = std::min(std::max(paint.getAlpha(), 0.0f), 1.0f);
+	for (int i = 0; i < 4; ++i)
+	{
+		this->m_color[i] = 0.0f;
+		this->m_color_dx[i] = 0.0f;
+		this->m_color_dy[i] = 0.0f;
+	}
+
+	// it takes colors or a texture to have anything to draw, and kDst never changes a pixel
+	this->m_visible = (this->m_has_colors == true || this->m_shader != nullptr) && paint.getBlendMode() != GBlendMode::kDst;
+}
+
+bool MeshRasterizer::set_triangle(const GPoint device[3], const GPoint local[3], const GColor colors[3], const GPoint tex[3])
+{
+	if (this->m_has_colors == true)
+	{
+		// device corner 0 is the pivot, corner 1 is u = 1 and corner 2 is v = 1
+		GMatrix uv;
+		uv.set6(device[1].fX - device[0].fX, device[2].fX - device[0].fX, device[0].fX,
+			device[1].fY - device[0].fY, device[2].fY - device[0].fY, device[0].fY);
+		if (uv.invert(&uv) == false)
+		{
+			// no area, so no pixels
+			return false;
+		}
+
+		// every channel is linear across the triangle, so it steps by a constant along x and y
+		float c0[4] = { colors[0].fA, colors[0].fR, colors[0].fG, colors[0].fB };
+		float c1[4] = { colors[1].fA, colors[1].fR, colors[1].fG, colors[1].fB };
+		float c2[4] = { colors[2].fA, colors[2].fR, colors[2].fG, colors[2].fB };
+		for (int i = 0; i < 4; ++i)
+		{
+			float du = c1[i] - c0[i];
+			float dv = c2[i] - c0[i];
+			this->m_color_dx[i] = uv[GMatrix::SX] * du + uv[GMatrix::KY] * dv;
+			this->m_color_dy[i] = uv[GMatrix::KX] * du + uv[GMatrix::SY] * dv;
+			this->m_color[i] = c0[i] + (0.5f - device[0].fX) * this->m_color_dx[i] + (0.5f - device[0].fY) * this->m_color_dy[i];
+		}
+	}
+
+	if (this->m_shader != nullptr)
+	{
+		// the shader sees the texture's space mapped onto the triangle and then through the ctm
+		GMatrix pts_matrix;
+		pts_matrix.set6(local[1].fX - local[0].fX, local[2].fX - local[0].fX, local[0].fX,
+			local[1].fY - local[0].fY, local[2].fY - local[0].fY, local[0].fY);
+		GMatrix tex_matrix;
+		tex_matrix.set6(tex[1].fX - tex[0].fX, tex[2].fX - tex[0].fX, tex[0].fX,
+			tex[1].fY - tex[0].fY, tex[2].fY - tex[0].fY, tex[0].fY);
+		if (tex_matrix.invert(&tex_matrix) == false)
+		{
+			// the texture coordinates have no area to look up into
+			return false;
+		}
+
+		GMatrix combined;
+		combined.setConcat(this->m_ctm, pts_matrix);
+		combined.setConcat(combined, tex_matrix);
+		if (this->m_shader->setContext(combined, this->m_alpha) == false)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MeshRasterizer::shade_colors(int x, int y, int count, GPixel row[]) const
+{
+	float a = this->m_color[0] + x * this->m_color_dx[0] + y * this->m_color_dy[0];
+	float r = this->m_color[1] + x * this->m_color_dx[1] + y * this->m_color_dy[1];
+	float g = this->m_color[2] + x * this->m_color_dx[2] + y * this->m_color_dy[2];
+	float b = this->m_color[3] + x * this->m_color_dx[3] + y * this->m_color_dy[3];
+
+	// with a texture the paint's alpha is already in its pixels
+	float alpha = (this->m_shader != nullptr ? 1.0f : this->m_alpha);
+	for (int i = 0; i < count; ++i)
+	{
+		// pixel centers can land a hair outside of the triangle, so pin before premultiplying
+		float pa = std::min(std::max(a, 0.0f), 1.0f) * alpha;
+		float pr = std::min(std::max(r, 0.0f), 1.0f);
+		float pg = std::min(std::max(g, 0.0f), 1.0f);
+		float pb = std::min(std::max(b, 0.0f), 1.0f);
+
+		// same rounding as convert_color_to_pixel
+		unsigned int A = pa * 255 + 0.5f;
+		unsigned int R = pr * 255 * pa + 0.5f;
+		unsigned int G = pg * 255 * pa + 0.5f;
+		unsigned int B = pb * 255 * pa + 0.5f;
+		row[i] = GPixel_PackARGB(A, R, G, B);
+
+		a += this->m_color_dx[0];
+		r += this->m_color_dx[1];
+		g += this->m_color_dx[2];
+		b += this->m_color_dx[3];
+	}
+}
+
+void MeshRasterizer::blit_row(int x, int y, int count)
+{
+	// only the part of the row inside the clip gets touched
+	int left = std::max(x, this->m_clip.fLeft);
+	int right = std::min(x + count, this->m_clip.fRight);
+	if (left >= right || y < this->m_clip.fTop || y >= this->m_clip.fBottom)
+	{
+		// nothing to draw
+		return;
+	}
+
+	if (this->m_mask != nullptr)
+	{
+		// just the parts of the row inside of the mask's runs
+		this->m_mask->for_each_run(y, left, right, [this, x, y, count] (int run_left, int run_right)
+			{
+				this->blit_span(x, y, count, run_left, run_right);
+			}
+		);
+		return;
+	}
+	this->blit_span(x, y, count, left, right);
+}
+
+void MeshRasterizer::blit_span(int x, int y, int count, int left, int right)
+{
+	GPixel* row_pixels = this->m_bitmap->pixels() + ((this->m_bitmap->rowBytes() >> 2) * y);
+
+	// 256 pixel chunks counted from x, like the Blitter, so a clipped row shades exactly
+	// the same chunks (and steps the colors from the same places) as the whole row would
+	GPixel buffer[256];
+	GPixel colors[256];
+	for (int chunk = x + ((left - x) & ~255); chunk < right; chunk += 256)
+	{
+		int n = std::min(x + count - chunk, 256);
+		if (this->m_shader != nullptr)
+		{
+			this->m_shader->shadeRow(chunk, y, n, buffer);
+			if (this->m_has_colors == true)
+			{
+				// modulate the texture by the colors
+				this->shade_colors(chunk, y, n, colors);
+				for (int i = 0; i < n; ++i)
+				{
+					GPixel t = buffer[i];
+					GPixel c = colors[i];
+					buffer[i] = GPixel_PackARGB(divide_by_255(GPixel_GetA(t) * GPixel_GetA(c)),
+						divide_by_255(GPixel_GetR(t) * GPixel_GetR(c)),
+						divide_by_255(GPixel_GetG(t) * GPixel_GetG(c)),
+						divide_by_255(GPixel_GetB(t) * GPixel_GetB(c)));
+				}
+			}
+		}
+		else
+		{
+			this->shade_colors(chunk, y, n, buffer);
+		}
+
+		int start = std::max(chunk, left);
+		int end = std::min(chunk + n, right);
+		this->m_row_proc(buffer + (start - chunk), row_pixels + start, end - start);
+	}
+}
@@ -0,0 +1,67 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef MeshRasterizer_hpp
+#define MeshRasterizer_hpp
+
+#include "include/GBitmap.h"
+#include "include/GColor.h"
+#include "include/GMatrix.h"
+#include "include/GPaint.h"
+#include "include/GPixel.h"
+#include "include/GPoint.h"
+#include "include/GRect.h"
+#include "include/GShader.h"
+#include "BlendProcs.hpp"
+#include "ClipMask.hpp"
+
+// shades and blends the rows of mesh triangles, one triangle at a time
+// the colors are stepped straight across each row from the triangle's barycentric gradients,
+// and a texture is the paint's shader set up for the triangle, modulated by the colors
+// the paint's alpha is applied once, whether there are colors, a texture or both
+class MeshRasterizer
+{
+public:
+	// setup to draw with the paint onto the bitmap, nothing outside of clip (or outside of the
+	// runs of mask, when there is one) is ever touched
+	// has_tex only counts when the paint has a shader for it to look up into
+	MeshRasterizer(const GBitmap& bitmap, const GPaint& paint, const GMatrix& ctm, const GIRect& clip, const ClipMask* mask,
+		bool has_colors, bool has_tex);
+
+	// false if nothing drawn with this paint can change a pixel
+	bool is_visible() const { return this->m_visible; }
+
+	// get ready for the triangle with the given corners, before (local) and after (device) the ctm
+	// colors and tex are only read if the constructor was told about them
+	// false if the triangle cannot be drawn (it has no area, or its texture has none)
+	bool set_triangle(const GPoint device[3], const GPoint local[3], const GColor colors[3], const GPoint tex[3]);
+
+	// blend the pixels [x, x + count) on row y of the current triangle
+	void blit_row(int x, int y, int count);
+
+private:
+	// blend the pixels [left, right) on row y, out of the row [x, x + count) they were asked for with
+	void blit_span(int x, int y, int count, int left, int right);
+
+	// write the colors for [x, x + count) on row y, count is at most 256
+	void shade_colors(int x, int y, int count, GPixel row[]) const;
+
+	const GBitmap* m_bitmap;
+	GIRect m_clip;
+	const ClipMask* m_mask;
+	bool m_visible;
+	GMatrix m_ctm;
+	BlendRowProc m_row_proc;
+
+	// the texture comes from the paint's shader (nullptr when there is no texture)
+	GShader* m_shader;
+	bool m_has_colors;
+	float m_alpha;
+
+	// the colors of the current triangle as a, r, g, b at the center of pixel (0, 0),
+	// and how much they change for each pixel across and down
+	float m_color[4];
+	float m_color_dx[4];
+	float m_color_dy[4];
+};
+
+#endif
@@ -0,0 +1,44 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "Mipmap.hpp"
+#include "BitmapFilters.hpp"
+#include <algorithm>
+
+Mipmap::Mipmap(const GBitmap& bitmap)
+{
+	// halve (rounding up) until both sides are down to 1
+	this->m_max_level = 0;
+	int width = bitmap.width();
+	int height = bitmap.height();
+	while (width > 1 || height > 1)
+	{
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+		this->m_max_level++;
+	}
+
+	// room for every level up front, so the references level() hands out stay good
+	this->m_levels.reserve(this->m_max_level + 1);
+	this->m_pixels.reserve(this->m_max_level);
+	this->m_levels.push_back(bitmap);
+}
+
+const GBitmap& Mipmap::level(int index)
+{
+	index = std::max(0, std::min(index, this->m_max_level));
+	while ((int)this->m_levels.size() <= index)
+	{
+		const GBitmap& previous = this->m_levels.back();
+
+		GBitmap next;
+		next.fWidth = (previous.width() + 1) / 2;
+		next.fHeight = (previous.height() + 1) / 2;
+		this->m_pixels.push_back(std::vector<GPixel>(next.fWidth * next.fHeight));
+		next.fPixels = this->m_pixels.back().data();
+		next.fRowBytes = next.fWidth * sizeof(GPixel);
+
+		downsample_2x2(previous, next);
+		this->m_levels.push_back(next);
+	}
+	return this->m_levels[index];
+}
@@ -0,0 +1,37 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef Mipmap_hpp
+#define Mipmap_hpp
+
+#include "include/GBitmap.h"
+#include "include/GPixel.h"
+#include <vector>
+
+// the chain of half sized copies of a bitmap, down to 1x1, for drawing it shrunk down
+// level 0 is the bitmap itself (not copied), each level after that is a 2x2 box filter of
+// the one before it, and a level is only made the first time someone asks for it
+// the levels are not remade if the bitmap's pixels change afterwards
+class Mipmap
+{
+public:
+	Mipmap(const GBitmap& bitmap);
+
+	Mipmap(const Mipmap&) = delete;
+	Mipmap& operator=(const Mipmap&) = delete;
+
+	// the index of the 1x1 level
+	int max_level() const { return this->m_max_level; }
+
+	// the level at index (clamped to [0, max_level]), made along with any levels above it
+	// that are not there yet, the reference stays good for as long as the mipmap does
+	const GBitmap& level(int index);
+
+private:
+	int m_max_level;
+
+	// the levels made so far, and the pixels for every level past 0
+	std::vector<GBitmap> m_levels;
+	std::vector<std::vector<GPixel>> m_pixels;
+};
+
+#endif
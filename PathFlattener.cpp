@@ -0,0 +1,22 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "PathFlattener.hpp"
+#include "utils.hpp"
+
+void PathFlattener::flatten(const GPath& path, const GMatrix& ctm)
+{
+	this->m_points.clear();
+	this->m_contours.clear();
+
+	// a quarter pixel on the bitmap, in the path's own units, with the lines going straight
+	// into the buffers
+	path.flatten(0.25f / max_scale(ctm), &this->m_points, &this->m_contours);
+
+	// now that the points have a home that stops moving, the contours can point into it
+	const GPoint* points = this->m_points.data();
+	for (GContour& c : this->m_contours)
+	{
+		c.fPts = points;
+		points += c.fCount;
+	}
+}
@@ -0,0 +1,31 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef PathFlattener_hpp
+#define PathFlattener_hpp
+
+#include "include/GContour.h"
+#include "include/GMatrix.h"
+#include "include/GPath.h"
+#include "include/GPoint.h"
+#include <vector>
+
+// turns a path into contours of lines for drawing under a ctm
+// curves are cut into as few lines as keep them within a quarter pixel once on the bitmap, so a
+// zoomed out path makes far fewer edges and a zoomed in one stays smooth
+// the contours live in buffers that keep their memory from one path to the next
+class PathFlattener
+{
+public:
+	// flatten the path for drawing with the ctm, replacing the last contours
+	void flatten(const GPath& path, const GMatrix& ctm);
+
+	// the contours from the last path
+	const GContour* contours() const { return this->m_contours.data(); }
+	int contour_count() const { return (int)this->m_contours.size(); }
+
+private:
+	std::vector<GPoint> m_points;
+	std::vector<GContour> m_contours;
+};
+
+#endif
@@ -4,6 +4,7 @@
 #define PolygonEdge_hpp
 
 #include <string>
+#include <cmath>
 
 struct PolygonEdge
 {
@@ -12,24 +13,112 @@ struct PolygonEdge
 	float m_slope;
 	float x_current;
 	int m_orientation;
+
+	// 16.16 fixed point copies of x_current and m_slope, only used when is_fixed is set
+	int x_fixed;
+	int slope_fixed;
+	bool is_fixed;
+
+	// links edges that start on the same scanline together
+	PolygonEdge* next;
 	
 	PolygonEdge(int y_min, int y_max, float m_slope, float x_current, int orientation)
 	{
+		this->next = nullptr;
 		this->y_min = y_min;
 		this->y_max = y_max;
 		this->m_slope = m_slope;
 		this->x_current = x_current;
 		this->m_orientation = orientation;
+		this->x_fixed = 0;
+		this->slope_fixed = 0;
+		this->is_fixed = false;
+	}
+
+	// switch the edge over to stepping in 16.16 fixed point
+	// edges too far out (or too flat) to fit stay in float
+	void use_fixed_point()
+	{
+		// keeps x and the sum of a step well inside of 16.16's range
+		const float limit = 16384.0f;
+		if (std::fabs(this->x_current) >= limit || std::fabs(this->m_slope) >= limit)
+		{
+			return;
+		}
+		this->x_fixed = (int)std::floor(this->x_current * 65536.0f + 0.5f);
+		this->slope_fixed = (int)std::floor(this->m_slope * 65536.0f + 0.5f);
+		this->is_fixed = true;
+	}
+
+	// the pixel the edge lands on for the current scanline
+	int current_pixel() const
+	{
+		if (this->is_fixed == true)
+		{
+			return (this->x_fixed + 0x8000) >> 16;
+		}
+		return (int)(this->x_current + 0.5f);
+	}
+
+	// move down to the next scanline
+	void step()
+	{
+		if (this->is_fixed == true)
+		{
+			this->x_fixed += this->slope_fixed;
+		}
+		else
+		{
+			this->x_current += this->m_slope;
+		}
+	}
+
+	// move down count scanlines at once, to the same x as stepping count times
+	void advance(int count)
+	{
+		if (this->is_fixed == true)
+		{
+			// integer adds are exact, so one multiply is the same as count of them
+			this->x_fixed += count * this->slope_fixed;
+			return;
+		}
+
+		// float adds round at every step, so they are all made to land where the rows above
+		// would have left x
+		for (int i = 0; i < count; ++i)
+		{
+			this->x_current += this->m_slope;
+		}
+	}
+
+	// is this edge currently to the left of the other one
+	bool is_left_of(const PolygonEdge& other) const
+	{
+		if (this->is_fixed == true && other.is_fixed == true)
+		{
+			return this->x_fixed < other.x_fixed;
+		}
+		return this->current_x() < other.current_x();
+	}
+
+	// the current x in float, whichever way the edge is stepping
+	float current_x() const
+	{
+		if (this->is_fixed == true)
+		{
+			return this->x_fixed * (1.0f / 65536.0f);
+		}
+		return this->x_current;
 	}
 
 	std::string to_string() const
 	{
 		std::string s = "PolygonEdge{ " + std::to_string(this->y_min) + ", " + std::to_string(this->y_max) + ", " + 
-			std::to_string(this->m_slope) + ", " + std::to_string(this->x_current) + ", " +
+			std::to_string(this->m_slope) + ", " + std::to_string(this->current_x()) + ", " +
 			std::to_string(this->m_orientation) + " }";
 
 		return s;
 	}
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,128 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "QuadPatch.hpp"
+
+static const std::vector<int> gNoIndices;
+
+QuadPatch::QuadPatch()
+{
+	this->m_layouts.resize(MAX_LAYOUTS);
+	for (Layout& layout : this->m_layouts)
+	{
+		layout.strip_count = 0;
+		layout.last_use = 0;
+	}
+	this->m_uses = 0;
+	this->m_triangle_count = 0;
+	this->m_indices = &gNoIndices;
+}
+
+int QuadPatch::cached_layout_count() const
+{
+	int count = 0;
+	for (const Layout& layout : this->m_layouts)
+	{
+		if (layout.strip_count > 0)
+		{
+			++count;
+		}
+	}
+	return count;
+}
+
+const QuadPatch::Layout& QuadPatch::layout(int strip_count)
+{
+	// one of the kept ones, or else the empty or least recently used slot
+	++this->m_uses;
+	Layout* oldest = &this->m_layouts[0];
+	for (Layout& kept : this->m_layouts)
+	{
+		if (kept.strip_count == strip_count)
+		{
+			kept.last_use = this->m_uses;
+			return kept;
+		}
+		if (kept.last_use < oldest->last_use)
+		{
+			oldest = &kept;
+		}
+	}
+
+	// built over in place, so its buffers get reused
+	Layout& layout = *oldest;
+	layout.strip_count = strip_count;
+	layout.last_use = this->m_uses;
+	int n = strip_count + 1;
+	layout.steps.resize(n);
+	for (int i = 0; i < n; ++i)
+	{
+		layout.steps[i] = (float)i / strip_count;
+	}
+
+	// two triangles for each cell of the grid, sharing the diagonal from its left top to its right bottom
+	layout.indices.clear();
+	layout.indices.reserve(strip_count * strip_count * 6);
+	for (int row = 0; row < strip_count; ++row)
+	{
+		for (int col = 0; col < strip_count; ++col)
+		{
+			int left_top = row * n + col;
+			int right_top = left_top + 1;
+			int left_bottom = left_top + n;
+			int right_bottom = left_bottom + 1;
+
+			layout.indices.push_back(left_top);
+			layout.indices.push_back(right_top);
+			layout.indices.push_back(right_bottom);
+
+			layout.indices.push_back(left_top);
+			layout.indices.push_back(right_bottom);
+			layout.indices.push_back(left_bottom);
+		}
+	}
+	return layout;
+}
+
+bool QuadPatch::tessellate(const GPoint pts[4], const GColor colors[4], int strip_count)
+{
+	if (strip_count < 1)
+	{
+		this->m_triangle_count = 0;
+		this->m_indices = &gNoIndices;
+		this->m_points.clear();
+		this->m_colors.clear();
+		return false;
+	}
+
+	const Layout& layout = this->layout(strip_count);
+	int n = strip_count + 1;
+	this->m_triangle_count = strip_count * strip_count * 2;
+	this->m_indices = &layout.indices;
+	this->m_points.resize(n * n);
+	this->m_colors.resize(n * n);
+
+	GPoint* points = this->m_points.data();
+	GColor* vertex_colors = this->m_colors.data();
+	for (int row = 0; row < n; ++row)
+	{
+		float v = layout.steps[row];
+		for (int col = 0; col < n; ++col)
+		{
+			// each corner weighted by how close (u, v) is to it
+			float u = layout.steps[col];
+			float w0 = (1 - u) * (1 - v);
+			float w1 = u * (1 - v);
+			float w2 = u * v;
+			float w3 = (1 - u) * v;
+			points[col] = GPoint::Make(pts[0].fX * w0 + pts[1].fX * w1 + pts[2].fX * w2 + pts[3].fX * w3,
+				pts[0].fY * w0 + pts[1].fY * w1 + pts[2].fY * w2 + pts[3].fY * w3);
+			vertex_colors[col] = GColor::MakeARGB(colors[0].fA * w0 + colors[1].fA * w1 + colors[2].fA * w2 + colors[3].fA * w3,
+				colors[0].fR * w0 + colors[1].fR * w1 + colors[2].fR * w2 + colors[3].fR * w3,
+				colors[0].fG * w0 + colors[1].fG * w1 + colors[2].fG * w2 + colors[3].fG * w3,
+				colors[0].fB * w0 + colors[1].fB * w1 + colors[2].fB * w2 + colors[3].fB * w3);
+		}
+		points += n;
+		vertex_colors += n;
+	}
+	return true;
+}
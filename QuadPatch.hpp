@@ -0,0 +1,71 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef QuadPatch_hpp
+#define QuadPatch_hpp
+
+#include "include/GColor.h"
+#include "include/GPoint.h"
+#include <vector>
+
+// turns a bilinear patch into an indexed mesh for drawMesh
+// the layout of the mesh (the indices, and where each vertex sits in u and v) only depends on
+// the strip count, so it is made once per strip count and kept, and a patch that moves
+// only has its points and colors worked out again
+// only the layouts of the last few strip counts are kept, the least recently used one is
+// built over when another is needed
+class QuadPatch
+{
+public:
+	enum
+	{
+		// the most layouts kept at once
+		MAX_LAYOUTS = 4,
+	};
+
+	QuadPatch();
+
+	QuadPatch(const QuadPatch&) = delete;
+	QuadPatch& operator=(const QuadPatch&) = delete;
+
+	// work out the mesh for the patch with corners pts (left top, right top, right bottom,
+	// left bottom) and their colors, split into strip_count strips each way
+	// false (and an empty mesh) if strip_count is less than 1
+	bool tessellate(const GPoint pts[4], const GColor colors[4], int strip_count);
+
+	// the mesh from the last tessellate, good until the next one
+	int triangle_count() const { return this->m_triangle_count; }
+	const GPoint* points() const { return this->m_points.data(); }
+	const GColor* colors() const { return this->m_colors.data(); }
+	const int* indices() const { return this->m_indices->data(); }
+
+	// how many strip counts have a layout kept around
+	int cached_layout_count() const;
+
+private:
+	// what stays the same for every patch with the same strip count
+	struct Layout
+	{
+		// 0 for a slot with no layout in it yet
+		int strip_count;
+		// when it was last asked for, so the oldest one can be built over
+		unsigned int last_use;
+		// u (and v) of each column (and row) of vertices
+		std::vector<float> steps;
+		std::vector<int> indices;
+	};
+
+	// the layout for strip_count, made when it is not one of the kept ones
+	const Layout& layout(int strip_count);
+
+	// MAX_LAYOUTS slots, never resized, so m_indices stays good
+	std::vector<Layout> m_layouts;
+	unsigned int m_uses;
+
+	// the last mesh
+	int m_triangle_count;
+	const std::vector<int>* m_indices;
+	std::vector<GPoint> m_points;
+	std::vector<GColor> m_colors;
+};
+
+#endif
@@ -0,0 +1,278 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "Stroker.hpp"
+#include <algorithm>
+#include <cmath>
+
+// the most a chord of a round join or cap strays from its circle, in pixels on the bitmap
+static const float kArcTolerance = 0.25f;
+
+static const float kPi = 3.14159265f;
+
+void Stroker::stroke(const GContour contours[], int count, const GPaint& paint, float device_scale)
+{
+	this->m_radius = paint.getStrokeWidth() / 2.0f;
+	this->m_miter_limit = paint.getMiterLimit();
+	this->m_join = paint.getStrokeJoin();
+	this->m_cap = paint.getStrokeCap();
+	this->m_points.clear();
+	this->m_starts.clear();
+	this->m_contours.clear();
+
+	// a chord turning by step strays r * (1 - cos(step / 2)) from the circle, at least 4 chords to a circle
+	float device_radius = this->m_radius * device_scale;
+	this->m_arc_step = kPi / 2;
+	if (device_radius > kArcTolerance)
+	{
+		this->m_arc_step = std::min(2 * std::acos(1 - kArcTolerance / device_radius), kPi / 2);
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		if (paint.isDashed() == false)
+		{
+			this->stroke_contour(contours[i]);
+			continue;
+		}
+		this->m_dasher.start(contours[i], paint);
+		GContour dash;
+		while (this->m_dasher.next(&dash) == true)
+		{
+			this->stroke_contour(dash);
+		}
+	}
+
+	// the points are all in place now, so the outlines can point at them
+	int outline_count = (int)this->m_starts.size();
+	for (int i = 0; i < outline_count; ++i)
+	{
+		int start = this->m_starts[i];
+		int end = (i + 1 < outline_count ? this->m_starts[i + 1] : (int)this->m_points.size());
+		GContour contour = { end - start, this->m_points.data() + start, true };
+		this->m_contours.push_back(contour);
+	}
+}
+
+void Stroker::stroke_contour(const GContour& contour)
+{
+	// repeated points have no direction to stroke along
+	std::vector<GPoint>& path = this->m_path;
+	path.clear();
+	for (int i = 0; i < contour.fCount; ++i)
+	{
+		const GPoint& p = contour.fPts[i];
+		if (path.empty() == true || p.fX != path.back().fX || p.fY != path.back().fY)
+		{
+			path.push_back(p);
+		}
+	}
+	if (contour.fClosed == true)
+	{
+		while (path.size() > 1 && path.back().fX == path.front().fX && path.back().fY == path.front().fY)
+		{
+			path.pop_back();
+		}
+	}
+
+	int count = (int)path.size();
+	if (count < 2)
+	{
+		// nothing with a length, but a line that goes nowhere still gets its caps
+		if (count == 1 && contour.fCount > 1)
+		{
+			this->add_dot(path[0]);
+		}
+		return;
+	}
+
+	// it takes a triangle to have an inside, anything less is stroked like an open line
+	bool closed = (contour.fClosed == true && count >= 3);
+	int segment_count = (closed == true ? count : count - 1);
+	std::vector<GPoint>& directions = this->m_directions;
+	directions.resize(segment_count);
+	for (int i = 0; i < segment_count; ++i)
+	{
+		const GPoint& next = path[(i + 1) % count];
+		float dx = next.fX - path[i].fX;
+		float dy = next.fY - path[i].fY;
+		float length = std::sqrt(dx * dx + dy * dy);
+		directions[i] = GPoint::Make(dx / length, dy / length);
+	}
+
+	this->m_right.clear();
+	int first = (int)this->m_points.size();
+	if (closed == true)
+	{
+		// a join at every point, the left side is one outline and the right side (backwards) is the other
+		for (int i = 0; i < count; ++i)
+		{
+			this->add_join(path[i], directions[(i + segment_count - 1) % segment_count], directions[i]);
+		}
+		this->finish_outline(first);
+
+		first = (int)this->m_points.size();
+		this->m_points.insert(this->m_points.end(), this->m_right.rbegin(), this->m_right.rend());
+		this->finish_outline(first);
+		return;
+	}
+
+	// across the start, along the left side, across the end and back along the right side
+	this->add_start_cap(path[0], directions[0]);
+	for (int i = 1; i < count - 1; ++i)
+	{
+		this->add_join(path[i], directions[i - 1], directions[i]);
+	}
+	this->add_end_cap(path[count - 1], directions[segment_count - 1]);
+	this->m_points.insert(this->m_points.end(), this->m_right.rbegin(), this->m_right.rend());
+	this->finish_outline(first);
+}
+
+void Stroker::add_dot(const GPoint& point)
+{
+	float r = this->m_radius;
+	int first = (int)this->m_points.size();
+	if (this->m_cap == GPaint::Cap::kRound)
+	{
+		// both round caps make a circle
+		this->m_points.push_back(GPoint::Make(point.fX + r, point.fY));
+		this->add_arc(this->m_points, point, GPoint::Make(r, 0), 2 * kPi);
+	}
+	else if (this->m_cap == GPaint::Cap::kSquare)
+	{
+		// and both square caps a square, lined up with the axes since there is no direction
+		this->m_points.push_back(GPoint::Make(point.fX - r, point.fY - r));
+		this->m_points.push_back(GPoint::Make(point.fX + r, point.fY - r));
+		this->m_points.push_back(GPoint::Make(point.fX + r, point.fY + r));
+		this->m_points.push_back(GPoint::Make(point.fX - r, point.fY + r));
+	}
+	this->finish_outline(first);
+}
+
+void Stroker::add_start_cap(const GPoint& point, const GPoint& d)
+{
+	// the normal (to the left), and the direction, scaled to the edge of the stroke
+	float r = this->m_radius;
+	GPoint n = GPoint::Make(-d.fY * r, d.fX * r);
+	GPoint back = GPoint::Make(point.fX, point.fY);
+	if (this->m_cap == GPaint::Cap::kSquare)
+	{
+		// pushed back by the radius
+		back = GPoint::Make(point.fX - d.fX * r, point.fY - d.fY * r);
+	}
+
+	this->m_points.push_back(GPoint::Make(back.fX - n.fX, back.fY - n.fY));
+	if (this->m_cap == GPaint::Cap::kRound)
+	{
+		// around the back of the point, from the right side to the left
+		this->add_arc(this->m_points, point, GPoint::Make(-n.fX, -n.fY), -kPi);
+	}
+	this->m_points.push_back(GPoint::Make(back.fX + n.fX, back.fY + n.fY));
+}
+
+void Stroker::add_end_cap(const GPoint& point, const GPoint& d)
+{
+	float r = this->m_radius;
+	GPoint n = GPoint::Make(-d.fY * r, d.fX * r);
+	GPoint front = GPoint::Make(point.fX, point.fY);
+	if (this->m_cap == GPaint::Cap::kSquare)
+	{
+		// pushed out by the radius
+		front = GPoint::Make(point.fX + d.fX * r, point.fY + d.fY * r);
+	}
+
+	this->m_points.push_back(GPoint::Make(front.fX + n.fX, front.fY + n.fY));
+	if (this->m_cap == GPaint::Cap::kRound)
+	{
+		// around the front of the point, from the left side to the right
+		this->add_arc(this->m_points, point, n, -kPi);
+	}
+	this->m_points.push_back(GPoint::Make(front.fX - n.fX, front.fY - n.fY));
+}
+
+void Stroker::add_join(const GPoint& point, const GPoint& d0, const GPoint& d1)
+{
+	float cross = d0.fX * d1.fY - d0.fY * d1.fX;
+	float dot = d0.fX * d1.fX + d0.fY * d1.fY;
+	if (cross == 0.0f && dot > 0.0f)
+	{
+		// straight on, the sides just keep going
+		return;
+	}
+
+	// the normals (to the left) of both segments, scaled to the edges of the stroke
+	float r = this->m_radius;
+	GPoint n0 = GPoint::Make(-d0.fY * r, d0.fX * r);
+	GPoint n1 = GPoint::Make(-d1.fY * r, d1.fX * r);
+
+	// turning right the left side is the outside, turning left (or doubling back) it is the right
+	// side, and the outside's normals point the other way
+	bool left_outside = (cross < 0.0f);
+	std::vector<GPoint>& outside = (left_outside == true ? this->m_points : this->m_right);
+	std::vector<GPoint>& inside = (left_outside == true ? this->m_right : this->m_points);
+	float outside_sign = (left_outside == true ? 1.0f : -1.0f);
+	GPoint out0 = GPoint::Make(n0.fX * outside_sign, n0.fY * outside_sign);
+	GPoint out1 = GPoint::Make(n1.fX * outside_sign, n1.fY * outside_sign);
+
+	// the inside goes through the joint itself
+	inside.push_back(GPoint::Make(point.fX - out0.fX, point.fY - out0.fY));
+	inside.push_back(point);
+	inside.push_back(GPoint::Make(point.fX - out1.fX, point.fY - out1.fY));
+
+	outside.push_back(GPoint::Make(point.fX + out0.fX, point.fY + out0.fY));
+	if (this->m_join == GPaint::Join::kRound)
+	{
+		// around the turn, which goes the same way as the segments do
+		float angle = std::acos(std::min(std::max(dot, -1.0f), 1.0f));
+		this->add_arc(outside, point, out0, (cross < 0.0f ? -angle : angle));
+	}
+	else if (this->m_join == GPaint::Join::kMiter)
+	{
+		// the miter point is r / cos(half the turn) out along the bisector of the normals,
+		// unless that is past the miter limit (or the segment doubles back on itself), then it is a bevel
+		float cos_half_squared = (1.0f + dot) / 2.0f;
+		if (cos_half_squared > 0.0f)
+		{
+			float miter_length = r / std::sqrt(cos_half_squared);
+			if (miter_length <= this->m_miter_limit * r)
+			{
+				float bx = out0.fX + out1.fX;
+				float by = out0.fY + out1.fY;
+				float scale = miter_length / std::sqrt(bx * bx + by * by);
+				outside.push_back(GPoint::Make(point.fX + bx * scale, point.fY + by * scale));
+			}
+		}
+	}
+	outside.push_back(GPoint::Make(point.fX + out1.fX, point.fY + out1.fY));
+}
+
+void Stroker::add_arc(std::vector<GPoint>& points, const GPoint& center, const GPoint& from, float angle)
+{
+	int steps = (int)std::ceil(std::fabs(angle) / this->m_arc_step);
+	if (steps < 2)
+	{
+		// a single chord, straight from one end to the other
+		return;
+	}
+
+	// turn the offset a step at a time
+	float step = angle / steps;
+	float c = std::cos(step);
+	float s = std::sin(step);
+	GPoint offset = from;
+	for (int i = 1; i < steps; ++i)
+	{
+		offset = GPoint::Make(offset.fX * c - offset.fY * s, offset.fX * s + offset.fY * c);
+		points.push_back(GPoint::Make(center.fX + offset.fX, center.fY + offset.fY));
+	}
+}
+
+void Stroker::finish_outline(int first)
+{
+	if ((int)this->m_points.size() - first < 3)
+	{
+		// no area
+		this->m_points.resize(first);
+		return;
+	}
+	this->m_starts.push_back(first);
+}
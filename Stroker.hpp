@@ -0,0 +1,79 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef Stroker_hpp
+#define Stroker_hpp
+
+#include "include/GContour.h"
+#include "include/GPaint.h"
+#include "include/GPoint.h"
+#include "Dasher.hpp"
+#include <vector>
+
+// turns stroked contours into outlines that a nonzero fill draws as the stroke
+// each contour is walked once: an open one becomes a single closed outline (one side forward,
+// the end cap, the other side back and the start cap), a closed one becomes the outline of each side
+// the paint's join goes on the outside of a turn, and the inside goes through the joint itself,
+// so every segment and join winds the same way and overlaps just fill once instead of blending twice
+// a dashed paint has each dash outlined as its own open contour as the dasher hands it out
+// round joins and caps are arcs cut into as few chords as keep them within a quarter pixel of
+// the circle on the bitmap, so how many depends on how big the ctm makes the stroke
+// the outlines live in buffers that keep their memory from one stroke to the next
+class Stroker
+{
+public:
+	// outline the contours for a stroke with the paint's width, join and cap, replacing the last outlines
+	// device_scale is how much the ctm stretches the stroke (at most)
+	void stroke(const GContour contours[], int count, const GPaint& paint, float device_scale);
+
+	// the outlines from the last stroke
+	const GContour* contours() const { return this->m_contours.data(); }
+	int contour_count() const { return (int)this->m_contours.size(); }
+
+private:
+	void stroke_contour(const GContour& contour);
+
+	// a contour with no length, which is just its caps
+	void add_dot(const GPoint& point);
+
+	// the cap of an open contour, at its start (going along d) from the right side over to the left,
+	// or at its end from the left side over to the right
+	void add_start_cap(const GPoint& point, const GPoint& d);
+	void add_end_cap(const GPoint& point, const GPoint& d);
+
+	// add the points of the join at point, between the segments going along d0 and then d1,
+	// to the left (forward) and right (backward) sides
+	void add_join(const GPoint& point, const GPoint& d0, const GPoint& d1);
+
+	// add the points strictly between the ends of the arc around center that starts at
+	// center + from and turns by angle (radians, positive turns x toward y)
+	void add_arc(std::vector<GPoint>& points, const GPoint& center, const GPoint& from, float angle);
+
+	// end the outline started at first in m_points
+	void finish_outline(int first);
+
+	float m_radius;
+	float m_miter_limit;
+	GPaint::Join m_join;
+	GPaint::Cap m_cap;
+
+	// the most an arc can turn per chord
+	float m_arc_step;
+
+	// cuts up the contours of dashed strokes
+	Dasher m_dasher;
+
+	// the current contour without repeated points, and the direction of each of its segments
+	std::vector<GPoint> m_path;
+	std::vector<GPoint> m_directions;
+
+	// the right side of the current contour in forward order, it is added to the outline reversed
+	std::vector<GPoint> m_right;
+
+	// every outline point, and where each outline starts in it (pointers are only handed out
+	// once the stroke is done, since the points can move while they grow)
+	std::vector<GPoint> m_points;
+	std::vector<int> m_starts;
+	std::vector<GContour> m_contours;
+};
+
+#endif
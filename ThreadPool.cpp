@@ -0,0 +1,163 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(int thread_count)
+	: m_slices(thread_count < 1 ? 1 : thread_count)
+{
+	this->m_thread_count = (thread_count < 1 ? 1 : thread_count);
+	this->m_task = nullptr;
+	this->m_batch = 0;
+	this->m_busy = 0;
+	this->m_quit = false;
+	for (Slice& slice : this->m_slices)
+	{
+		slice.range.store(0);
+	}
+
+	// the calling thread is thread 0, so only start the rest
+	for (int i = 1; i < this->m_thread_count; ++i)
+	{
+		this->m_workers.push_back(std::thread(&ThreadPool::worker_loop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		this->m_quit = true;
+	}
+	this->m_start.notify_all();
+	for (std::thread& worker : this->m_workers)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::run(int count, const std::function<void(int, int)>& task)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	if (this->m_thread_count == 1)
+	{
+		// no one to share with
+		for (int i = 0; i < count; ++i)
+		{
+			task(i, 0);
+		}
+		return;
+	}
+
+	// hand every thread an even slice of the tasks
+	for (int i = 0; i < this->m_thread_count; ++i)
+	{
+		uint32_t begin = (uint32_t)((int64_t)count * i / this->m_thread_count);
+		uint32_t end = (uint32_t)((int64_t)count * (i + 1) / this->m_thread_count);
+		this->m_slices[i].range.store(ThreadPool::pack_slice(begin, end));
+	}
+
+	// wake the workers up
+	{
+		std::lock_guard<std::mutex> lock(this->m_mutex);
+		this->m_task = &task;
+		this->m_busy = this->m_thread_count - 1;
+		++this->m_batch;
+	}
+	this->m_start.notify_all();
+
+	// help out, then wait for everyone else to finish
+	this->do_tasks(0);
+	std::unique_lock<std::mutex> lock(this->m_mutex);
+	this->m_done.wait(lock, [this] { return this->m_busy == 0; });
+	this->m_task = nullptr;
+}
+
+void ThreadPool::worker_loop(int thread)
+{
+	int batch = 0;
+	while (true)
+	{
+		{
+			// sleep until there is a new batch (or we are shutting down)
+			std::unique_lock<std::mutex> lock(this->m_mutex);
+			this->m_start.wait(lock, [this, batch] { return this->m_quit == true || this->m_batch != batch; });
+			if (this->m_quit == true)
+			{
+				return;
+			}
+			batch = this->m_batch;
+		}
+
+		this->do_tasks(thread);
+
+		{
+			std::lock_guard<std::mutex> lock(this->m_mutex);
+			--this->m_busy;
+		}
+		this->m_done.notify_one();
+	}
+}
+
+void ThreadPool::do_tasks(int thread)
+{
+	// work through our own slice, then keep stealing until there is nothing left anywhere
+	while (true)
+	{
+		int index = this->take_task(thread);
+		if (index < 0)
+		{
+			index = this->steal_task(thread);
+			if (index < 0)
+			{
+				return;
+			}
+		}
+		(*this->m_task)(index, thread);
+	}
+}
+
+int ThreadPool::take_task(int thread)
+{
+	// take from the front of our slice
+	std::atomic<uint64_t>& range = this->m_slices[thread].range;
+	uint64_t slice = range.load();
+	while (ThreadPool::slice_begin(slice) < ThreadPool::slice_end(slice))
+	{
+		uint64_t taken = ThreadPool::pack_slice(ThreadPool::slice_begin(slice) + 1, ThreadPool::slice_end(slice));
+		if (range.compare_exchange_weak(slice, taken) == true)
+		{
+			return (int)ThreadPool::slice_begin(slice);
+		}
+	}
+	return -1;
+}
+
+int ThreadPool::steal_task(int thread)
+{
+	// look through the other threads for one that still has work
+	for (int i = 1; i < this->m_thread_count; ++i)
+	{
+		int victim = (thread + i) % this->m_thread_count;
+		std::atomic<uint64_t>& range = this->m_slices[victim].range;
+		uint64_t slice = range.load();
+		while (ThreadPool::slice_begin(slice) < ThreadPool::slice_end(slice))
+		{
+			// take the back half, the victim keeps the front
+			uint32_t begin = ThreadPool::slice_begin(slice);
+			uint32_t end = ThreadPool::slice_end(slice);
+			uint32_t middle = begin + (end - begin) / 2;
+			if (range.compare_exchange_weak(slice, ThreadPool::pack_slice(begin, middle)) == true)
+			{
+				// run the first of the stolen tasks and keep the rest as our own slice
+				// (our slice is empty, so no one else is touching it)
+				this->m_slices[thread].range.store(ThreadPool::pack_slice(middle + 1, end));
+				return (int)middle;
+			}
+		}
+	}
+	return -1;
+}
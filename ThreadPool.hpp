@@ -0,0 +1,65 @@
+// Copyright Daniel J. Steffey -- 2016
+
+#ifndef ThreadPool_hpp
+#define ThreadPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a fixed set of threads that split up batches of independent tasks
+// each thread starts with its own slice of the task indices and when it runs out it
+// steals half of what is left in another thread's slice, so uneven tasks still balance
+class ThreadPool
+{
+public:
+	// thread_count includes the calling thread, so 1 means everything runs inline
+	ThreadPool(int thread_count);
+	~ThreadPool();
+
+	int thread_count() const { return this->m_thread_count; }
+
+	// call task(index, thread) for every index in [0, count) and wait for all of them
+	// thread is in [0, thread_count) and no two tasks run on the same thread at once
+	void run(int count, const std::function<void(int, int)>& task);
+
+private:
+	// a slice of task indices [begin, end) packed into one word so it can be
+	// taken from the front by its owner and stolen from the back with one compare and swap
+	static uint64_t pack_slice(uint32_t begin, uint32_t end) { return ((uint64_t)begin << 32) | end; }
+	static uint32_t slice_begin(uint64_t slice) { return (uint32_t)(slice >> 32); }
+	static uint32_t slice_end(uint64_t slice) { return (uint32_t)slice; }
+
+	void worker_loop(int thread);
+	void do_tasks(int thread);
+	int take_task(int thread);
+	int steal_task(int thread);
+
+	int m_thread_count;
+	std::vector<std::thread> m_workers;
+
+	// one slice per thread, padded out so they do not share a cache line
+	struct Slice
+	{
+		std::atomic<uint64_t> range;
+		char padding[64 - sizeof(std::atomic<uint64_t>)];
+	};
+	std::vector<Slice> m_slices;
+
+	// the batch being run
+	const std::function<void(int, int)>* m_task;
+
+	// wakes the workers up for a batch and tells run() when they are all done
+	std::mutex m_mutex;
+	std::condition_variable m_start;
+	std::condition_variable m_done;
+	int m_batch;
+	int m_busy;
+	bool m_quit;
+};
+
+#endif
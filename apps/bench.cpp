@@ -6,7 +6,10 @@
 #include "GCanvas.h"
 #include "GBitmap.h"
 #include "GTime.h"
+#include <atomic>
+#include <cstdlib>
 #include <memory>
+#include <new>
 #include <string>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -72,6 +75,32 @@ static double compare(const GBitmap& a, const GBitmap& b, int tolerance, bool ve
 
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
+// every heap allocation in the process goes through here, so --allocs can report how many
+// a draw makes once it has warmed up
+static std::atomic<long> gAllocCount(0);
+
+void* operator new(size_t size) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
 static void setup_bitmap(GBitmap* bitmap, int w, int h) {
     bitmap->fWidth = w;
     bitmap->fHeight = h;
@@ -85,11 +114,13 @@ static GPixel* get_addr(const GBitmap& bm, int x, int y) {
     return bm.pixels() + x + y * (bm.rowBytes() >> 2);
 }
 
-static double handle_proc(GBenchmark* bench, const char path[], GBitmap* bitmap, bool forever) {
+static double handle_proc(GBenchmark* bench, const char path[], GBitmap* bitmap, bool forever,
+                          int threads, double* allocsPerDraw) {
     GISize size = bench->size();
     setup_bitmap(bitmap, size.fWidth, size.fHeight);
 
-    std::unique_ptr<GCanvas> canvas(GCanvas::Create(*bitmap));
+    std::unique_ptr<GCanvas> canvas(threads > 0 ? GCanvas::CreateTiled(*bitmap, threads)
+                                                : GCanvas::Create(*bitmap));
     if (!canvas) {
         fprintf(stderr, "failed to create canvas for [%d %d] %s\n",
                 size.fWidth, size.fHeight, bench->name());
@@ -97,13 +128,20 @@ static double handle_proc(GBenchmark* bench, const char path[], GBitmap* bitmap,
     }
 
     const int N = 100;
+    long allocs = 0;
     GMSec now = GTime::GetMSec();
     for (int i = 0; i < N || forever; ++i) {
+        if (i == 1) {
+            // the first draw is allowed to grow the canvas's buffers
+            allocs = gAllocCount.load();
+        }
         canvas->save();
         bench->draw(canvas.get());
         canvas->restore();
+        canvas->flush();
     }
     GMSec dur = GTime::GetMSec() - now;
+    *allocsPerDraw = (gAllocCount.load() - allocs) * 1.0 / (N - 1);
     return dur * 1.0 / N;
 }
 
@@ -128,6 +166,8 @@ int main(int argc, char** argv) {
     const char* report = NULL;
     const char* author = NULL;
     const char* write_dir = nullptr;
+    int threads = 0;
+    bool allocs = false;
     FILE* reportFile = NULL;
 
     for (int i = 1; i < argc; ++i) {
@@ -147,6 +187,10 @@ int main(int argc, char** argv) {
             forever = true;
         } else if (is_arg(argv[i], "write") && i+1 < argc) {
             write_dir = argv[++i];
+        } else if (is_arg(argv[i], "threads") && i+1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (is_arg(argv[i], "allocs")) {
+            allocs = true;
         }
     }
 
@@ -162,8 +206,13 @@ int main(int argc, char** argv) {
         }
         
         GBitmap testBM;
-        double dur = handle_proc(bench.get(), name, &testBM, forever);
-        printf("bench: %s %g\n", name, dur);
+        double allocsPerDraw = 0;
+        double dur = handle_proc(bench.get(), name, &testBM, forever, threads, &allocsPerDraw);
+        if (allocs) {
+            printf("bench: %s %g allocs/draw %g\n", name, dur, allocsPerDraw);
+        } else {
+            printf("bench: %s %g\n", name, dur);
+        }
 
         if (write_dir) {
             std::string path(write_dir);
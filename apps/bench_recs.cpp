@@ -9,7 +9,12 @@
 #include "GShader.h"
 #include "GRandom.h"
 #include "GRect.h"
+#include "GMatrix.h"
+#include "GPath.h"
+#include "../GCanvasRecording.hpp"
+#include <memory>
 #include <string>
+#include <vector>
 
 static GColor rand_color(GRandom& rand, bool forceOpaque = false) {
     GColor c { rand.nextF(), rand.nextF(), rand.nextF(), rand.nextF() };
@@ -105,6 +110,109 @@ public:
     }
 };
 
+// spock at its own size in random spots, which only ever moves the bitmap
+class TranslatedBitmapBench : public GBenchmark {
+    GBitmap fBitmap;
+    enum {
+        W = 256,
+        H = 256,
+    };
+public:
+    TranslatedBitmapBench() {
+        fBitmap.readFromFile("apps/spock.png");
+    }
+
+    const char* name() const override { return "spock_translate"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        const int N = 100;
+        GRandom rand;
+        for (int i = 0; i < N; ++i) {
+            float x = (float)rand.nextRange(-fBitmap.width(), W);
+            float y = (float)rand.nextRange(-fBitmap.height(), H);
+            canvas->fillBitmapRect(fBitmap, GRect::MakeXYWH(x, y, fBitmap.width(), fBitmap.height()));
+        }
+    }
+};
+
+// the same random rects as SpockBitmap, but drawn through a filtered bitmap shader
+class FilteredBitmapBench : public GBenchmark {
+    GBitmap fBitmap;
+    std::unique_ptr<GShader> fShader;
+    const char* fName;
+    enum {
+        W = 256,
+        H = 256,
+    };
+public:
+    FilteredBitmapBench(GShader::FilterQuality filter, const char* name) : fName(name) {
+        fBitmap.readFromFile("apps/spock.png");
+        fShader.reset(GShader::FromBitmap(fBitmap, GMatrix(), GShader::kClamp, filter));
+    }
+
+    const char* name() const override { return fName; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        const int N = 100;
+        const GRect bounds = GRect::MakeLTRB(-10, -10, W + 10, H + 10);
+        GRandom rand;
+        GPaint paint(fShader.get());
+        for (int i = 0; i < N; ++i) {
+            GRect rect = rand_rect(rand, bounds);
+            canvas->save();
+            canvas->translate(rect.left(), rect.top());
+            canvas->scale(rect.width() / fBitmap.width(), rect.height() / fBitmap.height());
+            canvas->drawRect(GRect::MakeWH(fBitmap.width(), fBitmap.height()), paint);
+            canvas->restore();
+        }
+    }
+};
+
+// a photo sized bitmap (spock blown up to 2048x2048) shrunk 32x into a grid of thumbnails,
+// where the mip levels keep the filter from striding all over the big bitmap
+class MinifiedBitmapBench : public GBenchmark {
+    GBitmap fBitmap;
+    std::unique_ptr<GShader> fShader;
+    enum {
+        W = 256,
+        H = 256,
+        TILE = 64,
+        BIG = 2048,
+    };
+public:
+    MinifiedBitmapBench() {
+        GBitmap spock;
+        spock.readFromFile("apps/spock.png");
+        fBitmap.fWidth = BIG;
+        fBitmap.fHeight = BIG;
+        fBitmap.fRowBytes = BIG * sizeof(GPixel);
+        fBitmap.fPixels = (GPixel*)calloc(BIG, fBitmap.fRowBytes);
+        std::unique_ptr<GCanvas> big(GCanvas::Create(fBitmap));
+        big->fillBitmapRect(spock, GRect::MakeWH(BIG, BIG));
+        free(spock.fPixels);
+        fShader.reset(GShader::FromBitmap(fBitmap, GMatrix(), GShader::kClamp, GShader::kTrilinear));
+    }
+    ~MinifiedBitmapBench() override {
+        fShader.reset();
+        free(fBitmap.fPixels);
+    }
+
+    const char* name() const override { return "spock_minified"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint(fShader.get());
+        for (int y = 0; y < H; y += TILE) {
+            for (int x = 0; x < W; x += TILE) {
+                canvas->save();
+                canvas->translate(x, y);
+                canvas->scale((float)TILE / fBitmap.width(), (float)TILE / fBitmap.height());
+                canvas->drawRect(GRect::MakeWH(fBitmap.width(), fBitmap.height()), paint);
+                canvas->restore();
+            }
+        }
+    }
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
 static void to_quad(const GRect& r, GPoint quad[4]) {
@@ -191,6 +299,233 @@ public:
     }
 };
 
+// a gradient shader filling the whole canvas, over and over
+class GradientShaderBench : public GBenchmark {
+    enum { W = 256, H = 256 };
+    std::unique_ptr<GShader> fShader;
+    const char* fName;
+public:
+    GradientShaderBench(GShader* shader, const char* name) : fShader(shader), fName(name) {}
+
+    const char* name() const override { return fName; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint(fShader.get());
+        for (int i = 0; i < 10; ++i) {
+            canvas->drawRect(GRect::MakeWH(256, 256), paint);
+        }
+    }
+};
+
+static const GColor gGradientBenchColors[] = {
+    { 1, 1, 0, 0 }, { 1, 0, 1, 0 }, { 1, 0, 0, 1 }, { 1, 1, 1, 0 },
+};
+
+// a jittered grid of indexed triangles with a color at every vertex, optionally textured
+class MeshBench : public GBenchmark {
+    enum { W = 256, H = 256, N = 24 };
+    std::vector<GPoint> fPts;
+    std::vector<GPoint> fTex;
+    std::vector<GColor> fColors;
+    std::vector<int> fIndices;
+    GBitmap fBitmap;
+    std::unique_ptr<GShader> fShader;
+    const char* fName;
+public:
+    MeshBench(bool textured, const char* name) : fName(name) {
+        fBitmap.readFromFile("apps/spock.png");
+        if (textured) {
+            fShader.reset(GShader::FromBitmap(fBitmap, GMatrix()));
+        }
+        GRandom rand;
+        for (int y = 0; y <= N; ++y) {
+            for (int x = 0; x <= N; ++x) {
+                float jx = (x > 0 && x < N) ? rand.nextF() * 4 - 2 : 0;
+                float jy = (y > 0 && y < N) ? rand.nextF() * 4 - 2 : 0;
+                fPts.push_back(GPoint::Make(x * (float)W / N + jx, y * (float)H / N + jy));
+                fTex.push_back(GPoint::Make(x * (float)fBitmap.width() / N, y * (float)fBitmap.height() / N));
+                fColors.push_back(rand_color(rand, true));
+            }
+        }
+        for (int y = 0; y < N; ++y) {
+            for (int x = 0; x < N; ++x) {
+                int i = y * (N + 1) + x;
+                const int quad[] = { i, i + 1, i + N + 2, i, i + N + 2, i + N + 1 };
+                fIndices.insert(fIndices.end(), quad, quad + 6);
+            }
+        }
+    }
+
+    const char* name() const override { return fName; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint(fShader.get());
+        for (int i = 0; i < 4; ++i) {
+            canvas->drawMesh(N * N * 2, fPts.data(), fIndices.data(), fColors.data(),
+                             fShader ? fTex.data() : nullptr, paint);
+        }
+    }
+};
+
+// the same patch drawn with its corners moving a little each time, like an animation
+class QuadPatchBench : public GBenchmark {
+    enum { W = 256, H = 256 };
+public:
+    const char* name() const override { return "quad_patch"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        const GColor colors[] = {
+            GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0),
+            GColor::MakeARGB(1, 0, 0, 1), GColor::MakeARGB(1, 1, 1, 0),
+        };
+        for (int i = 0; i < 8; ++i) {
+            const GPoint pts[] = {
+                { 10.f + i, 10 }, { 246, 20.f + i }, { 240.f - i, 246 }, { 16, 230.f - i },
+            };
+            canvas->drawQuadPatch(pts, colors, 16);
+        }
+    }
+};
+
+// draws clipped to a stack of a rect and a path, rebuilt every time through
+class ClipBench : public GBenchmark {
+    enum { W = 256, H = 256 };
+public:
+    const char* name() const override { return "clip_path"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GRandom rand;
+        for (int i = 0; i < 4; ++i) {
+            canvas->save();
+            canvas->clipRect(GRect::MakeLTRB(8.f + i, 8, 248, 248.f - i));
+            GPath path;
+            path.moveTo(128, 4.f + i).lineTo(250, 128).lineTo(128, 252).lineTo(6, 128)
+                .moveTo(128, 60).lineTo(60, 128).lineTo(128, 196).lineTo(196, 128);
+            canvas->clipPath(path);
+            for (int j = 0; j < 16; ++j) {
+                GRect r = GRect::MakeXYWH(rand.nextF() * 200, rand.nextF() * 200, 60, 60);
+                canvas->fillRect(r, rand_color(rand, true));
+            }
+            canvas->restore();
+        }
+    }
+};
+
+// thick translucent polylines with a sharp join at every point
+class StrokeBench : public GBenchmark {
+    enum { W = 256, H = 256, N = 200 };
+    std::vector<GPoint> fPts;
+    bool fRound;
+public:
+    StrokeBench(bool round) : fRound(round) {
+        GRandom rand;
+        for (int i = 0; i < N; ++i) {
+            fPts.push_back(GPoint::Make(rand.nextF() * W, rand.nextF() * H));
+        }
+    }
+    const char* name() const override { return fRound ? "stroke_round" : "stroke_polyline"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint(GColor::MakeARGB(0.5f, 0, 0, 1));
+        paint.setStrokeWidth(fRound ? 9 : 3);
+        if (fRound) {
+            paint.setStrokeJoin(GPaint::Join::kRound);
+            paint.setStrokeCap(GPaint::Cap::kRound);
+        }
+        for (int i = 0; i < N; i += 20) {
+            GContour contour = { 20, fPts.data() + i, false };
+            canvas->drawContours(&contour, 1, paint);
+        }
+    }
+};
+
+// a grid of small circles, as 4 cubics flattened for the ctm or as the 256 sided polygons
+// a path would otherwise have to be stored as to stay smooth when zoomed in
+class CircleBench : public GBenchmark {
+    enum { W = 256, H = 256, STEP = 16, SIDES = 256 };
+    bool fCurves;
+    GPath fPath;
+    GPoint fPolygon[SIDES];
+public:
+    CircleBench(bool curves) : fCurves(curves) {
+        const float k = 0.5522847f * 100;
+        fPath.moveTo(100, 0).cubicTo(100, k, k, 100, 0, 100).cubicTo(-k, 100, -100, k, -100, 0)
+             .cubicTo(-100, -k, -k, -100, 0, -100).cubicTo(k, -100, 100, -k, 100, 0);
+        for (int i = 0; i < SIDES; ++i) {
+            fPolygon[i] = { 100 * cosf(i * 6.2831853f / SIDES), 100 * sinf(i * 6.2831853f / SIDES) };
+        }
+    }
+    const char* name() const override { return fCurves ? "circles_path" : "circles_polygon"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint(GColor::MakeARGB(1, 0, 0.5f, 1));
+        GContour contour = { SIDES, fPolygon, true };
+        for (int y = 0; y < H; y += STEP) {
+            for (int x = 0; x < W; x += STEP) {
+                canvas->save();
+                canvas->translate(x + STEP * 0.5f, y + STEP * 0.5f);
+                canvas->scale(0.06f, 0.06f);
+                if (fCurves) {
+                    canvas->drawPath(fPath, paint);
+                } else {
+                    canvas->drawContours(&contour, 1, paint);
+                }
+                canvas->restore();
+            }
+        }
+    }
+};
+
+// a dashed grid, with thick dashes across and hairline dashes down
+class DashBench : public GBenchmark {
+    enum { W = 256, H = 256, STEP = 8 };
+public:
+    const char* name() const override { return "dash_grid"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint(GColor::MakeARGB(1, 0.5f, 0.5f, 0.5f));
+        const float intervals[] = { 3, 2 };
+        paint.setDash(intervals, 2, 0);
+        for (int i = 0; i < W; i += STEP) {
+            const GPoint across[] = { { 0, i + 0.5f }, { (float)W, i + 0.5f } };
+            const GPoint down[] = { { i + 0.5f, 0 }, { i + 0.5f, (float)H } };
+            GContour contour = { 2, across, false };
+            paint.setStrokeWidth(2);
+            canvas->drawContours(&contour, 1, paint);
+            contour.fPts = down;
+            paint.setStrokeWidth(1);
+            canvas->drawContours(&contour, 1, paint);
+        }
+    }
+};
+
+// a chart's worth of 1 pixel polylines
+class HairlineBench : public GBenchmark {
+    enum { W = 256, H = 256, N = 64, LINES = 16 };
+    std::vector<GPoint> fPts;
+    bool fAntiAlias;
+public:
+    HairlineBench(bool aa) : fAntiAlias(aa) {
+        GRandom rand;
+        for (int line = 0; line < LINES; ++line) {
+            for (int i = 0; i < N; ++i) {
+                fPts.push_back(GPoint::Make(i * (float)W / (N - 1), rand.nextF() * H));
+            }
+        }
+    }
+    const char* name() const override { return fAntiAlias ? "hairlines_aa" : "hairlines"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint(GColor::MakeARGB(1, 0, 0, 0));
+        paint.setStrokeWidth(1);
+        paint.setAntiAlias(fAntiAlias);
+        for (int line = 0; line < LINES; ++line) {
+            GContour contour = { N, fPts.data() + line * N, false };
+            canvas->drawContours(&contour, 1, paint);
+        }
+    }
+};
+
 static void make_star(GPoint pts[], int count, float anglePhase) {
     GASSERT(count & 1);
     float da = 2 * M_PI * (count >> 1) / count;
@@ -226,6 +561,67 @@ public:
     }
 };
 
+class StarFieldBench : public GBenchmark {
+    enum { W = 256, H = 256 };
+    enum { N = 99, STARS = 200 };
+    GPoint fPts[STARS * N];
+    GContour fCtrs[STARS];
+public:
+    StarFieldBench() {
+        GRandom rand;
+        for (int i = 0; i < STARS; ++i) {
+            GPoint* pts = &fPts[i * N];
+            make_star(pts, N, rand.nextF() * M_PI);
+            const float rad = 10 + rand.nextF() * 40;
+            const float cx = rand.nextF() * W;
+            const float cy = rand.nextF() * H;
+            for (int j = 0; j < N; ++j) {
+                pts[j].set(pts[j].fX * rad + cx, pts[j].fY * rad + cy);
+            }
+            fCtrs[i] = { N, pts, true };
+        }
+    }
+
+    const char* name() const override {
+        return "star_field";
+    }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        GPaint paint;
+        paint.setARGB(1, 0.5f, 0, 0);
+        canvas->drawContours(fCtrs, STARS, paint);
+    }
+};
+
+static void draw_tiger(GCanvas* canvas) {
+    canvas->save();
+    canvas->scale(0.5f, 0.5f);
+    #include "tiger.inc"
+    canvas->restore();
+}
+
+class TigerBench : public GBenchmark {
+    enum { W = 500, H = 500 };
+    const bool fRecorded;
+    GCanvasRecording fRecording;
+public:
+    TigerBench(bool recorded) : fRecorded(recorded) {
+        if (fRecorded) {
+            draw_tiger(&fRecording);
+        }
+    }
+
+    const char* name() const override { return fRecorded ? "tiger_playback" : "tiger"; }
+    GISize size() const override { return { W, H }; }
+    void draw(GCanvas* canvas) override {
+        if (fRecorded) {
+            fRecording.playback(canvas);
+        } else {
+            draw_tiger(canvas);
+        }
+    }
+};
+
 const GBenchmark::Factory gBenchFactories[] {
     []() -> GBenchmark* { return new RectsBench(false); },
     []() -> GBenchmark* { return new RectsBench(true);  },
@@ -238,6 +634,10 @@ const GBenchmark::Factory gBenchFactories[] {
 
     []() -> GBenchmark* { return new SpockBitmap(false, "spock_opaque"); },
     []() -> GBenchmark* { return new SpockBitmap(true, "spock_alpha"); },
+    []() -> GBenchmark* { return new TranslatedBitmapBench; },
+    []() -> GBenchmark* { return new FilteredBitmapBench(GShader::kBilinear, "spock_bilinear"); },
+    []() -> GBenchmark* { return new FilteredBitmapBench(GShader::kBicubic, "spock_bicubic"); },
+    []() -> GBenchmark* { return new MinifiedBitmapBench; },
 
     []() -> GBenchmark* { return new PolyRectsBench(false); },
     []() -> GBenchmark* { return new PolyRectsBench(true);  },
@@ -246,7 +646,39 @@ const GBenchmark::Factory gBenchFactories[] {
 
     []() -> GBenchmark* { return new GradientBench(1);      },
     []() -> GBenchmark* { return new GradientBench(0.5);    },
+    []() -> GBenchmark* {
+        return new GradientShaderBench(GShader::RadialGradient({ 100, 120 }, 90, gGradientBenchColors, 4),
+                                       "radial_clamp");
+    },
+    []() -> GBenchmark* {
+        return new GradientShaderBench(GShader::RadialGradient({ 100, 120 }, 90, gGradientBenchColors, 4,
+                                                               GShader::kMirror), "radial_mirror");
+    },
+    []() -> GBenchmark* {
+        return new GradientShaderBench(GShader::SweepGradient({ 128, 128 }, gGradientBenchColors, nullptr, 4),
+                                       "sweep_gradient");
+    },
+    []() -> GBenchmark* {
+        return new GradientShaderBench(GShader::TwoPointConicalGradient({ 80, 90 }, 10, { 140, 150 }, 120,
+                                                                        gGradientBenchColors, nullptr, 4),
+                                       "conical_gradient");
+    },
+    []() -> GBenchmark* { return new MeshBench(false, "mesh_colors"); },
+    []() -> GBenchmark* { return new MeshBench(true, "mesh_textured"); },
+    []() -> GBenchmark* { return new QuadPatchBench; },
+    []() -> GBenchmark* { return new ClipBench; },
+    []() -> GBenchmark* { return new StrokeBench(false); },
+    []() -> GBenchmark* { return new StrokeBench(true); },
+    []() -> GBenchmark* { return new DashBench; },
+    []() -> GBenchmark* { return new CircleBench(true); },
+    []() -> GBenchmark* { return new CircleBench(false); },
+    []() -> GBenchmark* { return new HairlineBench(false); },
+    []() -> GBenchmark* { return new HairlineBench(true); },
+
     []() -> GBenchmark* { return new StarBench;    },
+    []() -> GBenchmark* { return new StarFieldBench;    },
+    []() -> GBenchmark* { return new TigerBench(false); },
+    []() -> GBenchmark* { return new TigerBench(true);  },
 
     nullptr,
 };
@@ -8,8 +8,21 @@
 #include "GMatrix.h"
 #include "GPath.h"
 #include "GPoint.h"
+#include "GRandom.h"
 #include "GRect.h"
 #include "tests.h"
+#include "GShader.h"
+#include "../Arena.hpp"
+#include "../BlendProcs.hpp"
+#include "../GCanvasRecording.hpp"
+#include "../Mipmap.hpp"
+#include "../Dasher.hpp"
+#include "../PolygonEdge.hpp"
+#include "../QuadPatch.hpp"
+#include "../Stroker.hpp"
+#include "../GShaderBitmapSteffey.hpp"
+#include <atomic>
+#include <memory>
 
 static void setup_bitmap(GBitmap* bitmap, int w, int h) {
     bitmap->fWidth = w;
@@ -384,6 +397,1667 @@ static void test_matrix(GTestStats* stats) {
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 
+static void test_blend_modes(GTestStats* stats) {
+    GSurface surface(4, 4);
+    GCanvas* canvas = surface.canvas();
+
+    // dst is half-transparent red, src is opaque blue or half-transparent blue
+    const GColor dst = GColor::MakeARGB(0.5f, 1, 0, 0);
+    const GColor opaque_src = GColor::MakeARGB(1, 0, 0, 1);
+    const GColor half_src = GColor::MakeARGB(0.5f, 0, 0, 1);
+
+    const struct {
+        GBlendMode  fMode;
+        GColor      fSrc;
+        GPixel      fExpected;
+        const char* fMsg;
+    } recs[] = {
+        { GBlendMode::kClear,    opaque_src, 0,                                     "blend_clear" },
+        { GBlendMode::kSrc,      half_src,   GPixel_PackARGB(0x80, 0, 0, 0x80),     "blend_src" },
+        { GBlendMode::kDst,      opaque_src, GPixel_PackARGB(0x80, 0x80, 0, 0),     "blend_dst" },
+        { GBlendMode::kSrcOver,  half_src,   GPixel_PackARGB(0xC0, 0x40, 0, 0x80),  "blend_srcover" },
+        { GBlendMode::kDstOver,  half_src,   GPixel_PackARGB(0xC0, 0x80, 0, 0x40),  "blend_dstover" },
+        { GBlendMode::kSrcIn,    opaque_src, GPixel_PackARGB(0x80, 0, 0, 0x80),     "blend_srcin" },
+        { GBlendMode::kDstIn,    half_src,   GPixel_PackARGB(0x40, 0x40, 0, 0),     "blend_dstin" },
+        { GBlendMode::kDstOut,   opaque_src, 0,                                     "blend_dstout" },
+        { GBlendMode::kXor,      opaque_src, GPixel_PackARGB(0x7F, 0, 0, 0x7F),     "blend_xor" },
+        { GBlendMode::kPlus,     half_src,   GPixel_PackARGB(0xFF, 0x80, 0, 0x80),  "blend_plus" },
+        { GBlendMode::kMultiply, opaque_src, GPixel_PackARGB(0xFF, 0, 0, 0x7F),     "blend_multiply" },
+        { GBlendMode::kScreen,   opaque_src, GPixel_PackARGB(0xFF, 0x80, 0, 0xFF),  "blend_screen" },
+    };
+    for (int i = 0; i < GARRAY_COUNT(recs); ++i) {
+        canvas->clear(dst);
+        GPaint paint(recs[i].fSrc);
+        paint.setBlendMode(recs[i].fMode);
+        canvas->drawRect(GRect::MakeWH(4, 4), paint);
+        stats->expectTrue(is_filled_with(surface.bitmap(), recs[i].fExpected), recs[i].fMsg);
+    }
+}
+
+static void test_srcover_kernels(GTestStats* stats) {
+    BlendProcs procs[3];
+    int proc_count = get_all_srcover_blend_procs(procs);
+
+    // premultiplied sources with every alpha, over random dests, in rows of every length up to
+    // a few of the widest kernel's blocks and starting off of any alignment, so the tails and the
+    // opaque and transparent shortcuts all get hit
+    GRandom rand;
+    const int MAX = 40;
+    GPixel source[MAX + 3];
+    GPixel dest[MAX + 3];
+    GPixel expected[MAX + 3];
+    GPixel actual[MAX + 3];
+    bool color_rows = true;
+    bool rows = true;
+    for (int alpha = 0; alpha <= 255; ++alpha) {
+        for (int i = 0; i < MAX + 3; ++i) {
+            // mostly this alpha, with some opaque and transparent pixels mixed in
+            int a = alpha;
+            int pick = rand.nextRange(0, 7);
+            a = (pick == 0 ? 0 : pick == 1 ? 255 : a);
+            source[i] = GPixel_PackARGB(a, rand.nextRange(0, a), rand.nextRange(0, a), rand.nextRange(0, a));
+            int da = rand.nextRange(0, 255);
+            dest[i] = GPixel_PackARGB(da, rand.nextRange(0, da), rand.nextRange(0, da), rand.nextRange(0, da));
+        }
+        GPixel color = GPixel_PackARGB(alpha, alpha / 3, alpha / 2, alpha);
+        for (int count = 1; count <= MAX; ++count) {
+            int offset = count % 4;
+            memcpy(expected, dest, sizeof(dest));
+            procs[0].color_row(color, expected + offset, count);
+            for (int p = 1; p < proc_count; ++p) {
+                memcpy(actual, dest, sizeof(dest));
+                procs[p].color_row(color, actual + offset, count);
+                color_rows &= !memcmp(expected, actual, sizeof(actual));
+            }
+
+            memcpy(expected, dest, sizeof(dest));
+            procs[0].row(source + offset, expected + offset, count);
+            for (int p = 1; p < proc_count; ++p) {
+                memcpy(actual, dest, sizeof(dest));
+                procs[p].row(source + offset, actual + offset, count);
+                rows &= !memcmp(expected, actual, sizeof(actual));
+            }
+        }
+    }
+    stats->expectTrue(color_rows, "srcover_simd_color_rows");
+    stats->expectTrue(rows, "srcover_simd_rows");
+}
+
+static void test_antialias(GTestStats* stats) {
+    GSurface surface(4, 4);
+    GCanvas* canvas = surface.canvas();
+    const GBitmap& bitmap = surface.bitmap();
+
+    // a rect whose left and right edges fall halfway through pixel columns 0 and 3
+    canvas->clear(GColor::MakeARGB(0, 0, 0, 0));
+    GPaint paint(GColor::MakeARGB(1, 1, 1, 1));
+    paint.setAntiAlias(true);
+    canvas->drawRect(GRect::MakeLTRB(0.5f, 0, 3.5f, 4), paint);
+
+    const GPixel half = GPixel_PackARGB(0x80, 0x80, 0x80, 0x80);
+    const GPixel full = GPixel_PackARGB(0xFF, 0xFF, 0xFF, 0xFF);
+    stats->expectEQ(*bitmap.getAddr(0, 1), half, "antialias_left");
+    stats->expectEQ(*bitmap.getAddr(1, 1), full, "antialias_inside");
+    stats->expectEQ(*bitmap.getAddr(3, 1), half, "antialias_right");
+
+    // the same rect without anti-aliasing only touches whole pixels
+    canvas->clear(GColor::MakeARGB(0, 0, 0, 0));
+    paint.setAntiAlias(false);
+    canvas->drawRect(GRect::MakeLTRB(0.5f, 0, 3.5f, 4), paint);
+    stats->expectTrue(*bitmap.getAddr(0, 1) == 0 || *bitmap.getAddr(0, 1) == full, "aliased_left");
+}
+
+// walk random edges between whole pixel points, the only ones a whole number matrix gives, down
+// every row in float and in 16.16, and count the rows where the two land on different pixels
+static int walk_fixed_point_edges(int size, bool* bounded, bool* near_centers, int* rows) {
+    GRandom rand;
+    int differing = 0;
+    for (int i = 0; i < 100; ++i) {
+        int x0 = rand.nextRange(0, size - 1);
+        int x1 = rand.nextRange(0, size - 1);
+        int y0 = rand.nextRange(0, size / 4);
+        int height = rand.nextRange(1, size - 1 - y0);
+        float slope = (float)(x1 - x0) / height;
+        PolygonEdge float_edge(y0, y0 + height, slope, 0.5f * slope + x0, 1);
+        PolygonEdge fixed_edge = float_edge;
+        fixed_edge.use_fixed_point();
+        *bounded &= fixed_edge.is_fixed;
+
+        double exact_slope = (double)(x1 - x0) / height;
+        for (int row = 0; row < height; ++row) {
+            double exact = x0 + (row + 0.5) * exact_slope;
+            double fixed_error = fabs(fixed_edge.current_x() - exact);
+            double float_error = fabs(float_edge.current_x() - exact);
+            *bounded &= fixed_error <= 1.0 / 8;
+
+            // either one only rounds away from the exact pixel when the exact x is about as
+            // close to the line between two pixels as it drifted
+            double to_center = fabs(exact - floor(exact) - 0.5);
+            if (fixed_edge.current_pixel() != (int)floor(exact + 0.5)) {
+                *near_centers &= to_center <= fixed_error;
+            }
+            if (fixed_edge.current_pixel() != float_edge.current_pixel()) {
+                *near_centers &= to_center <= std::max(fixed_error, float_error);
+                ++differing;
+            }
+            ++*rows;
+            fixed_edge.step();
+            float_edge.step();
+        }
+    }
+    return differing;
+}
+
+static void test_fixed_point_edges(GTestStats* stats) {
+    // over the tallest canvas that steps in 16.16, the slope's rounding adds up to at most 1/8
+    // of a pixel (float adds up its own rounding too, and drifts much further there)
+    bool bounded = true;
+    bool near_centers = true;
+    int rows = 0;
+    walk_fixed_point_edges(16384, &bounded, &near_centers, &rows);
+    stats->expectTrue(bounded && near_centers, "fixed_point_bound");
+
+    // on an ordinary canvas the two pick different pixels on well under 1% of the rows
+    rows = 0;
+    int differing = walk_fixed_point_edges(1024, &bounded, &near_centers, &rows);
+    stats->expectTrue(bounded && near_centers && differing * 100 < rows, "fixed_point_like_float");
+}
+
+static void draw_tiled_scene(GCanvas* canvas) {
+    canvas->clear(GColor::MakeARGB(1, 1, 1, 1));
+
+    // alpha rects, one with a blend mode, crossing tile boundaries
+    canvas->fillRect(GRect::MakeLTRB(10, 10, 140, 60), GColor::MakeARGB(0.5f, 1, 0, 0));
+    GPaint mode_paint(GColor::MakeARGB(0.75f, 0, 0, 1));
+    mode_paint.setBlendMode(GBlendMode::kMultiply);
+    canvas->drawRect(GRect::MakeLTRB(50, 30, 200, 120), mode_paint);
+
+    // one shader used with two different matrices, so its context changes mid recording
+    GShader* shader = GShader::LinearGradient({0, 0}, {100, 0}, GColor::MakeARGB(1, 1, 0, 0),
+                                              GColor::MakeARGB(0.5f, 0, 1, 0));
+    GPaint shader_paint(shader);
+    canvas->drawRect(GRect::MakeLTRB(0, 70, 300, 100), shader_paint);
+    canvas->save();
+    canvas->translate(30, 40);
+    canvas->rotate(0.3f);
+    canvas->drawRect(GRect::MakeLTRB(0, 70, 300, 100), shader_paint);
+    canvas->restore();
+
+    // anti-aliased and aliased contours
+    const GPoint star[] = {
+        { 150, 20 }, { 170, 120 }, { 100, 50 }, { 200, 50 }, { 130, 120 },
+    };
+    GContour ctr = { 5, star, true };
+    GPaint aa_paint(GColor::MakeARGB(0.6f, 0, 0.5f, 0));
+    aa_paint.setAntiAlias(true);
+    canvas->drawContours(&ctr, 1, aa_paint);
+    canvas->translate(-60, 70);
+    canvas->drawContours(&ctr, 1, GPaint(GColor::MakeARGB(1, 0.2f, 0.2f, 0.2f)));
+
+    // a colored mesh and a stroke
+    const GPoint tri[] = { { 70, 60 }, { 240, 90 }, { 90, 110 } };
+    const GColor colors[] = {
+        GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0), GColor::MakeARGB(0.5f, 0, 0, 1),
+    };
+    canvas->drawMesh(1, tri, nullptr, colors, nullptr, GPaint());
+    const GPoint patch[] = { { 150, 100 }, { 220, 90 }, { 210, 150 }, { 140, 160 } };
+    const GColor patch_colors[] = {
+        GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0),
+        GColor::MakeARGB(1, 0, 0, 1), GColor::MakeARGB(0.5f, 1, 1, 0),
+    };
+    canvas->drawQuadPatch(patch, patch_colors, 5);
+    GPaint stroke(GColor::MakeARGB(1, 0, 0, 0));
+    stroke.setStrokeWidth(3);
+    canvas->drawContours(&ctr, 1, stroke);
+    GPaint round_stroke(GColor::MakeARGB(0.5f, 0, 0.5f, 1));
+    round_stroke.setStrokeWidth(9);
+    round_stroke.setStrokeJoin(GPaint::Join::kRound);
+    round_stroke.setStrokeCap(GPaint::Cap::kRound);
+    round_stroke.setAntiAlias(true);
+    const GPoint wave[] = { { 10, 140 }, { 60, 100 }, { 110, 150 }, { 160, 90 } };
+    GContour wave_ctr = { 4, wave, false };
+    canvas->drawContours(&wave_ctr, 1, round_stroke);
+    const float dash_intervals[] = { 12, 6, 0, 6 };
+    round_stroke.setDash(dash_intervals, 4, 3);
+    canvas->translate(0, 20);
+    canvas->drawContours(&wave_ctr, 1, round_stroke);
+    canvas->translate(0, -20);
+
+    // curves, filled and stroked, flattened once for every tile
+    GPath blob;
+    blob.moveTo(120, 60).cubicTo(200, 20, 240, 120, 170, 150).quadTo(90, 180, 120, 60);
+    GPaint blob_paint(GColor::MakeARGB(0.6f, 1, 0.5f, 0));
+    blob_paint.setAntiAlias(true);
+    canvas->drawPath(blob, blob_paint);
+    blob_paint.setStrokeWidth(4);
+    canvas->drawPath(blob, blob_paint);
+
+    // hairlines, aliased and anti-aliased, steep and flat, crossing the tiles
+    const GPoint zigzag[] = { { 5, 5 }, { 220, 30 }, { 30, 160 }, { 200, 150 } };
+    GContour hair = { 4, zigzag, false };
+    GPaint hair_paint(GColor::MakeARGB(0.8f, 0.5f, 0, 0.5f));
+    hair_paint.setStrokeWidth(0.5f);
+    canvas->drawContours(&hair, 1, hair_paint);
+    hair_paint.setShader(shader);
+    hair_paint.setAntiAlias(true);
+    canvas->save();
+    canvas->scale(0.5f, 0.5f);
+    canvas->drawContours(&ctr, 1, hair_paint);
+    canvas->restore();
+
+    // a turned rect clip and a path clip inside of it, with a clear and a shader drawn in them
+    canvas->save();
+    canvas->rotate(0.2f);
+    canvas->clipRect(GRect::MakeLTRB(80, -20, 220, 60));
+    canvas->clipPath(GPath().moveTo(60, 0).lineTo(260, 30).lineTo(90, 90));
+    canvas->clear(GColor::MakeARGB(1, 0, 0.5f, 0.5f));
+    canvas->drawRect(GRect::MakeLTRB(0, 0, 300, 100), shader_paint);
+    canvas->restore();
+    canvas->save();
+    canvas->clipRect(GRect::MakeLTRB(-50, -60, 30, 90));
+    canvas->drawContours(&ctr, 1, aa_paint);
+    canvas->restore();
+
+    canvas->flush();
+    delete shader;
+}
+
+static void test_tiled_canvas(GTestStats* stats) {
+    // an odd size so the last row and column of tiles are partial
+    const int W = 230, H = 170;
+    GBitmap serial, tiled;
+    setup_bitmap(&serial, W, H);
+    setup_bitmap(&tiled, W, H);
+
+    std::unique_ptr<GCanvas> serial_canvas(GCanvas::Create(serial));
+    draw_tiled_scene(serial_canvas.get());
+
+    for (int threads = 1; threads <= 4; threads += 3) {
+        clear(tiled);
+        std::unique_ptr<GCanvas> tiled_canvas(GCanvas::CreateTiled(tiled, threads));
+        draw_tiled_scene(tiled_canvas.get());
+        stats->expectTrue(!memcmp(serial.pixels(), tiled.pixels(), serial.rowBytes() * H),
+                          threads == 1 ? "tiled_1_thread" : "tiled_4_threads");
+    }
+    stats->expectNULL(GCanvas::CreateTiled(serial, 0), "tiled_no_threads");
+
+    free(serial.pixels());
+    free(tiled.pixels());
+}
+
+// geometry reaching far past what an int holds, covering the whole bitmap
+static void draw_far_geometry(GCanvas* canvas, const GPaint& paint, int kind) {
+    const float B = 3e9f;
+    const GPoint tri[] = { { -B, -B }, { B, -B }, { 0, B } };
+    const GContour ctr = { 3, tri, true };
+    GPaint stroke = paint;
+    stroke.setStrokeWidth(B);
+    const GPoint line[] = { { -B, 0 }, { B, 0 } };
+    const GContour line_ctr = { 2, line, false };
+    const GColor colors[] = { paint.getColor(), paint.getColor(), paint.getColor() };
+    switch (kind) {
+        case 0: canvas->drawRect(GRect::MakeLTRB(-B, -B, B, B), paint); break;
+        case 1: canvas->drawConvexPolygon(tri, 3, paint); break;
+        case 2: canvas->drawContours(&ctr, 1, paint); break;
+        case 3: canvas->drawPath(GPath().moveTo(tri[0]).lineTo(tri[1]).lineTo(tri[2]), paint); break;
+        case 4: canvas->drawContours(&line_ctr, 1, stroke); break;
+        case 5: canvas->drawMesh(1, tri, nullptr, colors, nullptr, paint); break;
+        case 6:
+            canvas->clipPath(GPath().moveTo(tri[0]).lineTo(tri[1]).lineTo(tri[2]));
+            canvas->clear(paint.getColor());
+            break;
+    }
+    canvas->flush();
+}
+
+static void test_far_geometry(GTestStats* stats) {
+    const int W = 20, H = 20;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    const GPixel red = GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    GPaint paint(GColor::MakeARGB(1, 1, 0, 0));
+
+    bool serial = true;
+    bool tiled = true;
+    bool antialiased = true;
+    for (int kind = 0; kind < 7; ++kind) {
+        clear(bitmap);
+        std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+        draw_far_geometry(canvas.get(), paint, kind);
+        serial &= is_filled_with(bitmap, red);
+
+        clear(bitmap);
+        canvas.reset(GCanvas::CreateTiled(bitmap, 2));
+        draw_far_geometry(canvas.get(), paint, kind);
+        tiled &= is_filled_with(bitmap, red);
+
+        GPaint aa_paint = paint;
+        aa_paint.setAntiAlias(true);
+        clear(bitmap);
+        canvas.reset(GCanvas::Create(bitmap));
+        draw_far_geometry(canvas.get(), aa_paint, kind);
+        antialiased &= is_filled_with(bitmap, red);
+    }
+    stats->expectTrue(serial, "far_geometry");
+    stats->expectTrue(tiled, "far_geometry_tiled");
+    stats->expectTrue(antialiased, "far_geometry_antialiased");
+
+    free(bitmap.pixels());
+}
+
+static void draw_recorded_scene(GCanvas* canvas) {
+    canvas->clear(GColor::MakeARGB(1, 1, 1, 1));
+
+    // hundreds of contours and strokes under nested matrices
+    canvas->save();
+    canvas->scale(0.2f, 0.2f);
+    #include "tiger.inc"
+    canvas->restore();
+
+    // one of each of the other draws, with the matrix changing between them
+    canvas->translate(20, 10);
+    canvas->fillRect(GRect::MakeLTRB(0, 0, 40, 30), GColor::MakeARGB(0.5f, 1, 0, 0));
+    const GPoint tri[] = { { 10, 60 }, { 120, 90 }, { 30, 150 } };
+    canvas->fillConvexPolygon(tri, 3, GColor::MakeARGB(0.7f, 0, 0, 1));
+    canvas->rotate(0.2f);
+    const GColor colors[] = {
+        GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0), GColor::MakeARGB(0.5f, 0, 0, 1),
+    };
+    const int indices[] = { 2, 1, 0 };
+    canvas->drawMesh(1, tri, indices, colors, nullptr, GPaint());
+    const GPoint patch[] = { { 60, 10 }, { 150, 20 }, { 140, 90 }, { 70, 70 } };
+    const GColor patch_colors[] = {
+        GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0),
+        GColor::MakeARGB(1, 0, 0, 1), GColor::MakeARGB(0.5f, 1, 1, 0),
+    };
+    canvas->drawQuadPatch(patch, patch_colors, 4);
+
+    // clips, with draws inside of them that share the matrix of draws outside of them
+    canvas->save();
+    canvas->clipPath(GPath().moveTo(0, 0).lineTo(120, 20).lineTo(40, 100));
+    canvas->fillRect(GRect::MakeLTRB(0, 0, 40, 30), GColor::MakeARGB(0.5f, 0, 1, 0));
+    canvas->save();
+    canvas->clipRect(GRect::MakeLTRB(20, 10, 100, 60));
+    canvas->clear(GColor::MakeARGB(1, 1, 1, 0));
+    canvas->restore();
+    canvas->drawMesh(1, tri, indices, colors, nullptr, GPaint());
+    canvas->restore();
+
+    // curves, clipped to curves
+    canvas->save();
+    canvas->clipPath(GPath().moveTo(10, 100).quadTo(80, 0, 150, 100).lineTo(10, 100));
+    canvas->drawPath(GPath().moveTo(0, 40).cubicTo(60, 140, 100, -20, 160, 80).lineTo(0, 80),
+                     GPaint(GColor::MakeARGB(0.8f, 0, 0.6f, 0.3f)));
+    canvas->restore();
+}
+
+static void test_recording_canvas(GTestStats* stats) {
+    const int W = 200, H = 200;
+    GBitmap direct, played;
+    setup_bitmap(&direct, W, H);
+    setup_bitmap(&played, W, H);
+
+    std::unique_ptr<GCanvas> direct_canvas(GCanvas::Create(direct));
+    draw_recorded_scene(direct_canvas.get());
+
+    GCanvasRecording recording;
+    draw_recorded_scene(&recording);
+    stats->expectTrue(recording.matrix_count() < 8, "recording_shares_matrices");
+
+    // played back more than once, and after being recorded again
+    std::unique_ptr<GCanvas> played_canvas(GCanvas::Create(played));
+    for (int i = 0; i < 2; ++i) {
+        clear(played);
+        recording.playback(played_canvas.get());
+        stats->expectTrue(!memcmp(direct.pixels(), played.pixels(), direct.rowBytes() * H),
+                          "recording_playback");
+    }
+    recording.reset();
+    draw_recorded_scene(&recording);
+    clear(played);
+    recording.playback(played_canvas.get());
+    stats->expectTrue(!memcmp(direct.pixels(), played.pixels(), direct.rowBytes() * H),
+                      "recording_reset");
+
+    free(direct.pixels());
+    free(played.pixels());
+}
+
+// how far p is from the segment a-b
+static float distance_to_segment(GPoint p, GPoint a, GPoint b) {
+    float dx = b.fX - a.fX, dy = b.fY - a.fY;
+    float t = ((p.fX - a.fX) * dx + (p.fY - a.fY) * dy) / std::max(dx * dx + dy * dy, 1e-12f);
+    t = std::max(0.0f, std::min(t, 1.0f));
+    float ex = a.fX + t * dx - p.fX, ey = a.fY + t * dy - p.fY;
+    return sqrtf(ex * ex + ey * ey);
+}
+
+// compare the bitmap against the contours filled by the nonzero rule at each pixel center,
+// worked out the slow way; a center within a hair of an edge can round either way
+static bool matches_winding(const GBitmap& bitmap, const GContour ctrs[], int count, GPixel inside) {
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x) {
+            GPoint center = { x + 0.5f, y + 0.5f };
+            int winding = 0;
+            float nearest = 1e9f;
+            for (int c = 0; c < count; ++c) {
+                for (int i = 0; i < ctrs[c].fCount; ++i) {
+                    GPoint a = ctrs[c].fPts[i];
+                    GPoint b = ctrs[c].fPts[(i + 1) % ctrs[c].fCount];
+                    nearest = std::min(nearest, distance_to_segment(center, a, b));
+                    if ((a.fY <= center.fY) != (b.fY <= center.fY)) {
+                        float cross_x = a.fX + (center.fY - a.fY) * (b.fX - a.fX) / (b.fY - a.fY);
+                        if (cross_x > center.fX) {
+                            winding += (b.fY > a.fY ? 1 : -1);
+                        }
+                    }
+                }
+            }
+            bool drawn = *bitmap.getAddr(x, y) == inside;
+            if (drawn != (winding != 0) && nearest > 1 / 32.0f) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void test_active_edges(GTestStats* stats) {
+    const int W = 64, H = 64;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    const GPixel red = GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    const GPaint paint(GColor::MakeARGB(1, 1, 0, 0));
+
+    // random self crossing contours, some reaching off the bitmap, with anywhere from a few to
+    // dozens of edges crossing a row, which enter, leave and pass each other from row to row
+    GRandom rand;
+    GPoint pts[3][40];
+    bool random_matches = true;
+    for (int n = 0; n < 40; ++n) {
+        GContour ctrs[3];
+        int count = rand.nextRange(1, 3);
+        for (int c = 0; c < count; ++c) {
+            ctrs[c].fCount = rand.nextRange(3, 40);
+            ctrs[c].fPts = pts[c];
+            ctrs[c].fClosed = true;
+            for (int i = 0; i < ctrs[c].fCount; ++i) {
+                pts[c][i] = { rand.nextF() * 84 - 10, rand.nextF() * 84 - 10 };
+            }
+        }
+        clear(bitmap);
+        canvas->drawContours(ctrs, count, paint);
+        random_matches &= matches_winding(bitmap, ctrs, count, red);
+    }
+    stats->expectTrue(random_matches, "active_edges_random");
+
+    // a 99 point star, every edge crossing most of the others, is the worst case for keeping
+    // the active edges in order
+    GPoint star[99];
+    for (int i = 0; i < 99; ++i) {
+        float angle = i * 49 * 6.2831853f / 99;
+        star[i] = { 32 + 30 * cosf(angle), 32 + 30 * sinf(angle) };
+    }
+    GContour star_ctr = { 99, star, true };
+    clear(bitmap);
+    canvas->drawContours(&star_ctr, 1, paint);
+    stats->expectTrue(matches_winding(bitmap, &star_ctr, 1, red), "active_edges_star");
+
+    free(bitmap.pixels());
+}
+
+static void test_edge_sort(GTestStats* stats) {
+    const int W = 64, H = 64;
+    GBitmap first, bitmap;
+    setup_bitmap(&first, W, H);
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> first_canvas(GCanvas::Create(first));
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    const GPixel red = GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    const GPaint paint(GColor::MakeARGB(1, 1, 0, 0));
+
+    // turned ellipses with few edges (insertion sorted) and many (bucketed by row) come out the
+    // same whichever point they start from and whichever way they go around
+    bool any_order = true;
+    bool convex_matches = true;
+    const int sides[] = { 3, 4, 7, 8, 9, 24, 61 };
+    GPoint pts[61];
+    GPoint reordered[61];
+    for (int n : sides) {
+        for (int i = 0; i < n; ++i) {
+            float angle = 0.3f + i * 6.2831853f / n;
+            float x = 28 * cosf(angle), y = 17 * sinf(angle);
+            pts[i] = { 31.7f + x * 0.8f - y * 0.6f, 30.2f + x * 0.6f + y * 0.8f };
+        }
+        clear(first);
+        first_canvas->drawConvexPolygon(pts, n, paint);
+        GContour ctr = { n, pts, true };
+        convex_matches &= matches_winding(first, &ctr, 1, red);
+        for (int start = 1; start < n; start += 2) {
+            for (int i = 0; i < n; ++i) {
+                reordered[i] = pts[(start + (start & 2 ? n - i : i)) % n];
+            }
+            clear(bitmap);
+            canvas->drawConvexPolygon(reordered, n, paint);
+            any_order &= !memcmp(first.pixels(), bitmap.pixels(), bitmap.rowBytes() * H);
+        }
+    }
+    stats->expectTrue(convex_matches, "edge_sort_convex");
+    stats->expectTrue(any_order, "edge_sort_any_order");
+
+    // a comb whose teeth all start on the same row, so a whole bucket of edges ties on y_min and
+    // is ordered by x and slope alone, then a triangle in the buffer the comb left behind
+    GPoint comb[2 * 15 + 2];
+    int comb_count = 0;
+    for (int i = 0; i < 15; ++i) {
+        comb[comb_count++] = { 2.0f + i * 4, 5.5f };
+        comb[comb_count++] = { 4.0f + i * 4 + (i % 3), 50.5f };
+    }
+    comb[comb_count++] = { 62, 60 };
+    comb[comb_count++] = { 2, 60 };
+    GContour comb_ctr = { comb_count, comb, true };
+    clear(bitmap);
+    canvas->drawContours(&comb_ctr, 1, paint);
+    bool comb_matches = matches_winding(bitmap, &comb_ctr, 1, red);
+    const GPoint tri[] = { { 10, 40 }, { 50, 12 }, { 40, 55 } };
+    GContour tri_ctr = { 3, tri, true };
+    clear(bitmap);
+    canvas->drawConvexPolygon(tri, 3, paint);
+    comb_matches &= matches_winding(bitmap, &tri_ctr, 1, red);
+    stats->expectTrue(comb_matches, "edge_sort_ties");
+
+    free(first.pixels());
+    free(bitmap.pixels());
+}
+
+// every heap allocation in the process goes through here, so tests can check that a draw makes
+// none once it has warmed up
+static std::atomic<long> gAllocCount(0);
+
+void* operator new(size_t size) {
+    gAllocCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+static void draw_steady_scene(GCanvas* canvas, const GPath& blob) {
+    canvas->clear(GColor::MakeARGB(1, 1, 1, 1));
+    GPaint paint(GColor::MakeARGB(0.5f, 0, 0, 1));
+    canvas->drawRect(GRect::MakeLTRB(3, 4, 40, 30), paint);
+    const GPoint quad[] = { { 10, 50 }, { 60, 45 }, { 55, 70 }, { 5, 62 } };
+    canvas->drawConvexPolygon(quad, 4, paint);
+
+    GPoint star[25];
+    for (int i = 0; i < 25; ++i) {
+        float angle = i * 12 * 6.2831853f / 25;
+        star[i] = { 40 + 30 * cosf(angle), 40 + 30 * sinf(angle) };
+    }
+    GContour star_ctr = { 25, star, true };
+    canvas->drawContours(&star_ctr, 1, paint);
+    paint.setAntiAlias(true);
+    canvas->drawContours(&star_ctr, 1, paint);
+
+    // strokes with every join and cap, a dashed one, and a curved path
+    GPaint stroke(GColor::MakeARGB(1, 0, 0.5f, 0));
+    stroke.setStrokeWidth(5);
+    canvas->drawContours(&star_ctr, 1, stroke);
+    stroke.setStrokeJoin(GPaint::Join::kRound);
+    stroke.setStrokeCap(GPaint::Cap::kRound);
+    const GPoint wave[] = { { 5, 70 }, { 25, 50 }, { 45, 75 }, { 70, 45 } };
+    GContour wave_ctr = { 4, wave, false };
+    canvas->drawContours(&wave_ctr, 1, stroke);
+    stroke.setStrokeJoin(GPaint::Join::kBevel);
+    const float intervals[] = { 6, 3 };
+    stroke.setDash(intervals, 2, 1);
+    canvas->drawContours(&wave_ctr, 1, stroke);
+    canvas->drawPath(blob, paint);
+}
+
+static void test_steady_state_allocs(GTestStats* stats) {
+    // the arena lines things up, makes a block big enough for anything too big for one, and
+    // hands out the same memory again after a reset without going back to the heap
+    Arena arena(256);
+    char* bytes = (char*)arena.allocate(10, 1);
+    double* doubles = arena.make_array<double>(3);
+    void* big = arena.allocate(1000, 16);
+    bool arena_ok = ((uintptr_t)doubles % alignof(double)) == 0 && ((uintptr_t)big % 16) == 0;
+    arena_ok &= arena.bytes_used() == 10 + 3 * sizeof(double) + 1000;
+    long before = gAllocCount.load();
+    arena.reset();
+    arena_ok &= arena.bytes_used() == 0;
+    arena_ok &= arena.allocate(10, 1) == bytes && arena.make_array<double>(3) == doubles;
+    arena_ok &= arena.allocate(1000, 16) == big;
+    arena_ok &= gAllocCount.load() == before;
+    stats->expectTrue(arena_ok, "arena_reuse");
+
+    // once a canvas has drawn something it can draw it again without allocating (the path is
+    // made up front, building it allocates)
+    const int W = 80, H = 80;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    GPath blob;
+    blob.moveTo(20, 20).cubicTo(60, 0, 70, 50, 40, 60).quadTo(10, 70, 20, 20);
+    draw_steady_scene(canvas.get(), blob);
+    before = gAllocCount.load();
+    draw_steady_scene(canvas.get(), blob);
+    stats->expectTrue(gAllocCount.load() == before, "steady_state_no_allocs");
+
+    free(bitmap.pixels());
+}
+
+static void test_rect_fast_path(GTestStats* stats) {
+    const int W = 60, H = 50;
+    GBitmap rects, polys;
+    setup_bitmap(&rects, W, H);
+    setup_bitmap(&polys, W, H);
+    std::unique_ptr<GCanvas> rect_canvas(GCanvas::Create(rects));
+    std::unique_ptr<GCanvas> poly_canvas(GCanvas::Create(polys));
+
+    // drawRect takes a shortcut when the ctm only scales and translates, so check it
+    // lands on exactly the pixels the polygon would, including flips, clipping and
+    // whole number matrices (where the polygon steps in fixed point)
+    GRandom rand;
+    for (int i = 0; i < 200; ++i) {
+        const float sx = (i & 1) ? -1.5f : (i & 2) ? 2 : 0.75f;
+        const float sy = (i & 4) ? -1 : 1.25f;
+        const GMatrix matrices[] = {
+            GMatrix(sx, 0, rand.nextF() * W, 0, sy, rand.nextF() * H),
+            GMatrix((i & 1) ? -1 : 2, 0, W / 2, 0, (i & 4) ? 3 : -1, H / 2),
+        };
+        const GRect rect = GRect::MakeLTRB(rand.nextF() * 80 - 40, rand.nextF() * 80 - 40,
+                                           rand.nextF() * 80 - 40, rand.nextF() * 80 - 40);
+        const GPoint pts[] = {
+            { rect.fLeft, rect.fTop }, { rect.fRight, rect.fTop },
+            { rect.fRight, rect.fBottom }, { rect.fLeft, rect.fBottom },
+        };
+        const GColor color = GColor::MakeARGB(0.5f, rand.nextF(), rand.nextF(), rand.nextF());
+        for (const GMatrix& matrix : matrices) {
+            rect_canvas->save();
+            rect_canvas->concat(matrix);
+            rect_canvas->fillRect(rect, color);
+            rect_canvas->restore();
+            poly_canvas->save();
+            poly_canvas->concat(matrix);
+            poly_canvas->fillConvexPolygon(pts, 4, color);
+            poly_canvas->restore();
+        }
+    }
+    stats->expectTrue(!memcmp(rects.pixels(), polys.pixels(), rects.rowBytes() * H), "rect_fast_path");
+
+    free(rects.pixels());
+    free(polys.pixels());
+}
+
+static void test_bitmap_filters(GTestStats* stats) {
+    // a black and a white pixel, stretched across 16 pixels
+    GPixel src_pixels[] = { GPixel_PackARGB(0xFF, 0, 0, 0), GPixel_PackARGB(0xFF, 0xFF, 0xFF, 0xFF) };
+    GBitmap src;
+    src.fWidth = 2;
+    src.fHeight = 1;
+    src.fRowBytes = sizeof(src_pixels);
+    src.fPixels = src_pixels;
+
+    GBitmap dst;
+    setup_bitmap(&dst, 16, 1);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(dst));
+    canvas->save();
+    canvas->scale(8, 1);
+
+    // bilinear ramps from black to white and stays there past the pixel centers
+    std::unique_ptr<GShader> bilinear(GShader::FromBitmap(src, GMatrix(), GShader::kClamp, GShader::kBilinear));
+    canvas->drawRect(GRect::MakeWH(2, 1), GPaint(bilinear.get()));
+    bool ramps = GPixel_GetR(dst.pixels()[0]) == 0 && GPixel_GetR(dst.pixels()[15]) == 0xFF;
+    for (int x = 1; x < 16; ++x) {
+        ramps &= GPixel_GetR(dst.pixels()[x]) >= GPixel_GetR(dst.pixels()[x - 1]);
+        ramps &= GPixel_GetA(dst.pixels()[x]) == 0xFF;
+    }
+    ramps &= GPixel_GetR(dst.pixels()[7]) > 0x40 && GPixel_GetR(dst.pixels()[8]) < 0xC0;
+    stats->expectTrue(ramps, "bilinear_ramp");
+
+    // bicubic with alpha stays premultiplied, even where it overshoots
+    std::unique_ptr<GShader> bicubic(GShader::FromBitmap(src, GMatrix(), GShader::kRepeat, GShader::kBicubic));
+    GPaint bicubic_paint(bicubic.get());
+    bicubic_paint.setAlpha(0.5f);
+    clear(dst);
+    canvas->drawRect(GRect::MakeWH(2, 1), bicubic_paint);
+    bool premultiplied = true;
+    for (int x = 0; x < 16; ++x) {
+        GPixel p = dst.pixels()[x];
+        premultiplied &= GPixel_GetA(p) == 0x7F && GPixel_GetR(p) <= GPixel_GetA(p);
+    }
+    stats->expectTrue(premultiplied, "bicubic_premultiplied");
+
+    // moving by whole pixels does not blur anything
+    GBitmap nearest_dst;
+    setup_bitmap(&nearest_dst, 16, 1);
+    std::unique_ptr<GCanvas> nearest_canvas(GCanvas::Create(nearest_dst));
+    std::unique_ptr<GShader> nearest(GShader::FromBitmap(src, GMatrix(1, 0, 3, 0, 1, 0)));
+    std::unique_ptr<GShader> shifted(GShader::FromBitmap(src, GMatrix(1, 0, 3, 0, 1, 0), GShader::kClamp, GShader::kBicubic));
+    canvas->restore();
+    clear(dst);
+    canvas->drawRect(GRect::MakeWH(16, 1), GPaint(shifted.get()));
+    nearest_canvas->drawRect(GRect::MakeWH(16, 1), GPaint(nearest.get()));
+    stats->expectTrue(!memcmp(dst.pixels(), nearest_dst.pixels(), dst.rowBytes()), "filter_whole_pixels");
+
+    free(dst.pixels());
+    free(nearest_dst.pixels());
+}
+
+static void test_mipmap(GTestStats* stats) {
+    // a 3x3 bitmap halves to 2x2, the last row and column averaged with themselves, then 1x1
+    GPixel src_pixels[9];
+    for (int i = 0; i < 9; ++i) {
+        src_pixels[i] = GPixel_PackARGB(0xFF, i * 30, 0, 0);
+    }
+    GBitmap src;
+    src.fWidth = 3;
+    src.fHeight = 3;
+    src.fRowBytes = 3 * sizeof(GPixel);
+    src.fPixels = src_pixels;
+
+    Mipmap mipmap(src);
+    const GBitmap& half = mipmap.level(1);
+    const GBitmap& last = mipmap.level(5);
+    bool levels = mipmap.max_level() == 2 && mipmap.level(0).pixels() == src_pixels;
+    levels &= half.width() == 2 && half.height() == 2 && last.width() == 1 && last.height() == 1;
+    levels &= GPixel_GetR(*half.getAddr(0, 0)) == (0 + 30 + 90 + 120 + 2) / 4;
+    levels &= GPixel_GetR(*half.getAddr(1, 0)) == (60 + 60 + 150 + 150 + 2) / 4;
+    levels &= GPixel_GetR(*half.getAddr(0, 1)) == (180 + 210 + 180 + 210 + 2) / 4;
+    levels &= GPixel_GetR(*half.getAddr(1, 1)) == 240;
+    levels &= GPixel_GetA(*last.getAddr(0, 0)) == 0xFF;
+    stats->expectTrue(levels, "mipmap_levels");
+
+    // a one pixel checkerboard shrunk 6x comes out gray, where sampling just the bitmap would
+    // land a quarter of the way between black and white pixels
+    const int N = 48;
+    GBitmap checker;
+    setup_bitmap(&checker, N, N);
+    for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
+            *checker.getAddr(x, y) = ((x ^ y) & 1) ? GPixel_PackARGB(0xFF, 0xFF, 0xFF, 0xFF) : GPixel_PackARGB(0xFF, 0, 0, 0);
+        }
+    }
+    GBitmap dst;
+    setup_bitmap(&dst, N / 6, N / 6);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(dst));
+    canvas->scale(1 / 6.0f, 1 / 6.0f);
+    std::unique_ptr<GShader> shader(GShader::FromBitmap(checker, GMatrix(1, 0, 0.25f, 0, 1, 0.25f), GShader::kRepeat, GShader::kTrilinear));
+    canvas->drawRect(GRect::MakeWH(N, N), GPaint(shader.get()));
+    bool gray = true;
+    for (int y = 0; y < dst.height(); ++y) {
+        for (int x = 0; x < dst.width(); ++x) {
+            int r = GPixel_GetR(*dst.getAddr(x, y));
+            gray &= r >= 0x7E && r <= 0x81;
+        }
+    }
+    stats->expectTrue(gray, "mipmap_minify");
+
+    // the levels are only for trilinear, bilinear and bicubic shrunk just as far still read the
+    // bitmap itself
+    GShaderBitmapSteffey trilinear(checker, GMatrix(), GShader::kRepeat, GShader::kTrilinear);
+    GShaderBitmapSteffey bilinear(checker, GMatrix(), GShader::kRepeat, GShader::kBilinear);
+    GShaderBitmapSteffey bicubic(checker, GMatrix(), GShader::kRepeat, GShader::kBicubic);
+    const GMatrix shrink(0.3f, 0, 0, 0, 0.3f, 0);
+    trilinear.setContext(shrink, 1);
+    bilinear.setContext(shrink, 1);
+    bicubic.setContext(shrink, 1);
+    stats->expectTrue(!strcmp(trilinear.row_proc_name(), "trilinear") && !strcmp(bilinear.row_proc_name(), "bilinear") &&
+                      !strcmp(bicubic.row_proc_name(), "bicubic"), "mipmap_opt_in");
+
+    free(checker.pixels());
+    free(dst.pixels());
+}
+
+static void test_bitmap_row_procs(GTestStats* stats) {
+    // a 5x2 bitmap where every pixel is different
+    const int W = 5;
+    GPixel src_pixels[W * 2];
+    for (int i = 0; i < W * 2; ++i) {
+        src_pixels[i] = GPixel_PackARGB(0xFF, i * 20, 0, 0);
+    }
+    GBitmap src;
+    src.fWidth = W;
+    src.fHeight = 2;
+    src.fRowBytes = W * sizeof(GPixel);
+    src.fPixels = src_pixels;
+
+    // the matrix picks the routine
+    GShaderBitmapSteffey shader(src, GMatrix(), GShader::kRepeat);
+    bool names = true;
+    shader.setContext(GMatrix(1, 0, -7, 0, 1, 3), 1);
+    names &= !strcmp(shader.row_proc_name(), "translate_repeat");
+    shader.setContext(GMatrix(2, 0, 0, 0, 3, 0), 0.5f);
+    names &= !strcmp(shader.row_proc_name(), "scale_repeat");
+    shader.setContext(GMatrix(1, 1, 0, 0, 1, 0), 1);
+    names &= !strcmp(shader.row_proc_name(), "affine_repeat");
+    stats->expectTrue(names, "row_proc_names");
+
+    // moved left past the bitmap, each tile mode still finds the pixel (x - 7) lands in
+    const GShader::TileMode modes[] = { GShader::kClamp, GShader::kRepeat, GShader::kMirror };
+    bool tiled = true;
+    for (GShader::TileMode mode : modes) {
+        GShaderBitmapSteffey moved(src, GMatrix(1, 0, 7, 0, 1, 0), mode);
+        moved.setContext(GMatrix(), 1);
+        GPixel row[24];
+        moved.shadeRow(0, 1, 24, row);
+        for (int x = 0; x < 24; ++x) {
+            int i = x - 7;
+            if (mode == GShader::kClamp) {
+                i = std::max(0, std::min(i, W - 1));
+            } else if (mode == GShader::kRepeat) {
+                i = ((i % W) + W) % W;
+            } else {
+                i = ((i % (W * 2)) + W * 2) % (W * 2);
+                i = (i >= W ? W * 2 - i - 1 : i);
+            }
+            tiled &= row[x] == src_pixels[W + i];
+        }
+    }
+    stats->expectTrue(tiled, "row_proc_tiling");
+}
+
+static void test_radial_gradient(GTestStats* stats) {
+    // black at the center to white at a radius of 10, along a row through the center
+    const GColor colors[] = { { 1, 0, 0, 0 }, { 1, 1, 1, 1 } };
+    std::unique_ptr<GShader> clamp(GShader::RadialGradient({ 0, 0.5f }, 10, colors, 2));
+    std::unique_ptr<GShader> repeat(GShader::RadialGradient({ 0, 0.5f }, 10, colors, 2, GShader::kRepeat));
+    std::unique_ptr<GShader> mirror(GShader::RadialGradient({ 0, 0.5f }, 10, colors, 2, GShader::kMirror));
+    stats->expectNULL(GShader::RadialGradient({ 0, 0 }, 0, colors, 2), "radial_bad_radius");
+    stats->expectNULL(GShader::RadialGradient({ 0, 0 }, 10, colors, 0), "radial_bad_count");
+
+    GPixel row[30];
+    auto red = [&row](int x) { return (int)GPixel_GetR(row[x]); };
+
+    // pixel 14 is 1.45 radii out, pixel 24 is 2.45
+    clamp->setContext(GMatrix(), 1);
+    clamp->shadeRow(0, 0, 30, row);
+    stats->expectTrue(red(0) < 0x10 && red(14) == 0xFF && red(29) == 0xFF, "radial_clamp");
+    repeat->setContext(GMatrix(), 1);
+    repeat->shadeRow(0, 0, 30, row);
+    stats->expectTrue(red(9) > 0xE0 && red(10) < 0x20 && abs(red(14) - 0x73) <= 2 && abs(red(24) - 0x73) <= 2, "radial_repeat");
+    mirror->setContext(GMatrix(), 1);
+    mirror->shadeRow(0, 0, 30, row);
+    stats->expectTrue(red(10) > 0xF0 && abs(red(14) - 0x8C) <= 2 && abs(red(24) - 0x73) <= 2, "radial_mirror");
+
+    // the paint's alpha scales every color, including the ones past the radius
+    clamp->setContext(GMatrix(), 0.5f);
+    clamp->shadeRow(0, 0, 30, row);
+    bool half = true;
+    for (int x = 0; x < 30; ++x) {
+        half &= GPixel_GetA(row[x]) == 0x80 && GPixel_GetR(row[x]) <= 0x80;
+    }
+    stats->expectTrue(half && red(29) == 0x80, "radial_alpha");
+
+    // the table only holds colors at its entries, so a pixel gets the color of the nearest one
+    // with 6 colors over a radius of 280 (the steepest of the final_radial images) that is off
+    // from the exact color by at most 1 per channel
+    const GColor steep[] = {
+        { 1, 1, 0, 0 }, { 1, 0, 1, 0 }, { 1, 0, 0, 1 }, { 1, 1, 1, 0 }, { 1, 1, 0, 1 }, { 1, 0, 1, 1 },
+    };
+    std::unique_ptr<GShader> fine(GShader::RadialGradient({ 0, 0.5f }, 280, steep, 6));
+    fine->setContext(GMatrix(), 1);
+    GPixel wide[280];
+    fine->shadeRow(0, 0, 280, wide);
+    int worst = 0;
+    for (int x = 0; x < 280; ++x) {
+        float t = (x + 0.5f) / 280 * 5;
+        int k = std::min((int)t, 4);
+        float f = t - k;
+        const GColor& c0 = steep[k];
+        const GColor& c1 = steep[k + 1];
+        int r = (int)(((1 - f) * c0.fR + f * c1.fR) * 255 + 0.5f);
+        int g = (int)(((1 - f) * c0.fG + f * c1.fG) * 255 + 0.5f);
+        int b = (int)(((1 - f) * c0.fB + f * c1.fB) * 255 + 0.5f);
+        worst = std::max(worst, abs((int)GPixel_GetR(wide[x]) - r));
+        worst = std::max(worst, abs((int)GPixel_GetG(wide[x]) - g));
+        worst = std::max(worst, abs((int)GPixel_GetB(wide[x]) - b));
+    }
+    stats->expectTrue(worst <= 1, "radial_table_error");
+
+    // final_radial2 draws a second, half transparent gradient over that one, and each of them is
+    // rounded to 8 bits in its table before they are blended, so the two roundings can add up
+    // to 2 per channel from the exact color (the most final_radial2 differs from expected/)
+    const GColor over[] = { { 0.5f, 0, 0, 1 }, { 0.5f, 0, 1, 0 }, { 0.5f, 1, 0, 0 } };
+    const int N = 512;
+    GBitmap stacked;
+    setup_bitmap(&stacked, N, N);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(stacked));
+    std::unique_ptr<GShader> under_shader(GShader::RadialGradient({ 250, 250 }, 280, steep, 6));
+    std::unique_ptr<GShader> over_shader(GShader::RadialGradient({ 30, 30 }, 550, over, 3));
+    canvas->drawRect(GRect::MakeWH(N, N), GPaint(under_shader.get()));
+    canvas->drawRect(GRect::MakeWH(N, N), GPaint(over_shader.get()));
+    auto exact = [](const GColor colors[], int count, float cx, float cy, float radius, float x, float y) {
+        float t = std::min(sqrtf((x - cx) * (x - cx) + (y - cy) * (y - cy)) / radius, 1.0f) * (count - 1);
+        int k = std::min((int)t, count - 2);
+        float f = t - k;
+        GColor c;
+        c.fA = (1 - f) * colors[k].fA + f * colors[k + 1].fA;
+        c.fR = (1 - f) * colors[k].fR + f * colors[k + 1].fR;
+        c.fG = (1 - f) * colors[k].fG + f * colors[k + 1].fG;
+        c.fB = (1 - f) * colors[k].fB + f * colors[k + 1].fB;
+        return c;
+    };
+    int stacked_worst = 0;
+    for (int y = 0; y < N; ++y) {
+        for (int x = 0; x < N; ++x) {
+            GColor a = exact(steep, 6, 250, 250, 280, x + 0.5f, y + 0.5f);
+            GColor b = exact(over, 3, 30, 30, 550, x + 0.5f, y + 0.5f);
+            GPixel pixel = *stacked.getAddr(x, y);
+            int r = (int)((b.fR * b.fA + (1 - b.fA) * a.fR) * 255 + 0.5f);
+            int g = (int)((b.fG * b.fA + (1 - b.fA) * a.fG) * 255 + 0.5f);
+            int bl = (int)((b.fB * b.fA + (1 - b.fA) * a.fB) * 255 + 0.5f);
+            stacked_worst = std::max(stacked_worst, abs((int)GPixel_GetR(pixel) - r));
+            stacked_worst = std::max(stacked_worst, abs((int)GPixel_GetG(pixel) - g));
+            stacked_worst = std::max(stacked_worst, abs((int)GPixel_GetB(pixel) - bl));
+        }
+    }
+    stats->expectTrue(stacked_worst <= 2, "radial_stacked_error");
+    free(stacked.pixels());
+}
+
+static void test_linear_gradient_stops(GTestStats* stats) {
+    // red up to 0.25, then a hard edge to green fading to blue at 1, across 100 pixels
+    const GColor colors[] = { { 1, 1, 0, 0 }, { 1, 1, 0, 0 }, { 1, 0, 1, 0 }, { 1, 0, 0, 1 } };
+    const float positions[] = { 0, 0.25f, 0.25f, 1 };
+    std::unique_ptr<GShader> shader(GShader::LinearGradient({ 0, 0 }, { 100, 0 }, colors, positions, 4));
+    stats->expectNULL(GShader::LinearGradient({ 0, 0 }, { 100, 0 }, colors, positions, 0), "stops_bad_count");
+
+    GPixel row[100];
+    shader->setContext(GMatrix(), 1);
+    shader->shadeRow(0, 0, 100, row);
+    bool stops = row[0] == GPixel_PackARGB(0xFF, 0xFF, 0, 0) && row[24] == row[0];
+    stops &= GPixel_GetR(row[26]) == 0 && GPixel_GetG(row[26]) > 0xF0;
+    stops &= abs((int)GPixel_GetG(row[62]) - 0x80) <= 3 && abs((int)GPixel_GetB(row[62]) - 0x80) <= 3;
+    stops &= GPixel_GetB(row[99]) > 0xF8 && GPixel_GetR(row[99]) == 0;
+    stats->expectTrue(stops, "stops_positions");
+
+    // the table follows the alpha, and comes back when the alpha does
+    shader->setContext(GMatrix(), 0.5f);
+    shader->shadeRow(0, 0, 100, row);
+    bool alpha = GPixel_GetA(row[0]) == 0x80 && GPixel_GetA(row[99]) == 0x80;
+    shader->setContext(GMatrix(1, 0, 10, 0, 1, 0), 1);
+    shader->shadeRow(10, 0, 1, row);
+    alpha &= row[0] == GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    stats->expectTrue(alpha, "stops_alpha");
+
+    // without positions the colors are spaced evenly, and mirror runs them back the other way
+    std::unique_ptr<GShader> even(GShader::LinearGradient({ 0, 0 }, { 100, 0 }, colors + 1, nullptr, 3, GShader::kMirror));
+    even->setContext(GMatrix(), 1);
+    even->shadeRow(0, 0, 100, row);
+    GPixel mirrored[100];
+    even->shadeRow(100, 0, 100, mirrored);
+    bool evenly = GPixel_GetG(row[50]) > 0xF0 && GPixel_GetR(row[50]) == 0;
+    for (int x = 0; x < 100; ++x) {
+        evenly &= mirrored[x] == row[99 - x];
+    }
+    stats->expectTrue(evenly, "stops_even_mirror");
+
+    // positions that leave room at the ends keep the end colors out there, in between the
+    // colors still run from stop to stop
+    const float inset[] = { 0.2f, 0.6f };
+    std::unique_ptr<GShader> inner(GShader::LinearGradient({ 0, 0 }, { 100, 0 }, colors + 2, inset, 2));
+    inner->setContext(GMatrix(), 1);
+    inner->shadeRow(0, 0, 100, row);
+    bool ends = row[0] == GPixel_PackARGB(0xFF, 0, 0xFF, 0) && row[19] == row[0];
+    ends &= row[61] == GPixel_PackARGB(0xFF, 0, 0, 0xFF) && row[99] == row[61];
+    ends &= abs((int)GPixel_GetG(row[40]) - 0x80) <= 3 && abs((int)GPixel_GetB(row[40]) - 0x80) <= 3;
+    stats->expectTrue(ends, "stops_inset_ends");
+
+    // the sweep shares the positions, so just past +x it is still the first color and just
+    // short of a full turn it is the last
+    std::unique_ptr<GShader> sweep(GShader::SweepGradient({ 0, 0 }, colors + 2, inset, 2));
+    sweep->setContext(GMatrix(), 1);
+    GPixel turned[2];
+    sweep->shadeRow(10, 0, 1, turned);
+    sweep->shadeRow(10, -6, 1, turned + 1);
+    stats->expectTrue(turned[0] == GPixel_PackARGB(0xFF, 0, 0xFF, 0) &&
+                      turned[1] == GPixel_PackARGB(0xFF, 0, 0, 0xFF), "stops_inset_sweep");
+}
+
+static void test_sweep_conical_gradients(GTestStats* stats) {
+    const GColor colors[] = { { 1, 0, 0, 0 }, { 1, 1, 1, 1 } };
+    GBitmap dst;
+    setup_bitmap(&dst, 21, 21);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(dst));
+    auto red = [&dst](int x, int y) { return (int)GPixel_GetR(*dst.getAddr(x, y)); };
+
+    // black to white around the center of the bitmap, starting at +x and turning towards +y
+    std::unique_ptr<GShader> sweep(GShader::SweepGradient({ 10.5f, 10.5f }, colors, nullptr, 2));
+    canvas->drawRect(GRect::MakeWH(21, 21), GPaint(sweep.get()));
+    bool turns = red(20, 10) <= 1 && abs(red(10, 20) - 0x40) <= 1 && abs(red(0, 10) - 0x80) <= 1 &&
+                 abs(red(10, 0) - 0xBF) <= 1 && abs(red(20, 20) - 0x20) <= 1;
+    stats->expectTrue(turns, "sweep_angles");
+    stats->expectNULL(GShader::SweepGradient({ 0, 0 }, colors, nullptr, 0), "sweep_bad_count");
+
+    // a cone from a point out to a circle at the same center is the radial gradient
+    std::unique_ptr<GShader> cone(GShader::TwoPointConicalGradient({ 10.5f, 10.5f }, 0, { 10.5f, 10.5f }, 8,
+                                                                   colors, nullptr, 2));
+    std::unique_ptr<GShader> radial(GShader::RadialGradient({ 10.5f, 10.5f }, 8, colors, 2));
+    GPixel cone_row[21], radial_row[21];
+    cone->setContext(GMatrix(), 1);
+    radial->setContext(GMatrix(), 1);
+    bool same = true;
+    for (int y = 0; y < 21; ++y) {
+        cone->shadeRow(0, y, 21, cone_row);
+        radial->shadeRow(0, y, 21, radial_row);
+        for (int x = 0; x < 21; ++x) {
+            same &= abs((int)GPixel_GetR(cone_row[x]) - (int)GPixel_GetR(radial_row[x])) <= 1;
+        }
+    }
+    stats->expectTrue(same, "conical_as_radial");
+
+    // a cylinder of circles sliding right only covers the band they pass through
+    std::unique_ptr<GShader> slide(GShader::TwoPointConicalGradient({ 0, 10.5f }, 4, { 20, 10.5f }, 4,
+                                                                    colors, nullptr, 2));
+    clear(dst);
+    canvas->drawRect(GRect::MakeWH(21, 21), GPaint(slide.get()));
+    bool band = GPixel_GetA(*dst.getAddr(10, 0)) == 0 && GPixel_GetA(*dst.getAddr(10, 20)) == 0;
+    band &= GPixel_GetA(*dst.getAddr(10, 10)) == 0xFF && red(10, 10) > red(5, 10);
+    stats->expectTrue(band, "conical_band");
+    stats->expectNULL(GShader::TwoPointConicalGradient({ 0, 0 }, 4, { 0, 0 }, 4, colors, nullptr, 2), "conical_same_circle");
+    stats->expectNULL(GShader::TwoPointConicalGradient({ 0, 0 }, -1, { 9, 0 }, 4, colors, nullptr, 2), "conical_bad_radius");
+
+    free(dst.pixels());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void test_mesh_rasterizer(GTestStats* stats) {
+    const int W = 64, H = 64;
+    GBitmap a, b;
+    setup_bitmap(&a, W, H);
+    setup_bitmap(&b, W, H);
+    std::unique_ptr<GCanvas> ca(GCanvas::Create(a));
+    std::unique_ptr<GCanvas> cb(GCanvas::Create(b));
+
+    // a rotated quad as two triangles blends each pixel exactly once, like the quad itself
+    const GPoint quad[] = { { 10, 4 }, { 58, 14 }, { 50, 60 }, { 3, 45 } };
+    const GColor half = GColor::MakeARGB(0.5f, 0, 0.5f, 1);
+    const GColor solid[] = { half, half, half, half };
+    const int split[] = { 0, 1, 2, 0, 2, 3 };
+    ca->drawMesh(2, quad, split, solid, nullptr, GPaint());
+    cb->fillConvexPolygon(quad, 4, half);
+    stats->expectTrue(!memcmp(a.pixels(), b.pixels(), a.rowBytes() * H), "mesh_no_seams");
+
+    // indexed triangles come out the same as the vertices spelled out
+    const GColor colors[] = {
+        GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0),
+        GColor::MakeARGB(0.5f, 0, 0, 1), GColor::MakeARGB(0.8f, 1, 1, 0),
+    };
+    GPoint flat_pts[6];
+    GColor flat_colors[6];
+    for (int i = 0; i < 6; ++i) {
+        flat_pts[i] = quad[split[i]];
+        flat_colors[i] = colors[split[i]];
+    }
+    clear(a);
+    clear(b);
+    ca->save();
+    cb->save();
+    ca->rotate(0.1f);
+    cb->rotate(0.1f);
+    ca->drawMesh(2, quad, split, colors, nullptr, GPaint());
+    cb->drawMesh(2, flat_pts, nullptr, flat_colors, nullptr, GPaint());
+    stats->expectTrue(!memcmp(a.pixels(), b.pixels(), a.rowBytes() * H), "mesh_indexed");
+
+    // the corners keep their own colors
+    ca->restore();
+    cb->restore();
+    clear(a);
+    const GPoint tri[] = { { 0, 0 }, { 64, 0 }, { 0, 64 } };
+    const GColor rgb[] = {
+        GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0), GColor::MakeARGB(1, 0, 0, 1),
+    };
+    ca->drawMesh(1, tri, nullptr, rgb, nullptr, GPaint());
+    GPixel corner = a.pixels()[0];
+    stats->expectTrue(GPixel_GetA(corner) == 0xFF && GPixel_GetR(corner) > 0xF8 && GPixel_GetB(corner) < 8,
+                      "mesh_corner_color");
+
+    // white colors leave a texture alone, and the paint's alpha is only applied once
+    GPixel tex_pixels[4] = {
+        GPixel_PackARGB(0xFF, 0xFF, 0, 0), GPixel_PackARGB(0xFF, 0, 0xFF, 0),
+        GPixel_PackARGB(0x80, 0, 0, 0x80), GPixel_PackARGB(0xFF, 0x40, 0x40, 0x40),
+    };
+    GBitmap tex_bitmap;
+    tex_bitmap.fWidth = 2;
+    tex_bitmap.fHeight = 2;
+    tex_bitmap.fRowBytes = 2 * sizeof(GPixel);
+    tex_bitmap.fPixels = tex_pixels;
+    std::unique_ptr<GShader> shader(GShader::FromBitmap(tex_bitmap, GMatrix()));
+    GPaint paint;
+    paint.setShader(shader.get());
+    paint.setAlpha(0.5f);
+    const GPoint uv[] = { { 0, 0 }, { 2, 0 }, { 2, 2 }, { 0, 2 } };
+    const GColor white[] = {
+        GColor::MakeARGB(1, 1, 1, 1), GColor::MakeARGB(1, 1, 1, 1),
+        GColor::MakeARGB(1, 1, 1, 1), GColor::MakeARGB(1, 1, 1, 1),
+    };
+    clear(a);
+    clear(b);
+    ca->drawMesh(2, quad, split, white, uv, paint);
+    cb->drawMesh(2, quad, split, nullptr, uv, paint);
+    stats->expectTrue(!memcmp(a.pixels(), b.pixels(), a.rowBytes() * H), "mesh_texture_colors");
+
+    free(a.pixels());
+    free(b.pixels());
+}
+
+static void test_quad_patch(GTestStats* stats) {
+    const GPoint pts[] = { { 10, 5 }, { 50, 12 }, { 44, 60 }, { 2, 40 } };
+    const GColor colors[] = {
+        GColor::MakeARGB(1, 1, 0, 0), GColor::MakeARGB(1, 0, 1, 0),
+        GColor::MakeARGB(1, 0, 0, 1), GColor::MakeARGB(0.5f, 1, 1, 0),
+    };
+
+    // the layout is made once per strip count, moving the corners only redoes the points
+    QuadPatch patch;
+    stats->expectFalse(patch.tessellate(pts, colors, 0), "patch_no_strips");
+    stats->expectTrue(patch.tessellate(pts, colors, 3) && patch.triangle_count() == 18, "patch_triangles");
+    const int* indices = patch.indices();
+    const GPoint moved[] = { { 12, 5 }, { 52, 12 }, { 46, 60 }, { 4, 40 } };
+    patch.tessellate(moved, colors, 3);
+    bool cached = patch.indices() == indices && patch.cached_layout_count() == 1;
+    patch.tessellate(pts, colors, 2);
+    cached &= patch.triangle_count() == 8 && patch.cached_layout_count() == 2;
+    stats->expectTrue(cached, "patch_layout_cached");
+
+    // only the most recently used layouts are kept, however many strip counts get asked for
+    QuadPatch many;
+    bool bounded = true;
+    for (int strips = 1; strips <= 3 * QuadPatch::MAX_LAYOUTS; ++strips) {
+        many.tessellate(pts, colors, strips);
+        bounded &= many.cached_layout_count() <= QuadPatch::MAX_LAYOUTS;
+        bounded &= many.triangle_count() == strips * strips * 2 && many.indices()[strips * strips * 6 - 1] == (strips + 1) * (strips + 1) - 2;
+    }
+    stats->expectTrue(bounded, "patch_layout_bounded");
+
+    // the grid runs corner to corner, and each cell is split from its left top to its right bottom
+    auto same = [](const GPoint& p, const GPoint& q) { return p.fX == q.fX && p.fY == q.fY; };
+    const GPoint* grid = patch.points();
+    bool corners = same(grid[0], pts[0]) && same(grid[2], pts[1]) && same(grid[8], pts[2]) && same(grid[6], pts[3]);
+    const GColor& c = patch.colors()[8];
+    corners &= c.fA == colors[2].fA && c.fR == colors[2].fR && c.fG == colors[2].fG && c.fB == colors[2].fB;
+    const int* first = patch.indices();
+    corners &= first[0] == 0 && first[2] == 4 && first[3] == 0 && first[4] == 4;
+    stats->expectTrue(corners, "patch_corners");
+
+    // one strip is just the quad split in two
+    const int W = 64, H = 64;
+    GBitmap a, b;
+    setup_bitmap(&a, W, H);
+    setup_bitmap(&b, W, H);
+    std::unique_ptr<GCanvas> ca(GCanvas::Create(a));
+    std::unique_ptr<GCanvas> cb(GCanvas::Create(b));
+    ca->drawQuadPatch(pts, colors, 1);
+    const int split[] = { 0, 1, 2, 0, 2, 3 };
+    cb->drawMesh(2, pts, split, colors, nullptr, GPaint());
+    stats->expectTrue(!memcmp(a.pixels(), b.pixels(), a.rowBytes() * H), "patch_one_strip");
+
+    free(a.pixels());
+    free(b.pixels());
+}
+
+static void test_matrix_types(GTestStats* stats) {
+    GMatrix m;
+    bool types = m.getType() == GMatrix::kIdentity_Mask;
+    m.setTranslate(3, 0);
+    types &= m.getType() == GMatrix::kTranslate_Mask;
+    m.preScale(2, 1);
+    types &= m.getType() == (GMatrix::kTranslate_Mask | GMatrix::kScale_Mask);
+    m.setRotate(0.5f);
+    types &= (m.getType() & GMatrix::kAffine_Mask) != 0;
+    m.set6(1, 0, 0, 0, 1, 0);
+    types &= m.getType() == GMatrix::kIdentity_Mask;
+    stats->expectTrue(types, "matrix_types");
+
+    // every type maps exactly like the full math, an odd count and in place included
+    const GMatrix matrices[] = {
+        GMatrix(), GMatrix(1, 0, 2.5f, 0, 1, -7.25f), GMatrix(3, 0, 0, 0, 0.5f, 0),
+        GMatrix(1.5f, 0, -4, 0, 2, 9), GMatrix(0.8f, -0.6f, 10, 0.6f, 0.8f, -3),
+    };
+    GRandom rand;
+    GPoint src[7], dst[7];
+    for (int i = 0; i < 7; ++i) {
+        src[i] = GPoint::Make(rand.nextF() * 200 - 100, rand.nextF() * 200 - 100);
+    }
+    bool mapped = true;
+    for (const GMatrix& matrix : matrices) {
+        matrix.mapPoints(dst, src, 7);
+        for (int i = 0; i < 7; ++i) {
+            float x = matrix[GMatrix::SX] * src[i].fX + matrix[GMatrix::KX] * src[i].fY + matrix[GMatrix::TX];
+            float y = matrix[GMatrix::KY] * src[i].fX + matrix[GMatrix::SY] * src[i].fY + matrix[GMatrix::TY];
+            mapped &= dst[i].fX == x && dst[i].fY == y;
+        }
+        GPoint in_place[7];
+        memcpy(in_place, src, sizeof(src));
+        matrix.mapPoints(in_place, in_place, 7);
+        mapped &= !memcmp(in_place, dst, sizeof(dst));
+    }
+    stats->expectTrue(mapped, "matrix_map_points");
+}
+
+// true if the pixels inside of rect are all inside, and the rest are outside
+static bool rect_pix_eq(const GBitmap& bitmap, const GIRect& rect, GPixel inside, GPixel outside) {
+    for (int y = 0; y < bitmap.height(); ++y) {
+        for (int x = 0; x < bitmap.width(); ++x) {
+            bool in = x >= rect.fLeft && x < rect.fRight && y >= rect.fTop && y < rect.fBottom;
+            if (*bitmap.getAddr(x, y) != (in ? inside : outside)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void test_stroker(GTestStats* stats) {
+    // one outline for an open contour, one for each side of a closed one, and the caps of one without a length
+    const GPoint zig[] = { { 5, 5 }, { 30, 25 }, { 30, 25 }, { 8, 40 }, { 35, 45 } };
+    const GPoint dot[] = { { 10, 10 }, { 10, 10 } };
+    const GContour contours[] = { { 5, zig, false }, { 5, zig, true }, { 2, dot, false } };
+    Stroker stroker;
+    GPaint stroke_paint;
+    stroke_paint.setStrokeWidth(4);
+    stroker.stroke(contours, 3, stroke_paint, 1);
+    stats->expectTrue(stroker.contour_count() == 4, "stroker_outlines");
+
+    // a translucent stroke that doubles back over itself blends every pixel just once
+    const int W = 40, H = 30;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    const GPoint back[] = { { 5, 10 }, { 35, 12 }, { 6, 14 }, { 20, 25 } };
+    GContour back_contour = { 4, back, false };
+    GPaint paint(GColor::MakeARGB(0.5f, 1, 0, 0));
+    paint.setStrokeWidth(6);
+    canvas->drawContours(&back_contour, 1, paint);
+    const GPixel half_red = GPixel_PackARGB(0x80, 0x80, 0, 0);
+    bool once = true;
+    int touched = 0;
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            GPixel pixel = *bitmap.getAddr(x, y);
+            once &= pixel == 0 || pixel == half_red;
+            touched += pixel != 0;
+        }
+    }
+    stats->expectTrue(once && touched > 0, "stroker_blend_once");
+
+    free(bitmap.pixels());
+}
+
+static void test_joins_caps(GTestStats* stats) {
+    // round joins and caps stay within the radius of the line, and get more chords when scaled up
+    const GPoint vee[] = { { 10, 10 }, { 30, 40 }, { 50, 10 } };
+    GContour contour = { 3, vee, false };
+    GPaint paint;
+    paint.setStrokeWidth(8);
+    paint.setStrokeJoin(GPaint::Join::kRound);
+    paint.setStrokeCap(GPaint::Cap::kRound);
+    Stroker stroker;
+    stroker.stroke(&contour, 1, paint, 1);
+    bool within = stroker.contour_count() == 1;
+    int small_count = stroker.contours()[0].fCount;
+    for (int i = 0; i < small_count; ++i) {
+        GPoint p = stroker.contours()[0].fPts[i];
+        float nearest = 1e9f;
+        for (int j = 0; j < 2; ++j) {
+            // distance to segment j
+            GPoint a = vee[j], b = vee[j + 1];
+            float dx = b.fX - a.fX, dy = b.fY - a.fY;
+            float t = ((p.fX - a.fX) * dx + (p.fY - a.fY) * dy) / (dx * dx + dy * dy);
+            t = std::min(std::max(t, 0.0f), 1.0f);
+            float ex = a.fX + t * dx - p.fX, ey = a.fY + t * dy - p.fY;
+            nearest = std::min(nearest, sqrtf(ex * ex + ey * ey));
+        }
+        within &= nearest <= 4.001f;
+    }
+    stats->expectTrue(within, "round_within_radius");
+    stroker.stroke(&contour, 1, paint, 8);
+    stats->expectTrue(stroker.contours()[0].fCount > small_count, "round_adapts_to_scale");
+
+    // the caps decide how far past the end a stroke goes
+    const int W = 40, H = 20;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    const GPoint line[] = { { 10, 10 }, { 30, 10 } };
+    contour = { 2, line, false };
+    paint.setColor(GColor::MakeARGB(1, 0, 0, 0));
+    const GPaint::Cap caps[] = { GPaint::Cap::kButt, GPaint::Cap::kRound, GPaint::Cap::kSquare };
+    bool capped = true;
+    for (GPaint::Cap cap : caps) {
+        clear(bitmap);
+        paint.setStrokeCap(cap);
+        canvas->drawContours(&contour, 1, paint);
+        bool past_end = *bitmap.getAddr(32, 10) != 0;
+        bool corner = *bitmap.getAddr(33, 7) != 0;
+        capped &= past_end == (cap != GPaint::Cap::kButt) && corner == (cap == GPaint::Cap::kSquare);
+    }
+    stats->expectTrue(capped, "caps");
+
+    // a bevel cuts the corner the miter keeps
+    const GPoint corner[] = { { 5, 15 }, { 20, 5 }, { 35, 15 } };
+    contour = { 3, corner, false };
+    paint.setStrokeCap(GPaint::Cap::kButt);
+    clear(bitmap);
+    paint.setStrokeJoin(GPaint::Join::kMiter);
+    canvas->drawContours(&contour, 1, paint);
+    bool mitered = *bitmap.getAddr(19, 1) != 0;
+    clear(bitmap);
+    paint.setStrokeJoin(GPaint::Join::kBevel);
+    canvas->drawContours(&contour, 1, paint);
+    stats->expectTrue(mitered && *bitmap.getAddr(19, 1) == 0 && *bitmap.getAddr(20, 3) != 0, "bevel_join");
+
+    // a line with no length is just its caps
+    const GPoint dot[] = { { 20, 10 }, { 20, 10 } };
+    contour = { 2, dot, false };
+    clear(bitmap);
+    paint.setStrokeCap(GPaint::Cap::kRound);
+    canvas->drawContours(&contour, 1, paint);
+    stats->expectTrue(*bitmap.getAddr(20, 10) != 0 && *bitmap.getAddr(16, 6) == 0, "round_dot");
+
+    free(bitmap.pixels());
+}
+
+static void test_dashes(GTestStats* stats) {
+    // the dashes come out one at a time, the pattern repeating along the contour
+    const GPoint line[] = { { 0, 0 }, { 100, 0 } };
+    GContour contour = { 2, line, false };
+    GPaint paint;
+    const float intervals[] = { 10, 5 };
+    paint.setDash(intervals, 2, 0);
+    Dasher dasher;
+    dasher.start(contour, paint);
+    GContour dash;
+    int count = 0;
+    bool placed = true;
+    while (dasher.next(&dash)) {
+        placed &= dash.fCount == 2 && fabs(dash.fPts[0].fX - count * 15) < 0.001f &&
+                  fabs(dash.fPts[1].fX - std::min(count * 15 + 10, 100)) < 0.001f;
+        ++count;
+    }
+    stats->expectTrue(placed && count == 7, "dash_pattern");
+
+    // the phase starts partway into the pattern, and a dash goes around corners
+    const GPoint corner[] = { { 0, 0 }, { 10, 0 }, { 10, 10 } };
+    contour = { 3, corner, false };
+    paint.setDash(intervals, 2, 12);
+    dasher.start(contour, paint);
+    bool first = dasher.next(&dash) && dash.fCount == 3 && fabs(dash.fPts[0].fX - 3) < 0.001f &&
+                 dash.fPts[1].fX == 10 && fabs(dash.fPts[2].fY - 3) < 0.001f;
+    stats->expectTrue(first, "dash_phase_corner");
+
+    // bad patterns are solid
+    const float bad[] = { 1, -1 };
+    paint.setDash(bad, 2, 0);
+    bool solid = !paint.isDashed();
+    paint.setDash(intervals, 1, 0);
+    solid &= !paint.isDashed();
+    stats->expectTrue(solid, "dash_invalid");
+
+    // dashed hairlines on a row
+    const int W = 30, H = 4;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    const float short_intervals[] = { 4, 3 };
+    paint.setDash(short_intervals, 2, 0);
+    paint.setStrokeWidth(1);
+    const GPoint row[] = { { 0, 1.5f }, { 30, 1.5f } };
+    contour = { 2, row, false };
+    canvas->drawContours(&contour, 1, paint);
+    bool dashed = true;
+    for (int x = 0; x < W; ++x) {
+        dashed &= (*bitmap.getAddr(x, 1) != 0) == (x % 7 < 4);
+    }
+    stats->expectTrue(dashed, "dash_hairline");
+
+    free(bitmap.pixels());
+}
+
+static void test_path_curves(GTestStats* stats) {
+    // every line stays within the tolerance of the curve, and ends on its last point
+    GPath quad;
+    quad.moveTo(0, 0).quadTo(50, 100, 100, 0);
+    bool close_enough = true;
+    int fine_count = 0;
+    for (float tolerance : { 0.25f, 4.0f }) {
+        GPath::Iter iter(quad, tolerance);
+        GContour contour;
+        close_enough &= iter.next(&contour);
+        int n = contour.fCount - 1;
+        for (int i = 0; i < n; ++i) {
+            float t = (i + 0.5f) / n;
+            float x = 100 * t, y = 200 * t * (1 - t);
+            float mid_x = (contour.fPts[i].fX + contour.fPts[i + 1].fX) / 2;
+            float mid_y = (contour.fPts[i].fY + contour.fPts[i + 1].fY) / 2;
+            close_enough &= sqrt((x - mid_x) * (x - mid_x) + (y - mid_y) * (y - mid_y)) <= tolerance;
+        }
+        close_enough &= contour.fPts[n].fX == 100 && contour.fPts[n].fY == 0 && !iter.next(&contour);
+        if (fine_count == 0) {
+            fine_count = contour.fCount;
+        } else {
+            // looser is fewer lines
+            close_enough &= contour.fCount < fine_count;
+        }
+    }
+    stats->expectTrue(close_enough, "path_quad_tolerance");
+
+    // paths of lines still come back as their own points
+    GPath lines;
+    lines.moveTo(1, 2).lineTo(3, 4).lineTo(5, 6).moveTo(7, 8).lineTo(9, 10);
+    GPath::Iter iter(lines);
+    GContour first, second, none;
+    bool same = iter.next(&first) && iter.next(&second) && !iter.next(&none);
+    same &= first.fCount == 3 && first.fPts[2].fX == 5 && second.fCount == 2 && second.fPts[1].fY == 10;
+    stats->expectTrue(same, "path_lines");
+
+    // flatten() appends the same lines as Iter, one contour after another
+    GPath mixed;
+    mixed.moveTo(0, 0).quadTo(10, 20, 30, 0).lineTo(30, 30).moveTo(50, 50).moveTo(5, 5)
+         .cubicTo(9, 0, 20, 0, 20, 15);
+    std::vector<GPoint> flat;
+    std::vector<GContour> flat_ctrs;
+    mixed.flatten(0.1f, &flat, &flat_ctrs);
+    GPath::Iter mixed_iter(mixed, 0.1f);
+    GContour ctr;
+    size_t index = 0, at = 0;
+    bool matches = true;
+    for (; mixed_iter.next(&ctr); ++index) {
+        matches &= index < flat_ctrs.size() && flat_ctrs[index].fCount == ctr.fCount;
+        for (int i = 0; matches && i < ctr.fCount; ++i, ++at) {
+            matches &= flat[at].fX == ctr.fPts[i].fX && flat[at].fY == ctr.fPts[i].fY;
+        }
+    }
+    matches &= index == 2 && flat_ctrs.size() == 2 && at == flat.size();
+    stats->expectTrue(matches, "path_flatten");
+
+    // a circle of 4 cubics, zoomed out, fills like a many sided polygon
+    const int W = 64, H = 64;
+    GBitmap curved, polygon;
+    setup_bitmap(&curved, W, H);
+    setup_bitmap(&polygon, W, H);
+    const float k = 0.5522847f * 300;
+    GPath circle;
+    circle.moveTo(300, 0).cubicTo(300, k, k, 300, 0, 300).cubicTo(-k, 300, -300, k, -300, 0)
+          .cubicTo(-300, -k, -k, -300, 0, -300).cubicTo(k, -300, 300, -k, 300, 0);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(curved));
+    canvas->translate(32, 32);
+    canvas->scale(0.1f, 0.1f);
+    canvas->drawPath(circle, GPaint(GColor::MakeARGB(1, 0, 0, 1)));
+    GPoint ring[256];
+    for (int i = 0; i < 256; ++i) {
+        ring[i] = { 300 * cosf(i * 6.2831853f / 256), 300 * sinf(i * 6.2831853f / 256) };
+    }
+    GContour ring_ctr = { 256, ring, true };
+    canvas.reset(GCanvas::Create(polygon));
+    canvas->translate(32, 32);
+    canvas->scale(0.1f, 0.1f);
+    canvas->drawContours(&ring_ctr, 1, GPaint(GColor::MakeARGB(1, 0, 0, 1)));
+    // only pixels with centers within a quarter pixel of the circle can come out differently
+    bool near_edge = true;
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            if (*curved.getAddr(x, y) != *polygon.getAddr(x, y)) {
+                float dx = x + 0.5f - 32, dy = y + 0.5f - 32;
+                near_edge &= fabs(sqrt(dx * dx + dy * dy) - 30) <= 0.25f;
+            }
+        }
+    }
+    stats->expectTrue(near_edge && *curved.getAddr(32, 32) != 0 && *curved.getAddr(32, 63) == 0, "path_circle");
+
+    free(curved.pixels());
+    free(polygon.pixels());
+}
+
+static void test_hairlines(GTestStats* stats) {
+    const int W = 40, H = 30;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    const GPixel red = GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    GPaint paint(GColor::MakeARGB(1, 1, 0, 0));
+    paint.setStrokeWidth(1);
+
+    // a flat line is the row it is on, over the columns whose centers it covers
+    const GPoint flat[] = { { 3.2f, 10.7f }, { 20.6f, 10.7f } };
+    GContour contour = { 2, flat, false };
+    canvas->drawContours(&contour, 1, paint);
+    stats->expectTrue(rect_pix_eq(bitmap, GIRect::MakeLTRB(3, 10, 21, 11), red, 0), "hairline_flat");
+
+    // a thin stroke scaled up past a pixel is filled as an outline instead
+    clear(bitmap);
+    canvas->save();
+    canvas->scale(4, 4);
+    const GPoint tall[] = { { 2, 1 }, { 2, 6 } };
+    contour = { 2, tall, false };
+    canvas->drawContours(&contour, 1, paint);
+    canvas->restore();
+    stats->expectTrue(rect_pix_eq(bitmap, GIRect::MakeLTRB(6, 2, 10, 26), red, 0), "hairline_scaled_outline");
+
+    // a diagonal one gets a pixel on every row (and column) it crosses, one pixel per row
+    clear(bitmap);
+    const GPoint diagonal[] = { { 2, 2 }, { 27, 22 } };
+    contour = { 2, diagonal, false };
+    canvas->drawContours(&contour, 1, paint);
+    bool one_per_column = true;
+    for (int x = 0; x < W; ++x) {
+        int count = 0;
+        for (int y = 0; y < H; ++y) {
+            count += *bitmap.getAddr(x, y) == red;
+        }
+        one_per_column &= count == (x >= 2 && x < 27 ? 1 : 0);
+    }
+    stats->expectTrue(one_per_column, "hairline_diagonal");
+
+    // anti-aliased, half a pixel wide and halfway between two rows, is a quarter on each
+    clear(bitmap);
+    paint.setStrokeWidth(0.5f);
+    paint.setAntiAlias(true);
+    const GPoint between[] = { { 5, 12 }, { 15, 12 } };
+    contour = { 2, between, false };
+    canvas->drawContours(&contour, 1, paint);
+    GPixel quarter = *bitmap.getAddr(8, 11);
+    stats->expectTrue(GPixel_GetA(quarter) >= 0x3F && GPixel_GetA(quarter) <= 0x41 &&
+                      *bitmap.getAddr(8, 12) == quarter && *bitmap.getAddr(8, 13) == 0 &&
+                      *bitmap.getAddr(15, 12) == 0, "hairline_antialiased");
+
+    free(bitmap.pixels());
+}
+
+static void test_clip(GTestStats* stats) {
+    const int W = 40, H = 30;
+    GBitmap bitmap;
+    setup_bitmap(&bitmap, W, H);
+    std::unique_ptr<GCanvas> canvas(GCanvas::Create(bitmap));
+    const GPixel red = GPixel_PackARGB(0xFF, 0xFF, 0, 0);
+    const GPixel blue = GPixel_PackARGB(0xFF, 0, 0, 0xFF);
+    const GColor red_color = GColor::MakeARGB(1, 1, 0, 0);
+    const GRect everything = GRect::MakeWH(W, H);
+
+    // rects clip to the pixels whose centers they hold, and intersect
+    canvas->save();
+    canvas->translate(2, 0);
+    canvas->clipRect(GRect::MakeLTRB(3.4f, 5.6f, 20.4f, 22));
+    canvas->clipRect(GRect::MakeLTRB(0, 0, 100, 18));
+    canvas->fillRect(everything, red_color);
+    stats->expectTrue(rect_pix_eq(bitmap, GIRect::MakeLTRB(5, 6, 22, 18), red, 0), "clip_rect");
+
+    // and they hold for a clear too, until the restore
+    canvas->clear(GColor::MakeARGB(1, 0, 0, 1));
+    stats->expectTrue(rect_pix_eq(bitmap, GIRect::MakeLTRB(5, 6, 22, 18), blue, 0), "clip_rect_clear");
+    canvas->restore();
+    canvas->fillRect(everything, red_color);
+    stats->expectTrue(rect_pix_eq(bitmap, GIRect::MakeWH(W, H), red, 0), "clip_restore");
+
+    // a path clip keeps just the pixels the path would fill, a turned rect is a path
+    GBitmap filled;
+    setup_bitmap(&filled, W, H);
+    std::unique_ptr<GCanvas> fill_canvas(GCanvas::Create(filled));
+    const GPoint tri[] = { { 3, 2 }, { 37, 9 }, { 12, 28 } };
+    GContour contour = { 3, tri, true };
+    fill_canvas->drawContours(&contour, 1, GPaint(red_color));
+
+    clear(bitmap);
+    canvas->save();
+    canvas->clipPath(GPath().moveTo(tri[0]).lineTo(tri[1]).lineTo(tri[2]));
+    canvas->fillRect(everything, red_color);
+    canvas->restore();
+    stats->expectTrue(!memcmp(bitmap.pixels(), filled.pixels(), bitmap.rowBytes() * H), "clip_path");
+
+    clear(bitmap);
+    clear(filled);
+    canvas->save();
+    canvas->rotate(0.3f);
+    canvas->clipRect(GRect::MakeLTRB(10, -5, 30, 15));
+    canvas->clipPath(GPath().moveTo(tri[0]).lineTo(tri[1]).lineTo(tri[2]));
+    canvas->clear(GColor::MakeARGB(1, 1, 0, 0));
+    canvas->restore();
+    fill_canvas->save();
+    fill_canvas->rotate(0.3f);
+    fill_canvas->fillRect(GRect::MakeLTRB(10, -5, 30, 15), red_color);
+    fill_canvas->restore();
+    bool inside_both = true;
+    bool any = false;
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            // only pixels inside of the turned rect, which draws the same as the clip
+            GPixel pixel = *bitmap.getAddr(x, y);
+            inside_both &= pixel == 0 || *filled.getAddr(x, y) == red;
+            any |= pixel == red;
+        }
+    }
+    stats->expectTrue(inside_both && any, "clip_path_in_rect");
+
+    // nothing is left after clipping to something empty
+    clear(bitmap);
+    canvas->save();
+    canvas->clipRect(GRect::MakeLTRB(5, 5, 20, 20));
+    canvas->clipPath(GPath().moveTo(25, 5).lineTo(35, 5).lineTo(30, 20));
+    canvas->clear(red_color);
+    canvas->restore();
+    stats->expectTrue(is_filled_with(bitmap, 0), "clip_empty");
+
+    free(bitmap.pixels());
+    free(filled.pixels());
+}
+
 const GTestRec gTestRecs[] = {
     { test_bad_input,   "bad_input"     },
 
@@ -399,6 +2073,33 @@ const GTestRec gTestRecs[] = {
 
     { test_matrix,  "matrix" },
 
+    { test_blend_modes, "blend_modes" },
+    { test_srcover_kernels, "srcover_kernels" },
+    { test_antialias,   "antialias" },
+    { test_fixed_point_edges, "fixed_point_edges" },
+    { test_tiled_canvas, "tiled_canvas" },
+    { test_far_geometry, "far_geometry" },
+    { test_recording_canvas, "recording_canvas" },
+    { test_active_edges, "active_edges" },
+    { test_edge_sort, "edge_sort" },
+    { test_steady_state_allocs, "steady_state_allocs" },
+    { test_rect_fast_path, "rect_fast_path" },
+    { test_bitmap_filters, "bitmap_filters" },
+    { test_mipmap, "mipmap" },
+    { test_bitmap_row_procs, "bitmap_row_procs" },
+    { test_radial_gradient, "radial_gradient" },
+    { test_linear_gradient_stops, "linear_gradient_stops" },
+    { test_sweep_conical_gradients, "sweep_conical_gradients" },
+    { test_mesh_rasterizer, "mesh_rasterizer" },
+    { test_quad_patch, "quad_patch" },
+    { test_matrix_types, "matrix_types" },
+    { test_clip, "clip" },
+    { test_stroker, "stroker" },
+    { test_hairlines, "hairlines" },
+    { test_joins_caps, "joins_caps" },
+    { test_dashes, "dashes" },
+    { test_path_curves, "path_curves" },
+
     { NULL, NULL },
 };
 
@@ -0,0 +1,41 @@
+/*
+ *  Copyright 2016 Mike Reed
+ */
+
+#ifndef GBlendMode_DEFINED
+#define GBlendMode_DEFINED
+
+/**
+ *  How a paint's source color (S, Sa) is combined with the destination pixel (D, Da).
+ *  All colors are premultiplied, and each formula is applied to all 4 components.
+ */
+enum class GBlendMode {
+    kClear,         //!< 0
+    kSrc,           //!< S
+    kDst,           //!< D
+    kSrcOver,       //!< S + D*(1 - Sa)
+    kDstOver,       //!< D + S*(1 - Da)
+    kSrcIn,         //!< S*Da
+    kDstIn,         //!< D*Sa
+    kSrcOut,        //!< S*(1 - Da)
+    kDstOut,        //!< D*(1 - Sa)
+    kSrcATop,       //!< S*Da + D*(1 - Sa)
+    kDstATop,       //!< D*Sa + S*(1 - Da)
+    kXor,           //!< S*(1 - Da) + D*(1 - Sa)
+    kPlus,          //!< min(S + D, 1)
+
+    // separable modes, each alpha comes out as Sa + Da - Sa*Da
+
+    kMultiply,      //!< S*(1 - Da) + D*(1 - Sa) + S*D
+    kScreen,        //!< S + D - S*D
+    kOverlay,       //!< kHardLight with S and D swapped
+    kDarken,        //!< S + D - max(S*Da, D*Sa)
+    kLighten,       //!< S + D - min(S*Da, D*Sa)
+    kHardLight,     //!< S*(1 - Da) + D*(1 - Sa) + (2*S <= Sa ? 2*S*D : Sa*Da - 2*(Da - D)*(Sa - S))
+    kDifference,    //!< S + D - 2*min(S*Da, D*Sa)
+    kExclusion,     //!< S + D - 2*S*D
+
+    kLastMode = kExclusion,
+};
+
+#endif
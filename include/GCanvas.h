@@ -12,6 +12,7 @@
 class GBitmap;
 class GColor;
 class GMatrix;
+class GPath;
 class GPoint;
 class GRect;
 
@@ -19,6 +20,16 @@ class GCanvas {
 public:
     static GCanvas* Create(const GBitmap&);
 
+    /**
+     *  Return a canvas that records its draws and rasterizes them in screen tiles, spread
+     *  across threadCount threads (including the caller's). The pixels come out exactly the
+     *  same as the canvas from Create().
+     *
+     *  Drawing is deferred until flush() (or the canvas is deleted), so any shader or bitmap
+     *  passed to a draw must stay alive until then.
+     */
+    static GCanvas* CreateTiled(const GBitmap&, int threadCount);
+
     virtual ~GCanvas() {}
 
     /**
@@ -52,6 +63,12 @@ public:
      *  restore()
      */
     virtual void restore() = 0;
+
+    /**
+     *  Finish any drawing the canvas has deferred, so the bitmap holds every draw made so far.
+     *  Canvases that draw immediately have nothing to do here.
+     */
+    virtual void flush() {}
     
     /**
      *  Modifies the CTM (current transformation matrix) by pre-concatenating it with the specfied
@@ -79,6 +96,23 @@ public:
      */
     void rotate(float radians);
 
+    /**
+     *  Intersect the current clip with the rect, transformed by the CTM. Nothing outside of the
+     *  clip is drawn (or cleared). Like the CTM, the clip is saved by save() and put back by the
+     *  matching restore().
+     *
+     *  A rect that the CTM keeps axis aligned clips to the pixels whose centers it contains.
+     *  Otherwise it clips the same as the path of its 4 corners would.
+     */
+    virtual void clipRect(const GRect&) {}
+
+    /**
+     *  Intersect the current clip with the inside of the path, transformed by the CTM. Every
+     *  contour is treated as closed, and a pixel is inside when its center would be filled by
+     *  drawContours() with the same contours.
+     */
+    virtual void clipPath(const GPath&) {}
+
     //////////
 
     /**
@@ -105,7 +139,7 @@ public:
      *
      *  Any area in the rectangle that is outside of the bounds of the canvas is ignored.
      *
-     *  Draws using SRCOVER blend mode.
+     *  Draws using the paint's blend mode (SRCOVER by default).
      */
     virtual void drawRect(const GRect&, const GPaint&) = 0;
     
@@ -115,7 +149,7 @@ public:
      *
      *  Any area in the polygon that is outside of the bounds of the canvas is ignored.
      *
-     *  Draws using SRCOVER blend mode.
+     *  Draws using the paint's blend mode (SRCOVER by default).
      */
     virtual void drawConvexPolygon(const GPoint[], int count, const GPaint&) = 0;
 
@@ -132,6 +166,14 @@ public:
      */
     virtual void drawContours(const GContour ctrs[], int count, const GPaint&) = 0;
 
+    /**
+     *  Draw the path's contours just like drawContours() would. Curves are first cut into lines,
+     *  as few as keep them within a fraction of a pixel once transformed by the CTM.
+     *
+     *  By default, without knowing the CTM, they are kept within a quarter of the path's units.
+     */
+    virtual void drawPath(const GPath&, const GPaint&);
+
     /**
      *  Draw a mesh of triangles, each with optional colors and/or text-coordinates at each
      *  vertex.
@@ -195,8 +237,10 @@ public:
      *      - (u,v) .. (u+du, v+dv)
      *      - this is conceptually the diagonal from left,top to right,bottom
      *  This is not more accurate, but it will match the expected images for the final.
+     *
+     *  By default the mesh is made with QuadPatch and drawn with drawMesh().
      */
-    virtual void drawQuadPatch(const GPoint pts[4], const GColor colors[4], int stripCount) {}
+    virtual void drawQuadPatch(const GPoint pts[4], const GColor colors[4], int stripCount);
 
     /**
      *  Return a radial-gradient shader.
@@ -16,6 +16,7 @@ public:
     GMatrix(float a, float b, float c, float d, float e, float f) {
         fMat[0] = a;    fMat[1] = b;    fMat[2] = c;
         fMat[3] = d;    fMat[4] = e;    fMat[5] = f;
+        fTypeMask = kUnknown_Mask;
     }
 
     enum {
@@ -27,6 +28,28 @@ public:
         return fMat[index];
     }
 
+    enum TypeMask {
+        kIdentity_Mask  = 0,
+        kTranslate_Mask = 1 << 0,   // TX or TY is not 0
+        kScale_Mask     = 1 << 1,   // SX or SY is not 1
+        kAffine_Mask    = 1 << 2,   // KX or KY is not 0
+    };
+
+    /**
+     *  Return the TypeMask bits for what this matrix does to points. It is worked out the
+     *  first time it is asked for and remembered until the matrix changes.
+     *
+     *  Note: the first call writes to the matrix, so it should not race with other threads
+     *  using the same matrix. mapPoints() only reads what is remembered (working it out on the
+     *  side when nothing is), so it stays safe to call from several threads at once.
+     */
+    unsigned getType() const {
+        if (fTypeMask == kUnknown_Mask) {
+            fTypeMask = this->computeType();
+        }
+        return fTypeMask;
+    }
+
     /**
      *  Set this matrix to identity.
      */
@@ -61,6 +84,7 @@ public:
     void set6(float a, float b, float c, float d, float e, float f) {
         fMat[0] = a;    fMat[1] = b;    fMat[2] = c;
         fMat[3] = d;    fMat[4] = e;    fMat[5] = f;
+        fTypeMask = kUnknown_Mask;
     }
 
     /*
@@ -78,6 +102,9 @@ public:
      *
      *  GPoint pts[] = { ... };
      *  matrix.mapPoints(pts, pts, count);
+     *
+     *  The points are mapped with a routine picked for the matrix's type, and each one comes out
+     *  exactly the same as (SX*x + KX*y) + TX, (KY*x + SY*y) + TY would.
      */
     void mapPoints(GPoint dst[], const GPoint src[], int count) const;
 
@@ -167,7 +194,14 @@ public:
     }
 
 private:
+    enum {
+        kUnknown_Mask = 0x80,
+    };
+
+    unsigned computeType() const;
+
     float fMat[6];
+    mutable unsigned char fTypeMask;
 };
 
 #endif
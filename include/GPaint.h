@@ -5,6 +5,7 @@
 #ifndef GPaint_DEFINED
 #define GPaint_DEFINED
 
+#include "GBlendMode.h"
 #include "GColor.h"
 
 class GShader;
@@ -39,7 +40,7 @@ public:
      *  Return the paint's stroke width. If this is < 0, then "fill" the geometry rather
      *  than stroke it.
      *
-     *  When stroking, use a miter-join (subject to MiterLimit) and square-caps.
+     *  When stroking, the corners use the paint's join and the ends of open contours use its cap.
      */
     float getStrokeWidth() const { return fWidth; }
     void setStrokeWidth(float w) { fWidth = w; }
@@ -51,11 +52,87 @@ public:
     float getMiterLimit() const { return fMiterLimit; }
     void setMiterLimit(float limit) { fMiterLimit = limit; }
 
+    /**
+     *  How a stroke turns the corner between two segments: out to a point (subject to the
+     *  MiterLimit), around an arc, or straight across. Defaults to kMiter.
+     */
+    enum class Join {
+        kMiter,
+        kRound,
+        kBevel,
+    };
+    Join getStrokeJoin() const { return fJoin; }
+    void setStrokeJoin(Join join) { fJoin = join; }
+
+    /**
+     *  How a stroke ends at either end of an open contour: right at the end point, with a half
+     *  circle around it, or with a half square past it. Defaults to kSquare.
+     *
+     *  A contour with no length still draws its caps, as a circle or a square (but nothing if kButt).
+     */
+    enum class Cap {
+        kButt,
+        kRound,
+        kSquare,
+    };
+    Cap getStrokeCap() const { return fCap; }
+    void setStrokeCap(Cap cap) { fCap = cap; }
+
+    /**
+     *  Stroke in dashes instead of one solid line. The intervals alternate between the length
+     *  of a dash and the length of the gap after it, and the pattern starts phase along into
+     *  them. Each dash gets the paint's caps, and the pattern starts over on every contour.
+     *
+     *  The count has to be even and at most kMaxDashIntervals, and the intervals >= 0 with
+     *  more than 0 in all, otherwise (or with a count of 0) the stroke is solid.
+     */
+    enum {
+        kMaxDashIntervals = 8,
+    };
+    void setDash(const float intervals[], int count, float phase) {
+        float sum = 0;
+        bool valid = count > 0 && count <= kMaxDashIntervals && (count & 1) == 0;
+        for (int i = 0; valid && i < count; ++i) {
+            valid = intervals[i] >= 0;
+            sum += intervals[i];
+        }
+        fDashCount = (valid && sum > 0) ? count : 0;
+        for (int i = 0; i < fDashCount; ++i) {
+            fDashIntervals[i] = intervals[i];
+        }
+        fDashPhase = phase;
+    }
+    bool isDashed() const { return fDashCount > 0; }
+    int getDashCount() const { return fDashCount; }
+    const float* getDashIntervals() const { return fDashIntervals; }
+    float getDashPhase() const { return fDashPhase; }
+
+    /**
+     *  How the paint's color (or shader's colors) are combined with the pixels already in the
+     *  canvas. Defaults to kSrcOver.
+     */
+    GBlendMode getBlendMode() const { return fBlendMode; }
+    void setBlendMode(GBlendMode mode) { fBlendMode = mode; }
+
+    /**
+     *  If true, edges of filled (and stroked) geometry are drawn with partial coverage
+     *  instead of snapping to whole pixels. Defaults to false.
+     */
+    bool isAntiAlias() const { return fAntiAlias; }
+    void setAntiAlias(bool aa) { fAntiAlias = aa; }
+
 private:
     GColor      fColor;
     GShader*    fShader;
     float       fWidth = -1;
     float       fMiterLimit = 4;
+    Join        fJoin = Join::kMiter;
+    Cap         fCap = Cap::kSquare;
+    int         fDashCount = 0;
+    float       fDashIntervals[kMaxDashIntervals];
+    float       fDashPhase = 0;
+    GBlendMode  fBlendMode = GBlendMode::kSrcOver;
+    bool        fAntiAlias = false;
 };
 
 #endif
@@ -11,29 +11,53 @@
 struct GContour;
 
 class GPath {
+public:
     enum class Verb {
         kMove,
         kLine,
+        kQuad,      // 2 points: the control point and the end
+        kCubic,     // 3 points: both control points and the end
     };
 
-public:
     GPath() {}
 
     GPath& moveTo(const GPoint&);
     GPath& lineTo(const GPoint&);
+    GPath& quadTo(const GPoint& p1, const GPoint& p2);
+    GPath& cubicTo(const GPoint& p1, const GPoint& p2, const GPoint& p3);
 
     GPath& moveTo(float x, float y) { return this->moveTo({x, y}); }
     GPath& lineTo(float x, float y) { return this->lineTo({x, y}); }
+    GPath& quadTo(float x1, float y1, float x2, float y2) {
+        return this->quadTo({x1, y1}, {x2, y2});
+    }
+    GPath& cubicTo(float x1, float y1, float x2, float y2, float x3, float y3) {
+        return this->cubicTo({x1, y1}, {x2, y2}, {x3, y3});
+    }
+
+    /**
+     *  Append every contour to pts as lines, curves flattened just as Iter does, and one GContour
+     *  for it to ctrs. Each contour's points follow the last one's in pts, and their fPts are
+     *  left null since pts can still move as it grows.
+     */
+    void flatten(float tolerance, std::vector<GPoint>* pts, std::vector<GContour>* ctrs) const;
 
+    /**
+     *  Returns each contour as lines. Curves are flattened so that no point on them is farther
+     *  than tolerance from the lines that replace them. Contours without curves point straight
+     *  at the path's points, the others at storage in the iterator that the next call reuses.
+     */
     class Iter {
     public:
-        Iter(const GPath&);
+        Iter(const GPath&, float tolerance = 0.25f);
         bool next(GContour*);
 
     private:
         const GPoint* fPts;
         const GPath::Verb*  fVerbs;
         const GPath::Verb*  fStopVerbs;
+        float               fTolerance;
+        std::vector<GPoint> fStorage;
     };
 
     void dump() const;
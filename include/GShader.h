@@ -23,6 +23,22 @@ public:
         kMirror,
     };
 
+    /**
+     *  How a bitmap shader samples its bitmap.
+     *
+     *  kNearest   - the pixel under the sample point (fastest)
+     *  kBilinear  - a blend of the 2x2 pixels around the sample point
+     *  kBicubic   - a cubic (Mitchell) filter over the 4x4 pixels around the sample point
+     *  kTrilinear - bilinear in the two mip levels around how far the bitmap is shrunk, blended
+     *               together (for drawing it much smaller, the levels are made on first use)
+     */
+    enum FilterQuality {
+        kNearest,
+        kBilinear,
+        kBicubic,
+        kTrilinear,
+    };
+
     virtual ~GShader() {}
 
     /**
@@ -44,10 +60,49 @@ public:
      *  Return a subclass of GShader that draws the specified bitmap and local-matrix.
      *  Returns null if the either parameter is not valid.
      */
-    static GShader* FromBitmap(const GBitmap&, const GMatrix& localMatrix, TileMode = kClamp);
+    static GShader* FromBitmap(const GBitmap&, const GMatrix& localMatrix, TileMode = kClamp,
+                               FilterQuality = kNearest);
 
     static GShader* LinearGradient(const GPoint& p0, const GPoint& p1,
                                    const GColor& c0, const GColor& c1, TileMode = kClamp);
+
+    /**
+     *  Return a linear gradient from p0 to p1 with count colors. colors[i] sits at positions[i]
+     *  along the way, where 0 is p0 and 1 is p1. The positions should go up from 0 to 1, they
+     *  get pinned to that (two at the same position make a hard edge). Before the first position
+     *  and after the last the end colors are kept. If positions is null the colors are spaced
+     *  evenly. Returns null if count < 1.
+     */
+    static GShader* LinearGradient(const GPoint& p0, const GPoint& p1, const GColor colors[],
+                                   const float positions[], int count, TileMode = kClamp);
+
+    /**
+     *  Return a radial gradient with colors[0] at center and colors[count - 1] at radius,
+     *  spaced evenly in between (see GCanvas::makeRadialGradient). Past the radius the
+     *  tile mode clamps to the last color, or repeats/mirrors the colors ring after ring.
+     *  Returns null if count < 1 or radius <= 0.
+     */
+    static GShader* RadialGradient(const GPoint& center, float radius,
+                                   const GColor colors[], int count, TileMode = kClamp);
+
+    /**
+     *  Return a sweep (conic) gradient around center. The colors go around one full turn,
+     *  starting at the +x axis and heading towards +y, with positions as in LinearGradient
+     *  (0 and 1 are both at the +x axis). Returns null if count < 1.
+     */
+    static GShader* SweepGradient(const GPoint& center, const GColor colors[],
+                                  const float positions[], int count);
+
+    /**
+     *  Return a gradient along the cone of circles from (p0, r0) at position 0 to (p1, r1) at
+     *  position 1, with positions as in LinearGradient. Each pixel gets the largest position
+     *  whose circle passes through it with a radius >= 0; pixels no such circle passes through
+     *  are transparent. Returns null if count < 1, a radius is negative, or the circles are
+     *  the same.
+     */
+    static GShader* TwoPointConicalGradient(const GPoint& p0, float r0, const GPoint& p1, float r1,
+                                            const GColor colors[], const float positions[], int count,
+                                            TileMode = kClamp);
 };
 
 #endif
@@ -4,6 +4,9 @@
 
 #include "GCanvas.h"
 #include "GMatrix.h"
+#include "GPaint.h"
+#include "../PathFlattener.hpp"
+#include "../QuadPatch.hpp"
 
 void GCanvas::translate(float tx, float ty) {
     GMatrix m;
@@ -22,3 +25,22 @@ void GCanvas::rotate(float radians) {
     m.setRotate(radians);
     this->concat(m);
 }
+
+void GCanvas::drawPath(const GPath& path, const GPaint& paint) {
+    // the base canvas does not know its ctm, so the curves are cut to a quarter of the path's
+    // own units, with a flattener per thread keeping its buffers between paths
+    static thread_local PathFlattener flattener;
+    flattener.flatten(path, GMatrix());
+    this->drawContours(flattener.contours(), flattener.contour_count(), paint);
+}
+
+void GCanvas::drawQuadPatch(const GPoint pts[4], const GColor colors[4], int stripCount) {
+    // every canvas draws a patch as a mesh, with the layouts kept per thread so canvases
+    // drawing on different threads never share them
+    static thread_local QuadPatch patch;
+    if (!patch.tessellate(pts, colors, stripCount)) {
+        return;
+    }
+    this->drawMesh(patch.triangle_count(), patch.points(), patch.indices(), patch.colors(), nullptr,
+                   GPaint());
+}
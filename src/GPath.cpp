@@ -4,6 +4,70 @@
 
 #include "GContour.h"
 #include "GPath.h"
+#include <algorithm>
+#include <cmath>
+
+// however tight the tolerance, a curve is never cut into more lines than this
+static const int kMaxCurveSegments = 1 << 10;
+
+static int point_count(GPath::Verb verb) {
+    switch (verb) {
+        case GPath::Verb::kQuad:  return 2;
+        case GPath::Verb::kCubic: return 3;
+        default:                  return 1;
+    }
+}
+
+static float length(float dx, float dy) {
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+/*
+ *  Wang's formula: cutting a degree n curve into N equal steps of t keeps every line within
+ *  n(n-1)/8 * max|second difference of its points| / N^2 of the curve. weighted_dd is that
+ *  first factor times the second differences, so N comes from it and the tolerance.
+ */
+static int segment_count(float weighted_dd, float tolerance) {
+    float n = std::ceil(std::sqrt(weighted_dd / tolerance));
+    if (!(n < kMaxCurveSegments)) {
+        // also catches a tolerance of 0 or points that are not finite
+        return kMaxCurveSegments;
+    }
+    return std::max((int)n, 1);
+}
+
+// append the lines for the quad after p0 (which is already there), ending exactly on p2
+static void flatten_quad(const GPoint p[3], float tolerance, std::vector<GPoint>* out) {
+    float ddx = p[0].fX - 2 * p[1].fX + p[2].fX;
+    float ddy = p[0].fY - 2 * p[1].fY + p[2].fY;
+    int n = segment_count(length(ddx, ddy) / 4, tolerance);
+
+    // (A t + B) t + C
+    float bx = 2 * (p[1].fX - p[0].fX), by = 2 * (p[1].fY - p[0].fY);
+    for (int i = 1; i < n; ++i) {
+        float t = (float)i / n;
+        out->push_back({ (ddx * t + bx) * t + p[0].fX, (ddy * t + by) * t + p[0].fY });
+    }
+    out->push_back(p[2]);
+}
+
+// append the lines for the cubic after p0 (which is already there), ending exactly on p3
+static void flatten_cubic(const GPoint p[4], float tolerance, std::vector<GPoint>* out) {
+    float dd0 = length(p[0].fX - 2 * p[1].fX + p[2].fX, p[0].fY - 2 * p[1].fY + p[2].fY);
+    float dd1 = length(p[1].fX - 2 * p[2].fX + p[3].fX, p[1].fY - 2 * p[2].fY + p[3].fY);
+    int n = segment_count(std::max(dd0, dd1) * 3 / 4, tolerance);
+
+    // ((A t + B) t + C) t + D
+    float ax = p[3].fX - 3 * p[2].fX + 3 * p[1].fX - p[0].fX;
+    float ay = p[3].fY - 3 * p[2].fY + 3 * p[1].fY - p[0].fY;
+    float bx = 3 * (p[2].fX - 2 * p[1].fX + p[0].fX), by = 3 * (p[2].fY - 2 * p[1].fY + p[0].fY);
+    float cx = 3 * (p[1].fX - p[0].fX), cy = 3 * (p[1].fY - p[0].fY);
+    for (int i = 1; i < n; ++i) {
+        float t = (float)i / n;
+        out->push_back({ ((ax * t + bx) * t + cx) * t + p[0].fX, ((ay * t + by) * t + cy) * t + p[0].fY });
+    }
+    out->push_back(p[3]);
+}
 
 GPath& GPath::moveTo(const GPoint& pt) {
     if (fVerbs.size() > 0 && fVerbs.back() == Verb::kMove) {
@@ -22,7 +86,61 @@ GPath& GPath::lineTo(const GPoint& pt) {
     return *this;
 }
 
-GPath::Iter::Iter(const GPath& path) {
+GPath& GPath::quadTo(const GPoint& p1, const GPoint& p2) {
+    GASSERT(fVerbs.size() > 0);
+    fPts.push_back(p1);
+    fPts.push_back(p2);
+    fVerbs.push_back(Verb::kQuad);
+    return *this;
+}
+
+GPath& GPath::cubicTo(const GPoint& p1, const GPoint& p2, const GPoint& p3) {
+    GASSERT(fVerbs.size() > 0);
+    fPts.push_back(p1);
+    fPts.push_back(p2);
+    fPts.push_back(p3);
+    fVerbs.push_back(Verb::kCubic);
+    return *this;
+}
+
+// append the contour with the verbs [verb, stop) (the first is its move) starting at pts[0],
+// with its curves cut into lines
+static void append_lines(const GPoint* pts, const GPath::Verb* verb, const GPath::Verb* stop,
+                         float tolerance, std::vector<GPoint>* out) {
+    out->push_back(pts[0]);
+    while (++verb < stop) {
+        switch (*verb) {
+            case GPath::Verb::kQuad:  flatten_quad(pts, tolerance, out); break;
+            case GPath::Verb::kCubic: flatten_cubic(pts, tolerance, out); break;
+            default:                  out->push_back(pts[1]); break;
+        }
+        pts += point_count(*verb);
+    }
+}
+
+void GPath::flatten(float tolerance, std::vector<GPoint>* pts, std::vector<GContour>* ctrs) const {
+    const GPoint* contourPts = fPts.data();
+    const Verb* verbs = fVerbs.data();
+    const Verb* stopVerbs = verbs + fVerbs.size();
+    while (verbs < stopVerbs) {
+        GASSERT(*verbs == Verb::kMove);
+        const Verb* end = verbs;
+        int pointCount = 1;
+        while (++end < stopVerbs && *end != Verb::kMove) {
+            pointCount += point_count(*end);
+        }
+        // a move on its own is not a contour, the same as for Iter
+        if (pointCount > 1) {
+            size_t start = pts->size();
+            append_lines(contourPts, verbs, end, tolerance, pts);
+            ctrs->push_back({ (int)(pts->size() - start), nullptr, false });
+        }
+        contourPts += pointCount;
+        verbs = end;
+    }
+}
+
+GPath::Iter::Iter(const GPath& path, float tolerance) : fTolerance(tolerance) {
     if (path.fPts.size() > 0) {
         fPts = &path.fPts.front();
         fVerbs = &path.fVerbs.front();
@@ -45,14 +163,27 @@ bool GPath::Iter::next(GContour* ctr) {
 
         const GPath::Verb* verbs = fVerbs;
         GASSERT(*verbs == GPath::Verb::kMove);
-        while (++verbs < fStopVerbs && *verbs != GPath::Verb::kMove)
-            ;
-        ctr->fCount = (int)(verbs - fVerbs);
+        int pointCount = 1;
+        bool hasCurves = false;
+        while (++verbs < fStopVerbs && *verbs != GPath::Verb::kMove) {
+            pointCount += point_count(*verbs);
+            hasCurves |= (*verbs != GPath::Verb::kLine);
+        }
+
+        if (hasCurves) {
+            fStorage.clear();
+            append_lines(fPts, fVerbs, verbs, fTolerance, &fStorage);
+            outPts = fStorage.data();
+            ctr->fCount = (int)fStorage.size();
+        } else {
+            ctr->fCount = pointCount;
+        }
         // now update the iterator
         fVerbs = verbs;
-        fPts += ctr->fCount;
+        fPts += pointCount;
     } while (ctr->fCount == 1);
     ctr->fPts = outPts;
+    ctr->fClosed = false;
     return true;
 }
 
@@ -1,6 +1,8 @@
 // Copyright Daniel J. Steffey -- 2016
 
 #include "utils.hpp"
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 
 GPixel convert_color_to_pixel(const GColor& color)
@@ -13,6 +15,25 @@ GPixel convert_color_to_pixel(const GColor& color)
 	return GPixel_PackARGB(a, r, g, b);
 }
 
+bool is_valid_bitmap(const GBitmap& bitmap)
+{
+	// sizes cannot be negative, and the rows have to fit their pixels
+	if (bitmap.width() < 0 || bitmap.height() < 0)
+	{
+		return false;
+	}
+	if (bitmap.pixels() == NULL)
+	{
+		return false;
+	}
+	// width is known not to be negative by now, so it widens to rowBytes' size_t safely
+	if (bitmap.rowBytes() < 4 * (size_t)bitmap.width())
+	{
+		return false;
+	}
+	return true;
+}
+
 #include <iostream>
 std::string convert_point_to_string(const GPoint& p, const std::string name)
 {
@@ -184,3 +205,11 @@ unsigned int divide_by_255(unsigned int p)
 	// and getting to use a shift instead of divide
 	return (p * 65793 + (1 << 23)) >> 24;
 }
+
+float max_scale(const GMatrix& matrix)
+{
+	float a = matrix[GMatrix::SX], b = matrix[GMatrix::KX], c = matrix[GMatrix::KY], d = matrix[GMatrix::SY];
+	float sum = a * a + b * b + c * c + d * d;
+	float det = a * d - b * c;
+	return std::sqrt((sum + std::sqrt(std::max(sum * sum - 4 * det * det, 0.0f))) / 2);
+}
@@ -15,6 +15,8 @@
 
 GPixel convert_color_to_pixel(const GColor& color);
 
+bool is_valid_bitmap(const GBitmap& bitmap);
+
 std::string convert_point_to_string(const GPoint& p, const std::string name);
 
 std::string convert_matrix_to_string(const GMatrix& matrix, const std::string name);
@@ -43,4 +45,7 @@ void blend_opaque(const GPixel& source, GPixel* dest, int count);
 void blend(const GPixel* source, GPixel* dest, int count);	
 unsigned int divide_by_255(unsigned int p);
 
+// how far the matrix stretches a unit vector at most (the larger singular value of its 2x2 part)
+float max_scale(const GMatrix& matrix);
+
 #endif